@@ -0,0 +1,305 @@
+#!/usr/bin/env python3
+#
+# Created by pyq on 10/19/26.
+#
+# Idle connection scaling harness, see README.md.
+# Starts slim-regress-server, grows the number of idle keep-alive connections step by step from many
+# loopback source addresses and, at every step, measures the server RSS and an open loop active load
+# run by slim-load-gen, together with the event loop and timer histograms scraped from /metrics.
+
+import argparse
+import errno
+import json
+import os
+import re
+import resource
+import shlex
+import shutil
+import socket
+import subprocess
+import sys
+import tempfile
+import time
+import urllib.request
+
+ROOT = os.path.dirname(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+SERVER = os.path.join(ROOT, "slim-regress-server")
+LOAD_GEN = os.path.join(ROOT, "slim-load-gen")
+IP_BIND_ADDRESS_NO_PORT = getattr(socket, "IP_BIND_ADDRESS_NO_PORT", 24)
+
+# histograms scraped before and after the active load, name -> (metric, label selector)
+HISTOGRAMS = {
+    "loop_wait": ("slim_event_loop_seconds", 'phase="wait"'),
+    "loop_dispatch": ("slim_event_loop_seconds", 'phase="dispatch"'),
+    "timer_tick": ("slim_timer_tick_seconds", ""),
+}
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description="Idle connection scaling harness.")
+    parser.add_argument("--steps", default="10000,25000,50000,100000,200000", help="idle connection counts")
+    parser.add_argument("--threads", type=int, default=4, help="server threads (default 4)")
+    parser.add_argument("--trig", type=int, default=3, help="server trigMode (default 3)")
+    parser.add_argument("--idle-timeout", type=int, default=600000,
+                        help="server connection timeout in ms, long enough for no idle connection to expire (default 600000)")
+    parser.add_argument("--per-source", type=int, default=20000, help="idle connections per source address 127.0.0.x (default 20000)")
+    parser.add_argument("--batch", type=int, default=4,
+                        help="connects in flight while opening, kept below the listen backlog of 6 (default 4)")
+    parser.add_argument("--bare", action="store_true", help="idle connections send no request before going idle")
+    parser.add_argument("--path", default="/index.html", help="path of the idle and the active requests")
+    parser.add_argument("--rate", type=int, default=1000, help="active load in requests/s (default 1000)")
+    parser.add_argument("--connections", type=int, default=16, help="active load connections (default 16)")
+    parser.add_argument("--duration", type=int, default=5, help="active load seconds per step (default 5)")
+    parser.add_argument("--settle", type=float, default=2.0, help="seconds to wait after opening a step (default 2)")
+    parser.add_argument("--out", default="c100k-result.json", help="result file (default c100k-result.json)")
+    parser.add_argument("--no-build", action="store_true", help="use the binaries already built")
+    parser.add_argument("--make-arg", action="append", default=[], help="extra argument for make, repeatable")
+    return parser.parse_args()
+
+
+def build(make_args):
+    cmd = ["make", "-j%d" % (os.cpu_count() or 2), "slim-regress-server", "slim-load-gen"] + make_args
+    print("$ " + " ".join(shlex.quote(c) for c in cmd), flush=True)
+    subprocess.check_call(cmd, cwd=ROOT, stdout=subprocess.DEVNULL)
+
+
+def free_port():
+    with socket.socket() as sock:
+        sock.bind(("127.0.0.1", 0))
+        return sock.getsockname()[1]
+
+
+def wait_ready(port, proc, timeout=10.0):
+    deadline = time.time() + timeout
+    while time.time() < deadline:
+        if proc.poll() is not None:
+            return False
+        try:
+            socket.create_connection(("127.0.0.1", port), timeout=0.2).close()
+            return True
+        except OSError:
+            time.sleep(0.05)
+    return False
+
+
+def rss_kb(pid):
+    with open("/proc/%d/status" % pid) as f:
+        for line in f:
+            if line.startswith("VmRSS:"):
+                return int(line.split()[1])
+    return 0
+
+
+def scrape(port):
+    with urllib.request.urlopen("http://127.0.0.1:%d/metrics" % port, timeout=10) as reply:
+        text = reply.read().decode()
+    samples = {}
+    for line in text.splitlines():
+        if line and not line.startswith("#"):
+            key, value = line.rsplit(" ", 1)
+            samples[key] = float(value)
+    return samples
+
+
+def histogram(samples, metric, selector):
+    # cumulative (le, count) pairs, the sum and the count of one histogram
+    prefix = "{" + selector + "," if selector else "{"
+    buckets = []
+    for key, value in samples.items():
+        if key.startswith(metric + "_bucket" + prefix):
+            le = re.search(r'le="([^"]+)"', key).group(1)
+            buckets.append((float("inf") if le == "+Inf" else float(le), value))
+    labels = "{" + selector + "}" if selector else ""
+    return sorted(buckets), samples.get(metric + "_sum" + labels, 0), samples.get(metric + "_count" + labels, 0)
+
+
+def summarize(before, after, metric, selector):
+    # percentiles are the upper bounds of the log-linear buckets, the mean is exact
+    b_buckets, b_sum, b_count = histogram(before, metric, selector)
+    a_buckets, a_sum, a_count = histogram(after, metric, selector)
+    base = dict(b_buckets)
+    count = a_count - b_count
+    result = {"count": int(count), "mean_us": round((a_sum - b_sum) / count * 1e6, 3) if count else 0}
+    for name, p in (("p50_us", 0.5), ("p99_us", 0.99), ("p999_us", 0.999)):
+        result[name] = 0
+        for le, cum in a_buckets:
+            if count and cum - base.get(le, 0) >= p * count:
+                result[name] = round(le * 1e6, 3) if le != float("inf") else -1
+                break
+    return result
+
+
+def read_response(sock):
+    data = b""
+    while b"\r\n\r\n" not in data:
+        chunk = sock.recv(65536)
+        if not chunk:
+            return False
+        data += chunk
+    head, body = data.split(b"\r\n\r\n", 1)
+    if not head.startswith(b"HTTP/1.1 200"):
+        return False
+    match = re.search(rb"content-length:\s*(\d+)", head, re.I)
+    need = int(match.group(1)) if match else 0
+    while len(body) < need:
+        chunk = sock.recv(65536)
+        if not chunk:
+            return False
+        body += chunk
+    return True
+
+
+def open_idle(conns, target, port, args, stats):
+    # connections are opened in small batches, every batch sends its requests before reading the responses.
+    # Larger batches overflow the accept queue and the dropped handshakes stall for seconds in retransmits.
+    request = ("GET %s HTTP/1.1\r\nHost: 127.0.0.1:%d\r\nConnection: keep-alive\r\n\r\n" % (args.path, port)).encode()
+    while len(conns) < target:
+        batch = []
+        for _ in range(min(args.batch, target - len(conns))):
+            index = len(conns) + len(batch)
+            source = "127.0.%d.%d" % (index // args.per_source // 254, index // args.per_source % 254 + 2)
+            if index >= stats["fd_limit"]:
+                stats["stop"] = "RLIMIT_NOFILE after %d connections" % index
+                break
+            sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+            try:
+                # the source port is picked at connect time per 4-tuple, so every address gives a full port range
+                sock.setsockopt(socket.IPPROTO_IP, IP_BIND_ADDRESS_NO_PORT, 1)
+                sock.bind((source, 0))
+                sock.settimeout(10)
+                sock.connect(("127.0.0.1", port))
+                if not args.bare:
+                    sock.sendall(request)
+            except OSError as e:
+                sock.close()
+                stats["stop"] = "%s after %d connections" % (errno.errorcode.get(e.errno, str(e)), len(conns) + len(batch))
+                break
+            batch.append(sock)
+        accepted = 0
+        for sock in batch:
+            try:
+                ok = args.bare or read_response(sock)
+            except OSError:
+                ok = False
+            if ok:
+                conns.append(sock)
+                accepted += 1
+            else:
+                # the server refuses connections above MAX_FD with "Server busy!"
+                stats["refused"] += 1
+                sock.close()
+        if args.bare:
+            # without a response to wait for, give the server a moment to accept the batch
+            time.sleep(0.001)
+        if batch and not accepted:
+            stats.setdefault("stop", "server refused a whole batch after %d connections" % len(conns))
+        if "stop" in stats:
+            return
+
+
+def run_step(args, port, server, conns, target, base_rss, stats, workdir):
+    start = time.time()
+    open_idle(conns, target, port, args, stats)
+    open_sec = time.time() - start
+    time.sleep(args.settle)
+    rss = rss_kb(server.pid)
+
+    before = scrape(port)
+    out = os.path.join(workdir, "load.json")
+    cmd = [LOAD_GEN, "-t", "1", "-c", str(args.connections), "-d", str(args.duration), "-R", str(args.rate),
+           "-j", out, "http://127.0.0.1:%d%s" % (port, args.path)]
+    subprocess.check_call(cmd, stdout=subprocess.DEVNULL)
+    # the server reuses a rendered scrape for 1s
+    time.sleep(1.1)
+    after = scrape(port)
+    with open(out) as f:
+        load = json.load(f)
+
+    idle = len(conns)
+    step = {
+        "target": target,
+        "idle": idle,
+        "server_connections": int(after.get("slim_http_connections", 0)),
+        "refused": stats["refused"],
+        "open_sec": round(open_sec, 1),
+        "rss_kb": rss,
+        "rss_per_conn_bytes": round((rss - base_rss) * 1024.0 / idle) if idle else 0,
+        "active_rps": load["rps"],
+        "active_p50_us": load["latency_us"]["p50"],
+        "active_p99_us": load["latency_us"]["p99"],
+        "active_p999_us": load["latency_us"]["p999"],
+        "active_errors": sum(load["errors"].values()),
+    }
+    for name, (metric, selector) in HISTOGRAMS.items():
+        step[name] = summarize(before, after, metric, selector)
+    return step
+
+
+def main():
+    args = parse_args()
+    steps = [int(s) for s in args.steps.split(",")]
+    # the server inherits the limit, every idle connection costs a descriptor on both sides
+    soft, hard = resource.getrlimit(resource.RLIMIT_NOFILE)
+    resource.setrlimit(resource.RLIMIT_NOFILE, (hard, hard))
+    if hard < max(steps) + 1024:
+        print("warning: RLIMIT_NOFILE is %d, raise it (ulimit -Hn, fs.nr_open) to reach %d connections"
+              % (hard, max(steps)), flush=True)
+    if not args.no_build:
+        build(args.make_arg)
+
+    workdir = tempfile.mkdtemp(prefix="slim-c100k-")
+    os.symlink(os.path.join(ROOT, "resources"), os.path.join(workdir, "resources"))
+    port = free_port()
+    server = subprocess.Popen([SERVER, str(port), str(args.trig), str(args.threads), str(args.idle_timeout)],
+                              cwd=workdir, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    conns = []
+    results = []
+    # a few descriptors stay free for the scrapes
+    stats = {"refused": 0, "fd_limit": hard - 64}
+    try:
+        if not wait_ready(port, server):
+            raise RuntimeError("server did not start on port %d" % port)
+        # the baseline RSS includes a served request, so buffers and the mapped file are counted once
+        scrape(port)
+        base_rss = rss_kb(server.pid)
+        print("server pid %d on port %d, base RSS %d KB" % (server.pid, port, base_rss), flush=True)
+        print("%8s %8s %9s %10s %12s %12s %14s %12s %12s %10s" % (
+            "idle", "rss_MB", "B/conn", "wait_p99", "dispatch_p99", "tick_mean", "tick_p99", "active_p50",
+            "active_p99", "rps"), flush=True)
+        for target in steps:
+            step = run_step(args, port, server, conns, target, base_rss, stats, workdir)
+            results.append(step)
+            print("%8d %8.1f %9d %8.0fus %10.0fus %10.3fus %12.0fus %10.0fus %10.0fus %10.1f" % (
+                step["idle"], step["rss_kb"] / 1024.0, step["rss_per_conn_bytes"], step["loop_wait"]["p99_us"],
+                step["loop_dispatch"]["p99_us"], step["timer_tick"]["mean_us"], step["timer_tick"]["p99_us"],
+                step["active_p50_us"], step["active_p99_us"], step["active_rps"]), flush=True)
+            if "stop" in stats or step["idle"] < target:
+                print("stopped below %d idle connections: %s, %d refused by the server"
+                      % (target, stats.get("stop", "server limit"), stats["refused"]), flush=True)
+                break
+    finally:
+        for sock in conns:
+            sock.close()
+        server.terminate()
+        server.wait()
+        shutil.rmtree(workdir, ignore_errors=True)
+
+    meta = {
+        "threads": args.threads,
+        "trig": args.trig,
+        "bare": args.bare,
+        "rate": args.rate,
+        "connections": args.connections,
+        "duration": args.duration,
+        "cpus": os.cpu_count(),
+        "host": socket.gethostname(),
+        "time": time.strftime("%Y-%m-%dT%H:%M:%S"),
+    }
+    with open(args.out, "w") as f:
+        json.dump({"meta": meta, "steps": results}, f, indent=2, sort_keys=True)
+    print("\nresults written to %s" % args.out)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
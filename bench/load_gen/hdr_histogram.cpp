@@ -0,0 +1,89 @@
+//
+// Created by pyq on 10/19/26.
+//
+#include "hdr_histogram.h"
+#include <cmath>
+#include <algorithm>
+
+HdrHistogram::HdrHistogram() : counts_(BUCKET_NUM, 0), count_(0), min_(UINT64_MAX), max_(0), sum_(0), sumSquare_(0) {}
+
+void HdrHistogram::Record(uint64_t value) {
+    value = std::min(value, MAX_VALUE);
+    ++counts_[Index_(value)];
+    ++count_;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+    sum_ += value;
+    sumSquare_ += (double)value * value;
+}
+
+void HdrHistogram::Merge(const HdrHistogram& other) {
+    for (int i = 0; i < BUCKET_NUM; ++i) {
+        counts_[i] += other.counts_[i];
+    }
+    count_ += other.count_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+    sum_ += other.sum_;
+    sumSquare_ += other.sumSquare_;
+}
+
+uint64_t HdrHistogram::Percentile(double percentile) const {
+    if (count_ == 0) {
+        return 0;
+    }
+    // rank of the value, at least the first one
+    uint64_t rank = std::max<uint64_t>(1, (uint64_t)std::ceil(percentile / 100.0 * count_));
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKET_NUM; ++i) {
+        seen += counts_[i];
+        if (seen >= rank) {
+            return std::min(Upper_(i), max_);
+        }
+    }
+    return max_;
+}
+
+uint64_t HdrHistogram::Count() const {
+    return count_;
+}
+
+uint64_t HdrHistogram::Min() const {
+    return count_ ? min_ : 0;
+}
+
+uint64_t HdrHistogram::Max() const {
+    return max_;
+}
+
+double HdrHistogram::Mean() const {
+    return count_ ? sum_ / count_ : 0;
+}
+
+double HdrHistogram::Stdev() const {
+    if (count_ < 2) {
+        return 0;
+    }
+    double mean = Mean();
+    return std::sqrt(std::max(0.0, sumSquare_ / count_ - mean * mean));
+}
+
+int HdrHistogram::Index_(uint64_t value) {
+    if (value < (1ULL << SUB_BITS)) {
+        return value;
+    }
+    int power = 63 - __builtin_clzll(value);
+    // the top SUB_BITS bits of the value select the linear bucket inside its power of two
+    int shift = power - (SUB_BITS - 1);
+    return (1 << SUB_BITS) + (power - SUB_BITS) * HALF_COUNT + (int)((value >> shift) - HALF_COUNT);
+}
+
+uint64_t HdrHistogram::Upper_(int index) {
+    if (index < (1 << SUB_BITS)) {
+        return index;
+    }
+    int power = (index - (1 << SUB_BITS)) / HALF_COUNT + SUB_BITS;
+    uint64_t sub = (index - (1 << SUB_BITS)) % HALF_COUNT + HALF_COUNT;
+    int shift = power - (SUB_BITS - 1);
+    return ((sub + 1) << shift) - 1;
+}
@@ -0,0 +1,64 @@
+//
+// Created by pyq on 10/19/26.
+//
+#pragma once
+#ifndef SLIM_WEB_SERVER_HDR_HISTOGRAM_H
+#define SLIM_WEB_SERVER_HDR_HISTOGRAM_H
+
+#include <vector>
+#include <cstdint>
+
+// High dynamic range histogram of latencies in nanoseconds.
+// Values below 2048ns get a bucket each, every following power of two is split into 1024 linear
+// buckets, so any recorded value is reported with a relative error below 0.1% up to MAX_VALUE.
+class HdrHistogram {
+public:
+    static const int SUB_BITS = 11;                                 // 2^SUB_BITS exact buckets at the bottom.
+    static const int MAX_POWER = 38;                                // Largest tracked power of two, 2^38ns is about 275s.
+    static const uint64_t MAX_VALUE = (1ULL << MAX_POWER) - 1;      // Larger values are clamped.
+
+    HdrHistogram();
+
+    // Records a value, values above MAX_VALUE are clamped.
+    void Record(uint64_t value);
+
+    // Adds the counts of another histogram.
+    void Merge(const HdrHistogram& other);
+
+    // Returns the value at a percentile (0-100), the upper bound of its bucket.
+    uint64_t Percentile(double percentile) const;
+
+    // Returns the number of recorded values.
+    uint64_t Count() const;
+
+    // Returns the smallest recorded value, 0 if empty.
+    uint64_t Min() const;
+
+    // Returns the largest recorded value.
+    uint64_t Max() const;
+
+    // Returns the mean of the recorded values.
+    double Mean() const;
+
+    // Returns the standard deviation of the recorded values.
+    double Stdev() const;
+
+private:
+    static const int HALF_COUNT = 1 << (SUB_BITS - 1);              // Linear buckets per power of two.
+    static const int BUCKET_NUM = (1 << SUB_BITS) + (MAX_POWER - SUB_BITS) * HALF_COUNT;
+
+    std::vector<uint64_t> counts_;  // Count of every bucket.
+    uint64_t count_;                // Number of recorded values.
+    uint64_t min_;                  // Smallest recorded value.
+    uint64_t max_;                  // Largest recorded value.
+    double sum_;                    // Sum of the recorded values.
+    double sumSquare_;              // Sum of the squared recorded values.
+
+    // Returns the bucket of a value.
+    static int Index_(uint64_t value);
+
+    // Returns the largest value of a bucket.
+    static uint64_t Upper_(int index);
+};
+
+#endif //SLIM_WEB_SERVER_HDR_HISTOGRAM_H
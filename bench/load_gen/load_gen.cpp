@@ -0,0 +1,548 @@
+//
+// Created by pyq on 10/19/26.
+//
+#include "load_gen.h"
+#include <ctime>
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+#include <thread>
+#include <algorithm>
+#include <netdb.h>
+#include <unistd.h>
+#include <strings.h>
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/tcp.h>
+
+ResponseParser::ResponseParser() {
+    Reset();
+}
+
+void ResponseParser::Reset() {
+    state_ = HEADER;
+    line_.clear();
+    remain_ = 0;
+    code_ = 0;
+    keepAlive_ = false;
+}
+
+long ResponseParser::Feed(const char* data, size_t len, bool* done) {
+    *done = false;
+    switch (state_) {
+        case HEADER: {
+            // the terminator may straddle two reads, search from the last 3 bytes already held
+            size_t from = line_.size() < 3 ? 0 : line_.size() - 3;
+            line_.append(data, len);
+            size_t pos = line_.find("\r\n\r\n", from);
+            if (pos == std::string::npos) {
+                return line_.size() > MAX_HEADER ? -1 : (long)len;
+            }
+            size_t excess = line_.size() - (pos + 4);
+            line_.resize(pos + 4);
+            if (!ParseHeader_()) {
+                return -1;
+            }
+            line_.clear();
+            *done = (state_ == BODY && remain_ == 0);
+            return len - excess;
+        }
+        case BODY:
+        case CHUNK_DATA:
+        case CHUNK_CRLF: {
+            uint64_t take = std::min<uint64_t>(remain_, len);
+            remain_ -= take;
+            if (remain_ == 0) {
+                if (state_ == BODY) {
+                    *done = true;
+                } else if (state_ == CHUNK_DATA) {
+                    state_ = CHUNK_CRLF;
+                    remain_ = 2;
+                } else {
+                    state_ = CHUNK_SIZE;
+                }
+            }
+            return take;
+        }
+        case CHUNK_SIZE:
+        case TRAILER: {
+            const char* end = (const char*)memchr(data, '\n', len);
+            size_t take = end ? end - data + 1 : len;
+            line_.append(data, take);
+            if (line_.size() > MAX_HEADER) {
+                return -1;
+            }
+            if (!end) {
+                return take;
+            }
+            if (state_ == CHUNK_SIZE) {
+                // chunk extensions after ';' are ignored
+                char* hexEnd = nullptr;
+                remain_ = strtoull(line_.c_str(), &hexEnd, 16);
+                if (hexEnd == line_.c_str()) {
+                    return -1;
+                }
+                state_ = remain_ ? CHUNK_DATA : TRAILER;
+            } else if (line_ == "\r\n" || line_ == "\n") {
+                *done = true;
+            }
+            line_.clear();
+            return take;
+        }
+        case UNTIL_CLOSE:
+            return len;
+    }
+    return -1;
+}
+
+bool ResponseParser::Eof() {
+    return state_ == UNTIL_CLOSE;
+}
+
+int ResponseParser::Code() const {
+    return code_;
+}
+
+bool ResponseParser::KeepAlive() const {
+    return keepAlive_;
+}
+
+bool ResponseParser::ParseHeader_() {
+    // HTTP/1.1 200 OK
+    if (line_.compare(0, 5, "HTTP/") != 0 || line_.size() < 12) {
+        return false;
+    }
+    code_ = atoi(line_.c_str() + 9);
+    keepAlive_ = line_.compare(5, 3, "1.1") == 0;
+
+    bool chunked = false, hasLength = false;
+    uint64_t length = 0;
+    size_t begin = line_.find("\r\n") + 2;
+    while (begin < line_.size()) {
+        size_t end = line_.find("\r\n", begin);
+        size_t colon = line_.find(':', begin);
+        if (end == begin || end == std::string::npos) {
+            break;
+        }
+        if (colon != std::string::npos && colon < end) {
+            std::string name = line_.substr(begin, colon - begin);
+            size_t valueBegin = line_.find_first_not_of(' ', colon + 1);
+            std::string value = line_.substr(valueBegin, end - valueBegin);
+            if (strcasecmp(name.c_str(), "Content-Length") == 0) {
+                hasLength = true;
+                length = strtoull(value.c_str(), nullptr, 10);
+            } else if (strcasecmp(name.c_str(), "Transfer-Encoding") == 0) {
+                chunked = strcasestr(value.c_str(), "chunked") != nullptr;
+            } else if (strcasecmp(name.c_str(), "Connection") == 0) {
+                if (strcasecmp(value.c_str(), "close") == 0) {
+                    keepAlive_ = false;
+                } else if (strcasecmp(value.c_str(), "keep-alive") == 0) {
+                    keepAlive_ = true;
+                }
+            }
+        }
+        begin = end + 2;
+    }
+
+    if ((code_ >= 100 && code_ < 200) || code_ == 204 || code_ == 304) {
+        state_ = BODY;
+        remain_ = 0;
+    } else if (chunked) {
+        state_ = CHUNK_SIZE;
+    } else if (hasLength) {
+        state_ = BODY;
+        remain_ = length;
+    } else {
+        state_ = UNTIL_CLOSE;
+        keepAlive_ = false;
+    }
+    return true;
+}
+
+LoadGen::LoadGen(const Config& config) : config_(config), totalWeight_(0), measureStart_(0), measureEnd_(0) {
+    memset(&addr_, 0, sizeof(addr_));
+    for (auto& request : config_.requests) {
+        totalWeight_ += request.weight;
+    }
+    if (!config_.keepAlive) {
+        // without keep-alive a connection carries exactly one request
+        config_.pipeline = 1;
+    }
+}
+
+uint64_t LoadGen::NowNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+bool LoadGen::Run(Result* result) {
+    if (!Resolve_() || totalWeight_ <= 0) {
+        return false;
+    }
+
+    measureStart_ = NowNs() + config_.warmupSec * 1000000000ULL;
+    measureEnd_ = measureStart_ + config_.durationSec * 1000000000ULL;
+
+    std::vector<Worker> workers(config_.threads);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < config_.threads; ++i) {
+        workers[i].id = i;
+        int connNum = config_.connections / config_.threads + (i < config_.connections % config_.threads ? 1 : 0);
+        threads.emplace_back(&LoadGen::Work_, this, &workers[i], connNum);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    *result = Result();
+    for (auto& worker : workers) {
+        Result& part = worker.result;
+        result->requests += part.requests;
+        result->responses += part.responses;
+        result->bytesIn += part.bytesIn;
+        result->connectErrors += part.connectErrors;
+        result->readErrors += part.readErrors;
+        result->writeErrors += part.writeErrors;
+        result->timeouts += part.timeouts;
+        result->badResponses += part.badResponses;
+        for (auto& code : part.codes) {
+            result->codes[code.first] += code.second;
+        }
+        result->latency.Merge(part.latency);
+    }
+    result->seconds = config_.durationSec;
+    return true;
+}
+
+int LoadGen::SendOnce(const Request& request) {
+    if (!Resolve_()) {
+        return -1;
+    }
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    timeval tv = {config_.timeoutMs / 1000, (config_.timeoutMs % 1000) * 1000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    if (connect(fd, (sockaddr*)&addr_, sizeof(addr_)) < 0) {
+        close(fd);
+        return -1;
+    }
+    std::string out = Render_(request, 0, false);
+    if (write(fd, out.data(), out.size()) != (ssize_t)out.size()) {
+        close(fd);
+        return -1;
+    }
+
+    ResponseParser parser;
+    char buf[16384];
+    ssize_t len;
+    bool done = false;
+    while (!done && (len = read(fd, buf, sizeof(buf))) > 0) {
+        for (ssize_t offset = 0; offset < len && !done;) {
+            long used = parser.Feed(buf + offset, len - offset, &done);
+            if (used < 0) {
+                close(fd);
+                return -1;
+            }
+            offset += used;
+        }
+    }
+    close(fd);
+    return (done || parser.Eof()) ? parser.Code() : -1;
+}
+
+void LoadGen::Work_(Worker* worker, int connNum) {
+    worker->epollFd = epoll_create1(EPOLL_CLOEXEC);
+    worker->seq = 0;
+    worker->random = 0x9E3779B97F4A7C15ULL * (worker->id + 1);
+    worker->conns.resize(connNum);
+
+    bool openLoop = config_.rate > 0;
+    // every connection sends at rate / connections, the first request is spread over one interval
+    uint64_t interval = openLoop ? (uint64_t)(1e9 * config_.connections / config_.rate) : 0;
+    uint64_t start = NowNs();
+    for (int i = 0; i < connNum; ++i) {
+        Conn& conn = worker->conns[i];
+        conn.fd = -1;
+        conn.retryAt = 0;
+        conn.nextSend = start + (openLoop ? interval * (i * config_.threads + worker->id) / config_.connections : 0);
+        Connect_(worker, &conn);
+    }
+
+    epoll_event events[256];
+    uint64_t timeoutNs = config_.timeoutMs * 1000000ULL;
+    uint64_t now = NowNs();
+    while (now < measureEnd_) {
+        for (int i = 0; i < connNum; ++i) {
+            Conn& conn = worker->conns[i];
+            if (conn.fd < 0) {
+                if (now >= conn.retryAt) {
+                    Connect_(worker, &conn);
+                }
+                continue;
+            }
+            if (conn.connecting) {
+                if (now - conn.connectAt > timeoutNs) {
+                    if (Measured_(now)) {
+                        ++worker->result.connectErrors;
+                    }
+                    Close_(worker, &conn, nullptr);
+                }
+                continue;
+            }
+            if (!conn.pending.empty() && now - conn.pending.front().sent > timeoutNs) {
+                Close_(worker, &conn, &worker->result.timeouts);
+                continue;
+            }
+            // an open loop connection that fell behind sends its backlog as soon as it can,
+            // each request keeps the time it was due so the delay is part of its latency
+            while ((int)conn.pending.size() < config_.pipeline && (!openLoop || conn.nextSend <= now)) {
+                Enqueue_(worker, &conn, openLoop ? conn.nextSend : now);
+                conn.nextSend += interval;
+            }
+            if (conn.outOffset < conn.out.size() && !Flush_(worker, &conn)) {
+                Close_(worker, &conn, &worker->result.writeErrors);
+            }
+        }
+
+        int eventCnt = epoll_wait(worker->epollFd, events, 256, openLoop ? 1 : 10);
+        now = NowNs();
+        for (int i = 0; i < eventCnt; ++i) {
+            Conn& conn = worker->conns[events[i].data.u32];
+            if (conn.fd < 0) {
+                continue;
+            }
+            if (conn.connecting) {
+                int error = 0;
+                socklen_t len = sizeof(error);
+                getsockopt(conn.fd, SOL_SOCKET, SO_ERROR, &error, &len);
+                if (error != 0 || (events[i].events & (EPOLLERR | EPOLLHUP))) {
+                    if (Measured_(now)) {
+                        ++worker->result.connectErrors;
+                    }
+                    Close_(worker, &conn, nullptr);
+                    conn.retryAt = now + 100000000ULL;
+                    continue;
+                }
+                conn.connecting = false;
+                Watch_(worker, &conn);
+                continue;
+            }
+            if ((events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) && !Receive_(worker, &conn)) {
+                continue;
+            }
+            if ((events[i].events & EPOLLOUT) && !Flush_(worker, &conn)) {
+                Close_(worker, &conn, &worker->result.writeErrors);
+            }
+        }
+    }
+
+    for (auto& conn : worker->conns) {
+        if (conn.fd >= 0) {
+            close(conn.fd);
+        }
+    }
+    close(worker->epollFd);
+}
+
+void LoadGen::Connect_(Worker* worker, Conn* conn) {
+    conn->connecting = false;
+    conn->watchOut = false;
+    conn->out.clear();
+    conn->outOffset = 0;
+    conn->pending.clear();
+    conn->parser.Reset();
+    conn->connectAt = NowNs();
+    conn->fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (conn->fd < 0) {
+        conn->retryAt = conn->connectAt + 100000000ULL;
+        return;
+    }
+    int on = 1;
+    setsockopt(conn->fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    if (connect(conn->fd, (sockaddr*)&addr_, sizeof(addr_)) < 0) {
+        if (errno != EINPROGRESS) {
+            if (Measured_(conn->connectAt)) {
+                ++worker->result.connectErrors;
+            }
+            close(conn->fd);
+            conn->fd = -1;
+            conn->retryAt = conn->connectAt + 100000000ULL;
+            return;
+        }
+        conn->connecting = true;
+    }
+    epoll_event event = {0};
+    event.events = EPOLLIN | (conn->connecting ? EPOLLOUT : 0);
+    event.data.u32 = conn - worker->conns.data();
+    conn->watchOut = conn->connecting;
+    epoll_ctl(worker->epollFd, EPOLL_CTL_ADD, conn->fd, &event);
+}
+
+void LoadGen::Close_(Worker* worker, Conn* conn, uint64_t* errorCounter) {
+    if (errorCounter && Measured_(NowNs())) {
+        *errorCounter += std::max<size_t>(1, conn->pending.size());
+    }
+    epoll_ctl(worker->epollFd, EPOLL_CTL_DEL, conn->fd, nullptr);
+    close(conn->fd);
+    conn->fd = -1;
+    conn->retryAt = 0;
+    conn->pending.clear();
+}
+
+void LoadGen::Enqueue_(Worker* worker, Conn* conn, uint64_t intended) {
+    // xorshift64, weighted pick of the next request of the mix
+    uint64_t& x = worker->random;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    int pick = x % totalWeight_;
+    const Request* request = &config_.requests[0];
+    for (auto& item : config_.requests) {
+        if (pick < item.weight) {
+            request = &item;
+            break;
+        }
+        pick -= item.weight;
+    }
+
+    if (conn->outOffset == conn->out.size()) {
+        conn->out.clear();
+        conn->outOffset = 0;
+    }
+    uint64_t seq = ((uint64_t)worker->id << 40) | worker->seq++;
+    conn->out += Render_(*request, seq, config_.keepAlive);
+    uint64_t now = NowNs();
+    conn->pending.push_back({intended, now});
+    if (Measured_(now)) {
+        ++worker->result.requests;
+    }
+}
+
+bool LoadGen::Flush_(Worker* worker, Conn* conn) {
+    while (conn->outOffset < conn->out.size()) {
+        ssize_t len = write(conn->fd, conn->out.data() + conn->outOffset, conn->out.size() - conn->outOffset);
+        if (len < 0) {
+            if (errno == EAGAIN) {
+                break;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        conn->outOffset += len;
+    }
+    Watch_(worker, conn);
+    return true;
+}
+
+bool LoadGen::Receive_(Worker* worker, Conn* conn) {
+    char buf[65536];
+    while (true) {
+        ssize_t len = read(conn->fd, buf, sizeof(buf));
+        uint64_t now = NowNs();
+        if (len < 0 && errno == EINTR) {
+            continue;
+        }
+        if (len < 0 && errno == EAGAIN) {
+            return true;
+        }
+        if (len <= 0) {
+            // a response delimited by the end of the connection is complete now
+            if (len == 0 && conn->parser.Eof() && !conn->pending.empty()) {
+                Complete_(worker, conn, now);
+            }
+            Close_(worker, conn, conn->pending.empty() ? nullptr : &worker->result.readErrors);
+            return false;
+        }
+        if (Measured_(now)) {
+            worker->result.bytesIn += len;
+        }
+        for (ssize_t offset = 0; offset < len;) {
+            bool done = false;
+            long used = conn->parser.Feed(buf + offset, len - offset, &done);
+            if (used < 0 || conn->pending.empty()) {
+                // garbage or a response nobody asked for
+                if (Measured_(now)) {
+                    ++worker->result.badResponses;
+                }
+                Close_(worker, conn, nullptr);
+                return false;
+            }
+            offset += used;
+            if (done && !Complete_(worker, conn, now)) {
+                Close_(worker, conn, conn->pending.empty() ? nullptr : &worker->result.readErrors);
+                return false;
+            }
+        }
+    }
+}
+
+bool LoadGen::Complete_(Worker* worker, Conn* conn, uint64_t now) {
+    Pending pending = conn->pending.front();
+    conn->pending.pop_front();
+    if (Measured_(now)) {
+        Result& result = worker->result;
+        ++result.responses;
+        ++result.codes[conn->parser.Code()];
+        result.latency.Record(now - pending.intended);
+    }
+    bool keepAlive = config_.keepAlive && conn->parser.KeepAlive();
+    conn->parser.Reset();
+    return keepAlive;
+}
+
+void LoadGen::Watch_(Worker* worker, Conn* conn) {
+    bool watchOut = conn->connecting || conn->outOffset < conn->out.size();
+    if (watchOut == conn->watchOut) {
+        return;
+    }
+    epoll_event event = {0};
+    event.events = EPOLLIN | (watchOut ? EPOLLOUT : 0);
+    event.data.u32 = conn - worker->conns.data();
+    epoll_ctl(worker->epollFd, EPOLL_CTL_MOD, conn->fd, &event);
+    conn->watchOut = watchOut;
+}
+
+std::string LoadGen::Render_(const Request& request, uint64_t seq, bool keepAlive) const {
+    std::string path = request.path, body = request.body, number = std::to_string(seq);
+    for (std::string* text : {&path, &body}) {
+        size_t pos;
+        while ((pos = text->find("{seq}")) != std::string::npos) {
+            text->replace(pos, 5, number);
+        }
+    }
+    std::string out = request.method + " " + path + " HTTP/1.1\r\nHost: " + config_.host + ":" + std::to_string(config_.port) + "\r\n";
+    out += keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+    if (!body.empty() || request.method == "POST") {
+        out += "Content-Type: application/x-www-form-urlencoded\r\nContent-Length: " + std::to_string(body.size()) + "\r\n";
+    }
+    out += "\r\n";
+    out += body;
+    return out;
+}
+
+bool LoadGen::Resolve_() {
+    if (addr_.sin_port != 0) {
+        return true;
+    }
+    addrinfo hints, *info = nullptr;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(config_.host.c_str(), nullptr, &hints, &info) != 0 || !info) {
+        return false;
+    }
+    addr_ = *(sockaddr_in*)info->ai_addr;
+    addr_.sin_port = htons(config_.port);
+    freeaddrinfo(info);
+    return true;
+}
+
+bool LoadGen::Measured_(uint64_t now) const {
+    return now >= measureStart_ && now < measureEnd_;
+}
@@ -0,0 +1,189 @@
+//
+// Created by pyq on 10/19/26.
+//
+#pragma once
+#ifndef SLIM_WEB_SERVER_LOAD_GEN_H
+#define SLIM_WEB_SERVER_LOAD_GEN_H
+
+#include <map>
+#include <deque>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <netinet/in.h>
+#include "hdr_histogram.h"
+
+// Incremental parser of HTTP/1.1 responses, the body is counted but not stored.
+// Bodies are delimited by Content-Length, chunked transfer encoding or the end of the connection.
+class ResponseParser {
+public:
+    ResponseParser();
+
+    // Prepares for the next response on the connection.
+    void Reset();
+
+    // Consumes bytes of the response and returns how many were used, done is set when the response is complete.
+    // Returns -1 on a malformed response.
+    long Feed(const char* data, size_t len, bool* done);
+
+    // Completes a response delimited by the end of the connection, returns false if one was cut short.
+    bool Eof();
+
+    // Returns the status code of the response.
+    int Code() const;
+
+    // Returns true if the server keeps the connection open after this response.
+    bool KeepAlive() const;
+
+private:
+    // Enumerates the parser states.
+    enum STATE {
+        HEADER = 0,
+        BODY,
+        CHUNK_SIZE,
+        CHUNK_DATA,
+        CHUNK_CRLF,
+        TRAILER,
+        UNTIL_CLOSE,
+    };
+
+    static const size_t MAX_HEADER = 65536;     // Longest accepted header block or chunk line.
+
+    STATE state_;           // Current state.
+    std::string line_;      // Header block or chunk line received so far.
+    uint64_t remain_;       // Body or chunk bytes still expected.
+    int code_;              // Status code.
+    bool keepAlive_;        // Connection reuse announced by the server.
+
+    // Parses the status line and headers in line_, returns false if malformed.
+    bool ParseHeader_();
+};
+
+// Multi-threaded epoll HTTP/1.1 load generator.
+// Closed loop: every connection keeps pipeline requests in flight.
+// Open loop: requests are scheduled at a constant total rate and latency is measured from the
+// time a request was due rather than from the time it was sent, so a stalled server is charged
+// for the requests it delayed (coordinated omission correction, as in wrk2).
+class LoadGen {
+public:
+    // A request of the URL mix, "{seq}" in the path or body is replaced by a unique number.
+    struct Request {
+        int weight;
+        std::string method;
+        std::string path;
+        std::string body;
+    };
+
+    // Run configuration.
+    struct Config {
+        std::string host;               // Server address, IPv4 or a host name.
+        int port;                       // Server port.
+        int threads;                    // Worker threads, each with its own epoll.
+        int connections;                // Total connections, spread over the threads.
+        int durationSec;                // Length of the measurement.
+        int warmupSec;                  // Length of the unmeasured warmup before it.
+        int pipeline;                   // Requests in flight per connection.
+        double rate;                    // Total requests per second, 0 means closed loop.
+        bool keepAlive;                 // Reuse connections, otherwise one request per connection.
+        int timeoutMs;                  // A response slower than this counts as a timeout and closes the connection.
+        std::vector<Request> requests;  // URL mix.
+    };
+
+    // Results of a run, summed over the threads.
+    struct Result {
+        uint64_t requests;              // Requests sent during the measurement.
+        uint64_t responses;             // Responses completed during the measurement.
+        uint64_t bytesIn;               // Bytes received during the measurement.
+        uint64_t connectErrors;         // Failed connects.
+        uint64_t readErrors;            // Connections reset or closed with requests in flight.
+        uint64_t writeErrors;           // Failed writes.
+        uint64_t timeouts;              // Responses slower than timeoutMs.
+        uint64_t badResponses;          // Malformed responses.
+        double seconds;                 // Actual length of the measurement.
+        std::map<int, uint64_t> codes;  // Responses by status code.
+        HdrHistogram latency;           // Latency in nanoseconds.
+    };
+
+    explicit LoadGen(const Config& config);
+
+    // Runs the warmup and the measurement, returns false if the address can not be resolved or the mix is empty.
+    bool Run(Result* result);
+
+    // Sends one request on a blocking connection and returns its status code, or -1 on error.
+    int SendOnce(const Request& request);
+
+    // Returns the current monotonic time in nanoseconds.
+    static uint64_t NowNs();
+
+private:
+    // A request in flight.
+    struct Pending {
+        uint64_t intended;      // Time the request was due (open loop) or sent (closed loop).
+        uint64_t sent;          // Time the request was written to the socket buffer.
+    };
+
+    // State of one client connection.
+    struct Conn {
+        int fd;                         // Socket, -1 while not connected.
+        bool connecting;                // Non blocking connect in progress.
+        bool watchOut;                  // EPOLLOUT is part of the epoll interest.
+        uint64_t connectAt;             // Time the connect started.
+        uint64_t retryAt;               // Earliest time of the next connect after a failed one.
+        uint64_t nextSend;              // Next due time in open loop mode.
+        std::string out;                // Bytes not yet written.
+        size_t outOffset;               // Bytes of out already written.
+        std::deque<Pending> pending;    // Requests in flight, oldest first.
+        ResponseParser parser;          // Parser of the current response.
+    };
+
+    // Counters and histogram of one worker thread.
+    struct Worker {
+        int id;                     // Index of the thread.
+        int epollFd;                // Epoll of the thread's connections.
+        uint64_t seq;               // Counter behind "{seq}".
+        uint64_t random;            // State of the xorshift generator picking requests of the mix.
+        std::vector<Conn> conns;    // Connections of the thread.
+        Result result;              // Results of the thread.
+    };
+
+    Config config_;             // Run configuration.
+    sockaddr_in addr_;          // Resolved server address.
+    int totalWeight_;           // Sum of the request weights.
+    uint64_t measureStart_;     // Start of the measurement, warmup results are dropped.
+    uint64_t measureEnd_;       // End of the run.
+
+    // Body of a worker thread.
+    void Work_(Worker* worker, int connNum);
+
+    // Starts a non blocking connect.
+    void Connect_(Worker* worker, Conn* conn);
+
+    // Closes a connection, the requests in flight are added to errorCounter unless it is nullptr.
+    void Close_(Worker* worker, Conn* conn, uint64_t* errorCounter);
+
+    // Queues the next request of the mix, due at intended.
+    void Enqueue_(Worker* worker, Conn* conn, uint64_t intended);
+
+    // Writes as much of the queued output as the socket takes, returns false on error.
+    bool Flush_(Worker* worker, Conn* conn);
+
+    // Reads and parses responses, returns false if the connection was closed.
+    bool Receive_(Worker* worker, Conn* conn);
+
+    // Finishes the oldest request in flight, returns false if the connection has to be closed.
+    bool Complete_(Worker* worker, Conn* conn, uint64_t now);
+
+    // Adds EPOLLOUT to the epoll interest of a connection while it has output or is connecting.
+    void Watch_(Worker* worker, Conn* conn);
+
+    // Renders a request of the mix.
+    std::string Render_(const Request& request, uint64_t seq, bool keepAlive) const;
+
+    // Resolves the server address once, returns false if it can not be resolved.
+    bool Resolve_();
+
+    // Returns true if a time falls into the measurement.
+    bool Measured_(uint64_t now) const;
+};
+
+#endif //SLIM_WEB_SERVER_LOAD_GEN_H
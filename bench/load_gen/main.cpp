@@ -0,0 +1,234 @@
+//
+// Created by pyq on 10/19/26.
+//
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <getopt.h>
+#include "load_gen.h"
+
+namespace {
+
+const double PERCENTILES[] = {50, 75, 90, 99, 99.9, 99.99};
+const char* PERCENTILE_KEYS[] = {"p50", "p75", "p90", "p99", "p999", "p9999"};
+
+void Usage() {
+    fprintf(stderr,
+        "Usage: slim-load-gen [options] http://host:port/path\n"
+        "  -t, --threads N        worker threads (default 2)\n"
+        "  -c, --connections N    total connections (default 10)\n"
+        "  -d, --duration S       measurement length in seconds (default 10)\n"
+        "  -w, --warmup S         unmeasured warmup in seconds (default 0)\n"
+        "  -p, --pipeline N       requests in flight per connection (default 1)\n"
+        "  -R, --rate N           open loop at N requests/s in total (default 0, closed loop)\n"
+        "      --close            one request per connection instead of keep-alive\n"
+        "  -T, --timeout MS       response timeout (default 5000)\n"
+        "  -s, --scenario NAME    get, login or register (default get)\n"
+        "  -m, --mix FILE         URL mix, lines of \"weight METHOD path [body]\"\n"
+        "  -j, --json FILE        write the results as JSON, - for stdout\n");
+}
+
+// Parses http://host[:port][/path], the port defaults to 80.
+bool ParseUrl(const std::string& url, std::string* host, int* port, std::string* path) {
+    if (url.compare(0, 7, "http://") != 0) {
+        return false;
+    }
+    std::string rest = url.substr(7);
+    size_t slash = rest.find('/');
+    std::string hostPort = rest.substr(0, slash);
+    *path = slash == std::string::npos ? "/" : rest.substr(slash);
+    size_t colon = hostPort.find(':');
+    *host = hostPort.substr(0, colon);
+    *port = colon == std::string::npos ? 80 : atoi(hostPort.c_str() + colon + 1);
+    return !host->empty() && *port > 0 && *port < 65536;
+}
+
+// Reads a URL mix file, blank lines and lines starting with '#' are skipped.
+bool ReadMix(const char* file, std::vector<LoadGen::Request>* requests) {
+    std::ifstream in(file);
+    if (!in) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        LoadGen::Request request;
+        if (line.empty() || line[0] == '#' || !(fields >> request.weight >> request.method >> request.path)) {
+            continue;
+        }
+        fields >> request.body;
+        if (request.weight > 0) {
+            requests->push_back(request);
+        }
+    }
+    return !requests->empty();
+}
+
+void PrintText(FILE* out, const LoadGen::Config& config, const LoadGen::Result& result, const char* mode) {
+    const HdrHistogram& latency = result.latency;
+    fprintf(out, "%d threads and %d connections, %s, pipeline %d, %s\n",
+            config.threads, config.connections, mode, config.pipeline, config.keepAlive ? "keep-alive" : "close");
+    fprintf(out, "  Latency     mean %.3fms  stdev %.3fms  max %.3fms\n",
+            latency.Mean() / 1e6, latency.Stdev() / 1e6, latency.Max() / 1e6);
+    fprintf(out, "  Percentiles");
+    for (size_t i = 0; i < sizeof(PERCENTILES) / sizeof(PERCENTILES[0]); ++i) {
+        fprintf(out, "  %g%% %.3fms", PERCENTILES[i], latency.Percentile(PERCENTILES[i]) / 1e6);
+    }
+    fprintf(out, "\n  %llu responses of %llu requests in %.1fs, %.2fMB read\n",
+            (unsigned long long)result.responses, (unsigned long long)result.requests, result.seconds, result.bytesIn / 1048576.0);
+    fprintf(out, "  Codes");
+    for (auto& code : result.codes) {
+        fprintf(out, "  %d: %llu", code.first, (unsigned long long)code.second);
+    }
+    fprintf(out, "\n  Errors  connect %llu, read %llu, write %llu, timeout %llu, bad response %llu\n",
+            (unsigned long long)result.connectErrors, (unsigned long long)result.readErrors,
+            (unsigned long long)result.writeErrors, (unsigned long long)result.timeouts,
+            (unsigned long long)result.badResponses);
+    fprintf(out, "Requests/sec: %.2f\nTransfer/sec: %.2fMB\n",
+            result.responses / result.seconds, result.bytesIn / 1048576.0 / result.seconds);
+}
+
+void WriteJson(FILE* out, const std::string& url, const std::string& scenario,
+               const LoadGen::Config& config, const LoadGen::Result& result) {
+    const HdrHistogram& latency = result.latency;
+    fprintf(out, "{\n  \"url\": \"%s\",\n  \"scenario\": \"%s\",\n", url.c_str(), scenario.c_str());
+    fprintf(out, "  \"threads\": %d,\n  \"connections\": %d,\n  \"duration_s\": %.3f,\n  \"pipeline\": %d,\n",
+            config.threads, config.connections, result.seconds, config.pipeline);
+    fprintf(out, "  \"rate\": %.1f,\n  \"keepalive\": %s,\n", config.rate, config.keepAlive ? "true" : "false");
+    fprintf(out, "  \"requests\": %llu,\n  \"responses\": %llu,\n  \"rps\": %.2f,\n  \"bytes_in\": %llu,\n",
+            (unsigned long long)result.requests, (unsigned long long)result.responses,
+            result.responses / result.seconds, (unsigned long long)result.bytesIn);
+    fprintf(out, "  \"errors\": {\"connect\": %llu, \"read\": %llu, \"write\": %llu, \"timeout\": %llu, \"bad_response\": %llu},\n",
+            (unsigned long long)result.connectErrors, (unsigned long long)result.readErrors,
+            (unsigned long long)result.writeErrors, (unsigned long long)result.timeouts,
+            (unsigned long long)result.badResponses);
+    fprintf(out, "  \"codes\": {");
+    const char* sep = "";
+    for (auto& code : result.codes) {
+        fprintf(out, "%s\"%d\": %llu", sep, code.first, (unsigned long long)code.second);
+        sep = ", ";
+    }
+    fprintf(out, "},\n  \"latency_us\": {\"min\": %.1f, \"mean\": %.1f, \"stdev\": %.1f, \"max\": %.1f",
+            latency.Min() / 1e3, latency.Mean() / 1e3, latency.Stdev() / 1e3, latency.Max() / 1e3);
+    for (size_t i = 0; i < sizeof(PERCENTILES) / sizeof(PERCENTILES[0]); ++i) {
+        fprintf(out, ", \"%s\": %.1f", PERCENTILE_KEYS[i], latency.Percentile(PERCENTILES[i]) / 1e3);
+    }
+    fprintf(out, "}\n}\n");
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    LoadGen::Config config;
+    config.threads = 2;
+    config.connections = 10;
+    config.durationSec = 10;
+    config.warmupSec = 0;
+    config.pipeline = 1;
+    config.rate = 0;
+    config.keepAlive = true;
+    config.timeoutMs = 5000;
+    std::string scenario = "get";
+    const char* mixFile = nullptr;
+    const char* jsonFile = nullptr;
+
+    static const option OPTIONS[] = {
+        {"threads", required_argument, nullptr, 't'},
+        {"connections", required_argument, nullptr, 'c'},
+        {"duration", required_argument, nullptr, 'd'},
+        {"warmup", required_argument, nullptr, 'w'},
+        {"pipeline", required_argument, nullptr, 'p'},
+        {"rate", required_argument, nullptr, 'R'},
+        {"close", no_argument, nullptr, 'C'},
+        {"timeout", required_argument, nullptr, 'T'},
+        {"scenario", required_argument, nullptr, 's'},
+        {"mix", required_argument, nullptr, 'm'},
+        {"json", required_argument, nullptr, 'j'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "t:c:d:w:p:R:T:s:m:j:h", OPTIONS, nullptr)) != -1) {
+        switch (opt) {
+            case 't': config.threads = atoi(optarg); break;
+            case 'c': config.connections = atoi(optarg); break;
+            case 'd': config.durationSec = atoi(optarg); break;
+            case 'w': config.warmupSec = atoi(optarg); break;
+            case 'p': config.pipeline = atoi(optarg); break;
+            case 'R': config.rate = atof(optarg); break;
+            case 'C': config.keepAlive = false; break;
+            case 'T': config.timeoutMs = atoi(optarg); break;
+            case 's': scenario = optarg; break;
+            case 'm': mixFile = optarg; break;
+            case 'j': jsonFile = optarg; break;
+            default: Usage(); return 1;
+        }
+    }
+    std::string url = optind < argc ? argv[optind] : "";
+    std::string path;
+    if (!ParseUrl(url, &config.host, &config.port, &path) || config.threads <= 0 || config.durationSec <= 0 ||
+        config.pipeline <= 0 || config.timeoutMs <= 0 || config.rate < 0 || config.warmupSec < 0) {
+        Usage();
+        return 1;
+    }
+    if (!config.keepAlive) {
+        config.pipeline = 1;
+    }
+    // every thread needs at least one connection
+    if (config.connections < config.threads) {
+        config.threads = config.connections;
+    }
+
+    LoadGen::Request login = {1, "POST", "/login.html", "username=slimbench&password=slimbench"};
+    if (mixFile) {
+        scenario = mixFile;
+        if (!ReadMix(mixFile, &config.requests)) {
+            fprintf(stderr, "can not read the URL mix %s\n", mixFile);
+            return 1;
+        }
+    } else if (scenario == "get") {
+        config.requests.push_back({1, "GET", path, ""});
+    } else if (scenario == "login") {
+        config.requests.push_back(login);
+    } else if (scenario == "register") {
+        // every request registers a new user
+        config.requests.push_back({1, "POST", "/register.html", "username=lg{seq}&password=slimbench"});
+    } else {
+        Usage();
+        return 1;
+    }
+
+    LoadGen loadGen(config);
+    if (scenario == "login") {
+        // the user may already exist, only the login requests are measured
+        LoadGen::Request signUp = {1, "POST", "/register.html", login.body};
+        loadGen.SendOnce(signUp);
+    }
+
+    // with the JSON on stdout the text summary goes to stderr
+    FILE* text = jsonFile && strcmp(jsonFile, "-") == 0 ? stderr : stdout;
+    const char* mode = config.rate > 0 ? "open loop" : "closed loop";
+    fprintf(text, "Running %ds test @ %s (%s, warmup %ds)\n", config.durationSec, url.c_str(), scenario.c_str(), config.warmupSec);
+    fflush(text);
+    LoadGen::Result result;
+    if (!loadGen.Run(&result)) {
+        fprintf(stderr, "can not resolve %s\n", config.host.c_str());
+        return 1;
+    }
+    PrintText(text, config, result, mode);
+
+    if (jsonFile) {
+        FILE* out = strcmp(jsonFile, "-") == 0 ? stdout : fopen(jsonFile, "w");
+        if (!out) {
+            fprintf(stderr, "can not write %s\n", jsonFile);
+            return 1;
+        }
+        WriteJson(out, url, scenario, config, result);
+        if (out != stdout) {
+            fclose(out);
+        }
+    }
+    return 0;
+}
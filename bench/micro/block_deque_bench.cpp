@@ -0,0 +1,43 @@
+//
+// Created by pyq on 10/19/26.
+//
+#include <thread>
+#include "micro_bench.h"
+#include "../../src/block_deque/block_deque.h"
+
+// Pushes and pops on one thread, the uncontended cost of the lock and the notifications.
+static void BlockDequePushPop(MicroBench::State& state) {
+    BlockDeque<int> deque(1024);
+    int item = 0;
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        deque.push_back(i);
+        deque.pop_front(item);
+    }
+    DoNotOptimize(item);
+}
+SLIM_BENCH(BlockDequePushPop);
+
+// Arg() producers push to one consumer, like the log threads feeding the async write thread.
+// One operation is one item through the queue.
+static void BlockDequeContended(MicroBench::State& state) {
+    BlockDeque<int> deque(1024);
+    std::vector<std::thread> producers;
+    uint64_t total = state.Iterations(), per = total / state.Arg();
+    for (int64_t p = 0; p < state.Arg(); ++p) {
+        uint64_t count = per + (p == 0 ? total % state.Arg() : 0);
+        producers.emplace_back([&deque, count]() {
+            for (uint64_t i = 0; i < count; ++i) {
+                deque.push_back(i);
+            }
+        });
+    }
+    int item = 0;
+    for (uint64_t i = 0; i < total; ++i) {
+        deque.pop_front(item);
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    DoNotOptimize(item);
+}
+SLIM_BENCH(BlockDequeContended, 1, 4);
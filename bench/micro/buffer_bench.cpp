@@ -0,0 +1,65 @@
+//
+// Created by pyq on 10/19/26.
+//
+#include <unistd.h>
+#include <sys/socket.h>
+#include "micro_bench.h"
+#include "../../src/buffer/buffer.h"
+
+// Appends Arg() bytes and reads them back, the steady state of a connection buffer.
+static void BufferAppendRetrieve(MicroBench::State& state) {
+    std::string data(state.Arg(), 'x');
+    Buffer buff;
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        buff.Append(data.data(), data.size());
+        buff.AdvanceReadPointer(data.size());
+    }
+}
+SLIM_BENCH(BufferAppendRetrieve, 16, 256, 4096);
+
+// Appends Arg() bytes to a fresh buffer in 64 byte pieces, measuring growth.
+static void BufferGrow(MicroBench::State& state) {
+    char data[64] = {0};
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        Buffer buff;
+        for (int64_t len = 0; len < state.Arg(); len += sizeof(data)) {
+            buff.Append(data, sizeof(data));
+        }
+        DoNotOptimize(buff.GetReadableBytes());
+    }
+}
+SLIM_BENCH(BufferGrow, 4096, 65536);
+
+// Appends 256 bytes and copies them out as a string.
+static void BufferRetrieveAsString(MicroBench::State& state) {
+    std::string data(256, 'x');
+    Buffer buff;
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        buff.Append(data);
+        DoNotOptimize(buff.RetrieveAllAsString());
+    }
+}
+SLIM_BENCH(BufferRetrieveAsString);
+
+// Reads Arg() bytes from a socket, the write into the socket is not timed.
+static void BufferReadFromFd(MicroBench::State& state) {
+    int fds[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    int size = 1 << 20;
+    setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    setsockopt(fds[1], SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    std::string data(state.Arg(), 'x');
+    Buffer buff;
+    int error = 0;
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        state.PauseTiming();
+        ssize_t ret = write(fds[0], data.data(), data.size());
+        DoNotOptimize(ret);
+        state.ResumeTiming();
+        buff.ReadFromFd(fds[1], &error);
+        buff.RetrieveAll();
+    }
+    close(fds[0]);
+    close(fds[1]);
+}
+SLIM_BENCH(BufferReadFromFd, 256, 16384);
@@ -0,0 +1,191 @@
+//
+// Created by pyq on 10/19/26.
+//
+#include <unistd.h>
+#include "micro_bench.h"
+#include "../../src/http/http_request.h"
+#include "../../src/http/http_response.h"
+#include "../../src/http/multipart_reader.h"
+#include "../../src/http/url_form.h"
+
+namespace {
+
+// Request corpora: a curl GET, a browser GET with a full header set and a form POST to a path without login.
+const char* REQUESTS[] = {
+    "GET /index.html HTTP/1.1\r\n"
+    "Host: 127.0.0.1:1316\r\n"
+    "User-Agent: curl/8.5.0\r\n"
+    "Accept: */*\r\n"
+    "\r\n",
+
+    "GET /images/profile-image.jpg?size=large HTTP/1.1\r\n"
+    "Host: 127.0.0.1:1316\r\n"
+    "Connection: keep-alive\r\n"
+    "sec-ch-ua: \"Chromium\";v=\"124\", \"Google Chrome\";v=\"124\", \"Not-A.Brand\";v=\"99\"\r\n"
+    "sec-ch-ua-mobile: ?0\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/124.0.0.0 Safari/537.36\r\n"
+    "sec-ch-ua-platform: \"Linux\"\r\n"
+    "Accept: image/avif,image/webp,image/apng,image/svg+xml,image/*,*/*;q=0.8\r\n"
+    "Sec-Fetch-Site: same-origin\r\n"
+    "Sec-Fetch-Mode: no-cors\r\n"
+    "Sec-Fetch-Dest: image\r\n"
+    "Referer: http://127.0.0.1:1316/picture.html\r\n"
+    "Accept-Encoding: gzip, deflate, br, zstd\r\n"
+    "Accept-Language: en-US,en;q=0.9,zh-CN;q=0.8,zh;q=0.7\r\n"
+    "Cookie: session=4f2a9c1e7b3d4a8f9e0c1b2a3d4e5f60; theme=dark\r\n"
+    "\r\n",
+
+    "POST /search HTTP/1.1\r\n"
+    "Host: 127.0.0.1:1316\r\n"
+    "Connection: keep-alive\r\n"
+    "Content-Type: application/x-www-form-urlencoded\r\n"
+    "Content-Length: 58\r\n"
+    "\r\n"
+    "q=slim+web+server&page=2&sort=date%2Bdesc&lang=zh-CN&n=20",
+};
+
+// Discards a request body, like a handler that only checks what it is sent.
+class DiscardReader : public HttpRequest::BodyReader {
+public:
+    bool Write(const char* data, size_t len) override {
+        DoNotOptimize(data);
+        return true;
+    }
+};
+
+std::string SrcDir() {
+    char* cwd = getcwd(nullptr, 256);
+    std::string dir = std::string(cwd) + "/resources/";
+    free(cwd);
+    return dir;
+}
+
+}
+
+// Parses one request of the corpus Arg(), including copying it into the read buffer.
+static void HttpParseRequest(MicroBench::State& state) {
+    std::string request = REQUESTS[state.Arg()];
+    Buffer buff;
+    HttpRequest httpRequest;
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        buff.Append(request);
+        httpRequest.Init();
+        // the parser stops after the headers, the body follows with the next call
+        if (httpRequest.ParseHttpRequest(buff) && httpRequest.State() == HttpRequest::BODY) {
+            httpRequest.ParseHttpRequest(buff);
+        }
+        DoNotOptimize(httpRequest.State());
+        buff.RetrieveAll();
+    }
+}
+SLIM_BENCH(HttpParseRequest, 0, 1, 2);
+
+// Decodes a chunked upload of Arg() bytes in 4KB chunks into a body reader, the body is never copied.
+static void HttpParseChunked(MicroBench::State& state) {
+    std::string request = "POST /upload HTTP/1.1\r\nHost: 127.0.0.1:1316\r\nTransfer-Encoding: chunked\r\n\r\n";
+    std::string chunk = "1000\r\n" + std::string(4096, 'x') + "\r\n";
+    for (int64_t left = state.Arg(); left > 0; left -= 4096) {
+        request += chunk;
+    }
+    request += "0\r\n\r\n";
+    HttpRequest::maxBodySize = state.Arg() + 4096;
+    Buffer buff;
+    HttpRequest httpRequest;
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        buff.Append(request);
+        httpRequest.Init();
+        httpRequest.ParseHttpRequest(buff);
+        httpRequest.SetBodyReader(std::unique_ptr<HttpRequest::BodyReader>(new DiscardReader()));
+        httpRequest.ParseHttpRequest(buff);
+        DoNotOptimize(httpRequest.State());
+        buff.RetrieveAll();
+    }
+}
+SLIM_BENCH(HttpParseChunked, 65536, 1048576);
+
+// Parses a multipart upload of one field and a file of Arg() random bytes in 64KB slices, the slices a
+// connection hands over, the file is written to /tmp and removed again.
+static void MultipartUpload(MicroBench::State& state) {
+    std::string boundary = "----WebKitFormBoundary7MA4YWxkTrZu0gW";
+    std::string body = "--" + boundary + "\r\nContent-Disposition: form-data; name=\"title\"\r\n\r\nholiday\r\n--" + boundary +
+                       "\r\nContent-Disposition: form-data; name=\"file\"; filename=\"a.jpg\"\r\nContent-Type: image/jpeg\r\n\r\n";
+    uint32_t seed = 1;
+    for (int64_t i = 0; i < state.Arg(); ++i) {
+        seed = seed * 1103515245 + 12345;
+        body += static_cast<char>(seed >> 16);
+    }
+    body += "\r\n--" + boundary + "--\r\n";
+    const size_t SLICE = 65536;
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        MultipartReader reader(boundary, "/tmp");
+        for (size_t pos = 0; pos < body.size(); pos += SLICE) {
+            reader.Write(body.data() + pos, std::min(SLICE, body.size() - pos));
+        }
+        DoNotOptimize(reader.IsComplete());
+    }
+}
+SLIM_BENCH(MultipartUpload, 65536, 1048576);
+
+// Decodes a URL-encoded form in place, Arg() 0 a login form with escapes, 1 a 4KB form of mostly plain
+// text, the copy that restores the raw bytes is part of the loop.
+static void UrlFormParse(MicroBench::State& state) {
+    std::string form = "username=john+doe&password=12345%21%40abc&remember=on";
+    if (state.Arg() == 1) {
+        form = "title=Holiday+photos&tags=beach%2Csea";
+        for (int i = 0; form.size() < 4096; ++i) {
+            form += "&comment" + std::to_string(i) + "=" + std::string(100, 'a' + i % 26);
+        }
+    }
+    std::string data = form;
+    UrlForm urlForm;
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        memcpy(&data[0], form.data(), form.size());
+        DoNotOptimize(urlForm.Parse(&data[0], data.size()));
+        DoNotOptimize(urlForm.Size());
+    }
+}
+SLIM_BENCH(UrlFormParse, 0, 1);
+
+// Builds the response for a file under resources, stat, open and mmap included.
+static void HttpMakeResponseFile(MicroBench::State& state) {
+    std::string srcDir = SrcDir();
+    Buffer buff;
+    HttpResponse response;
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        std::string path = "/index.html";
+        response.Init(srcDir, path, true, 200);
+        response.MakeResponse(buff);
+        buff.RetrieveAll();
+    }
+}
+SLIM_BENCH(HttpMakeResponseFile);
+
+// Builds the 404 response of a missing file, which also renders the error page.
+static void HttpMakeResponseNotFound(MicroBench::State& state) {
+    std::string srcDir = SrcDir();
+    Buffer buff;
+    HttpResponse response;
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        std::string path = "/missing.html";
+        response.Init(srcDir, path, true, -1);
+        response.MakeResponse(buff);
+        buff.RetrieveAll();
+    }
+}
+SLIM_BENCH(HttpMakeResponseNotFound);
+
+// Builds a response with a 1KB body generated in memory, as the metrics endpoint does.
+static void HttpMakeResponseContent(MicroBench::State& state) {
+    std::string srcDir = SrcDir();
+    std::string content(1024, 'x');
+    Buffer buff;
+    HttpResponse response;
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        std::string path = "/metrics";
+        response.Init(srcDir, path, true, 200);
+        response.SetContent(content, "text/plain");
+        response.MakeResponse(buff);
+        buff.RetrieveAll();
+    }
+}
+SLIM_BENCH(HttpMakeResponseContent);
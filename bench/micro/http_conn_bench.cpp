@@ -0,0 +1,113 @@
+//
+// Created by pyq on 10/19/26.
+//
+#include <unistd.h>
+#include "micro_bench.h"
+#include "../../src/http/http_connect.h"
+#include "../../src/transport/transport.h"
+
+namespace {
+
+// Keep-alive requests: a small page and a large image, both served from resources.
+const char* REQUESTS[] = {
+    "GET /index.html HTTP/1.1\r\n"
+    "Host: 127.0.0.1:1316\r\n"
+    "Connection: keep-alive\r\n"
+    "User-Agent: curl/8.5.0\r\n"
+    "Accept: */*\r\n"
+    "\r\n",
+
+    "GET /images/instagram-image4.jpg HTTP/1.1\r\n"
+    "Host: 127.0.0.1:1316\r\n"
+    "Connection: keep-alive\r\n"
+    "User-Agent: curl/8.5.0\r\n"
+    "Accept: */*\r\n"
+    "\r\n",
+};
+
+// Generates the body of /stream?bytes=N in pieces of at most 4KB.
+class CountStream : public HttpResponse::Stream {
+public:
+    explicit CountStream(long bytes) : left_(bytes) {}
+
+    bool Next(std::string& out, size_t maxBytes) override {
+        size_t len = std::min<size_t>(left_, std::min<size_t>(maxBytes, 4096));
+        out.append(len, 'x');
+        left_ -= len;
+        return left_ > 0;
+    }
+
+private:
+    long left_;
+};
+
+// Streams the number of bytes asked for in the query.
+class StreamHandler : public Router::Handler {
+public:
+    void Handle(Router::Context& context, HttpResponse& response) override {
+        long bytes = atol(context.request.GetQuery("bytes").c_str());
+        response.SetStream(std::unique_ptr<HttpResponse::Stream>(new CountStream(bytes)), "text/plain");
+    }
+};
+
+// HttpConn::srcDir only keeps the pointer.
+const char* ResourcesDir() {
+    static std::string dir;
+    if (dir.empty()) {
+        char* cwd = getcwd(nullptr, 256);
+        dir = std::string(cwd) + "/resources/";
+        free(cwd);
+    }
+    return dir.c_str();
+}
+
+// Serves one request of the corpus per iteration on a keep-alive HttpConn over an in-memory transport,
+// reads and writes are cut into chunk bytes when chunk is not 0.
+void Cycle(MicroBench::State& state, const char* request, size_t chunk) {
+    HttpConn::srcDir = ResourcesDir();
+    HttpConn::isET = true;
+    MemoryTransport transport;
+    transport.SetChunk(chunk, chunk);
+    transport.SetDiscard(true);
+    sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    HttpConn conn;
+    conn.Init(1000, addr, &transport);
+    int saveErrno = 0;
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        transport.Feed(request, strlen(request));
+        conn.Read(&saveErrno);
+        conn.Process();
+        while (conn.ToWriteBytes() > 0 && conn.Write(&saveErrno) > 0) {
+        }
+    }
+    DoNotOptimize(transport.WrittenBytes());
+    conn.Close();
+}
+
+}
+
+// Read, parse, build the response and write it for the request corpus Arg(), one read and one write each.
+static void HttpConnCycle(MicroBench::State& state) {
+    Cycle(state, REQUESTS[state.Arg()], 0);
+}
+SLIM_BENCH(HttpConnCycle, 0, 1);
+
+// Serves the small page with every read and write cut to Arg() bytes, exercising partial reads and short writes.
+static void HttpConnPartial(MicroBench::State& state) {
+    Cycle(state, REQUESTS[0], state.Arg());
+}
+SLIM_BENCH(HttpConnPartial, 16, 1460);
+
+// Streams a generated body of Arg() bytes with chunked encoding, produced 32KB ahead of the transport.
+static void HttpConnStream(MicroBench::State& state) {
+    Router::Instance()->Add("GET", "/stream", std::make_shared<StreamHandler>());
+    std::string request = "GET /stream?bytes=" + std::to_string(state.Arg()) + " HTTP/1.1\r\n"
+                          "Host: 127.0.0.1:1316\r\n"
+                          "Connection: keep-alive\r\n"
+                          "\r\n";
+    Cycle(state, request.c_str(), 0);
+    Router::Instance()->Clear();
+}
+SLIM_BENCH(HttpConnStream, 4096, 1048576);
@@ -0,0 +1,25 @@
+//
+// Created by pyq on 10/19/26.
+//
+#include <sys/stat.h>
+#include "micro_bench.h"
+#include "../../src/log/log.h"
+
+// Writes a line through LOG_INFO to /tmp/slim-bench-log, Arg() 0 is synchronous and 1 asynchronous.
+// A full async queue falls back to a synchronous write, a long run measures that mix.
+static void LogWrite(MicroBench::State& state) {
+    static bool isInit = false;
+    if (!isInit) {
+        mkdir("/tmp/slim-bench-log", 0755);
+        Log::Instance()->Init(0, "/tmp/slim-bench-log", ".log", 0);
+        isInit = true;
+    }
+    Log::Instance()->SetAsync(state.Arg() == 1);
+    state.ResetTimer();
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        LOG_INFO("Client[%d](%s:%d) in, userCount:%d", (int)(i & 1023), "127.0.0.1", 52814, 42);
+    }
+    state.PauseTiming();
+    Log::Instance()->SetAsync(false);
+}
+SLIM_BENCH(LogWrite, 0, 1);
@@ -0,0 +1,163 @@
+//
+// Created by pyq on 10/19/26.
+//
+#include "micro_bench.h"
+#include <new>
+#include <ctime>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+
+namespace {
+
+std::atomic<uint64_t> allocCount(0);
+std::atomic<uint64_t> allocBytes(0);
+
+void* CountedAlloc(size_t size) {
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    allocBytes.fetch_add(size, std::memory_order_relaxed);
+    return malloc(size ? size : 1);
+}
+
+}
+
+// replacing the global allocation functions counts every new of the program, including the standard library
+void* operator new(size_t size) {
+    void* p = CountedAlloc(size);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return CountedAlloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return CountedAlloc(size);
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    free(p);
+}
+
+MicroBench::State::State(uint64_t iterations, int64_t arg) :
+        iterations_(iterations), arg_(arg), paused_(false), ns_(0), allocs_(0), bytes_(0) {
+    ResetTimer();
+}
+
+uint64_t MicroBench::State::Iterations() const {
+    return iterations_;
+}
+
+int64_t MicroBench::State::Arg() const {
+    return arg_;
+}
+
+void MicroBench::State::ResetTimer() {
+    ns_ = allocs_ = bytes_ = 0;
+    paused_ = false;
+    AllocCount(&startAllocs_, &startBytes_);
+    startNs_ = NowNs();
+}
+
+void MicroBench::State::PauseTiming() {
+    uint64_t now = NowNs(), allocs, bytes;
+    AllocCount(&allocs, &bytes);
+    ns_ += now - startNs_;
+    allocs_ += allocs - startAllocs_;
+    bytes_ += bytes - startBytes_;
+    paused_ = true;
+}
+
+void MicroBench::State::ResumeTiming() {
+    paused_ = false;
+    AllocCount(&startAllocs_, &startBytes_);
+    startNs_ = NowNs();
+}
+
+void MicroBench::State::Finish(uint64_t* ns, uint64_t* allocs, uint64_t* bytes) {
+    if (!paused_) {
+        PauseTiming();
+    }
+    *ns = ns_;
+    *allocs = allocs_;
+    *bytes = bytes_;
+}
+
+MicroBench::Registrar::Registrar(const char* name, BenchFunc func, std::initializer_list<int64_t> args) {
+    if (args.size() == 0) {
+        Benches_().push_back({name, func, 0});
+    }
+    for (int64_t arg : args) {
+        Benches_().push_back({std::string(name) + "/" + std::to_string(arg), func, arg});
+    }
+}
+
+std::vector<MicroBench::Bench>& MicroBench::Benches_() {
+    static std::vector<Bench> benches;
+    return benches;
+}
+
+uint64_t MicroBench::NowNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void MicroBench::AllocCount(uint64_t* allocs, uint64_t* bytes) {
+    *allocs = allocCount.load(std::memory_order_relaxed);
+    *bytes = allocBytes.load(std::memory_order_relaxed);
+}
+
+int MicroBench::RunAll(const std::string& filter) {
+    std::vector<Bench> benches = Benches_();
+    std::stable_sort(benches.begin(), benches.end(), [](const Bench& a, const Bench& b) {
+        // group by benchmark, keep the argument order of the registration
+        return a.name.substr(0, a.name.find('/')) < b.name.substr(0, b.name.find('/'));
+    });
+    printf("%-36s %12s %12s %10s %10s\n", "Benchmark", "Iterations", "ns/op", "allocs/op", "bytes/op");
+    for (auto& bench : benches) {
+        if (bench.name.find(filter) == std::string::npos) {
+            continue;
+        }
+        uint64_t iterations = 1, ns = 0, allocs = 0, bytes = 0;
+        while (true) {
+            State state(iterations, bench.arg);
+            bench.func(state);
+            state.Finish(&ns, &allocs, &bytes);
+            if (ns >= MIN_TIME_MS * 1000000 || iterations >= MAX_ITERATIONS) {
+                break;
+            }
+            // aim 20% above the minimum time, growing at most 100x per round
+            uint64_t next = ns ? (uint64_t)(iterations * 1.2 * MIN_TIME_MS * 1000000 / ns) : iterations * 100;
+            iterations = std::min(MAX_ITERATIONS, std::max(iterations + 1, std::min(next, iterations * 100)));
+        }
+        printf("%-36s %12llu %12.1f %10.2f %10.1f\n", bench.name.c_str(), (unsigned long long)iterations,
+               (double)ns / iterations, (double)allocs / iterations, (double)bytes / iterations);
+        fflush(stdout);
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    return MicroBench::RunAll(argc > 1 ? argv[1] : "");
+}
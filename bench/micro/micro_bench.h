@@ -0,0 +1,96 @@
+//
+// Created by pyq on 10/19/26.
+//
+#pragma once
+#ifndef SLIM_WEB_SERVER_MICRO_BENCH_H
+#define SLIM_WEB_SERVER_MICRO_BENCH_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+
+// Minimal microbenchmark runner. A benchmark runs state.Iterations() operations, the runner grows the
+// iteration count until a run takes MIN_TIME_MS and reports ns/op, allocations/op and bytes/op.
+// Allocations are counted by replacing the global operator new, every thread is counted.
+class MicroBench {
+public:
+    // Timing and argument of one run.
+    class State {
+    public:
+        State(uint64_t iterations, int64_t arg);
+
+        // Returns the number of operations to run.
+        uint64_t Iterations() const;
+
+        // Returns the argument the benchmark was registered with, 0 if none.
+        int64_t Arg() const;
+
+        // Discards the time and allocations so far, call after an expensive setup.
+        void ResetTimer();
+
+        // Stops counting time and allocations, e.g. around per batch setup.
+        void PauseTiming();
+
+        // Resumes counting after PauseTiming.
+        void ResumeTiming();
+
+        // Returns the counted nanoseconds, allocations and allocated bytes.
+        void Finish(uint64_t* ns, uint64_t* allocs, uint64_t* bytes);
+
+    private:
+        uint64_t iterations_;   // Operations to run.
+        int64_t arg_;           // Argument of the benchmark.
+        bool paused_;           // Counting is paused.
+        uint64_t ns_;           // Nanoseconds counted before the current span.
+        uint64_t allocs_;       // Allocations counted before the current span.
+        uint64_t bytes_;        // Bytes counted before the current span.
+        uint64_t startNs_;      // Start of the current span.
+        uint64_t startAllocs_;  // Allocation count at the start of the current span.
+        uint64_t startBytes_;   // Allocated bytes at the start of the current span.
+    };
+
+    using BenchFunc = void (*)(State& state);
+
+    // Registers a benchmark at static initialization, once per argument or once without.
+    class Registrar {
+    public:
+        Registrar(const char* name, BenchFunc func, std::initializer_list<int64_t> args);
+    };
+
+    // Runs the benchmarks whose name contains filter, returns the process exit code.
+    static int RunAll(const std::string& filter);
+
+    // Returns the current monotonic time in nanoseconds.
+    static uint64_t NowNs();
+
+    // Returns the allocations and allocated bytes of the process so far.
+    static void AllocCount(uint64_t* allocs, uint64_t* bytes);
+
+private:
+    static const uint64_t MIN_TIME_MS = 300;            // Shortest accepted run.
+    static const uint64_t MAX_ITERATIONS = 1000000000;  // Upper bound of the iteration count.
+
+    // A registered benchmark.
+    struct Bench {
+        std::string name;
+        BenchFunc func;
+        int64_t arg;
+    };
+
+    // Returns the registered benchmarks, a function local static so registration order does not matter.
+    static std::vector<Bench>& Benches_();
+};
+
+// Registers func, e.g. SLIM_BENCH(BufferAppend, 16, 256) runs BufferAppend/16 and BufferAppend/256.
+#define SLIM_BENCH(func, ...) \
+    static MicroBench::Registrar func##Registrar_(#func, func, {__VA_ARGS__})
+
+// Keeps the compiler from optimizing away a value computed by a benchmark.
+template <class T>
+inline void DoNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+#endif //SLIM_WEB_SERVER_MICRO_BENCH_H
@@ -0,0 +1,63 @@
+//
+// Created by pyq on 10/19/26.
+//
+#include "micro_bench.h"
+#include "../../src/router/router.h"
+
+namespace {
+
+// Does nothing, only the lookup is measured.
+class NopHandler : public Router::Handler {
+public:
+    void Handle(Router::Context& context, HttpResponse& response) override {}
+};
+
+// Paths looked up: exact, with two parameters, under a prefix route and without a route.
+const char* PATHS[] = {
+    "/login",
+    "/api/users/1024/posts/77",
+    "/static/js/vendor/jquery.min.js",
+    "/images/instagram-image4.jpg",
+};
+
+// Fills the router with the built-in routes and a small REST API, about 40 routes.
+void AddRoutes(Router* router) {
+    router->Clear();
+    auto handler = std::make_shared<NopHandler>();
+    for (const char* page : {"/", "/index", "/register", "/login", "/welcome", "/video", "/picture", "/metrics",
+                             "/debug/profile", "/healthz"}) {
+        router->Add("GET", page, handler);
+    }
+    for (const char* page : {"/login", "/login.html", "/register", "/register.html"}) {
+        router->Add("POST", page, handler);
+    }
+    for (const char* resource : {"users", "posts", "comments", "tags", "orders", "carts"}) {
+        std::string base = std::string("/api/") + resource;
+        router->Add("GET", base, handler);
+        router->Add("POST", base, handler);
+        router->Add("GET", base + "/:id", handler);
+        router->Add("PUT", base + "/:id", handler);
+        router->Add("DELETE", base + "/:id", handler);
+    }
+    router->Add("GET", "/api/users/:id/posts/:post", handler);
+    router->Add("GET", "/static/*", handler);
+}
+
+}
+
+// Looks up the path Arg() in a table of about 40 routes.
+static void RouterFind(MicroBench::State& state) {
+    Router* router = Router::Instance();
+    AddRoutes(router);
+    std::string method = "GET";
+    std::string path = PATHS[state.Arg()];
+    Router::Params params;
+    state.ResetTimer();
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        DoNotOptimize(router->Find(method, path, &params));
+    }
+    state.PauseTiming();
+    router->Clear();
+    state.ResumeTiming();
+}
+SLIM_BENCH(RouterFind, 0, 1, 2, 3);
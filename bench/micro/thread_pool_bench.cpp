@@ -0,0 +1,26 @@
+//
+// Created by pyq on 10/19/26.
+//
+#include <atomic>
+#include <thread>
+#include <memory>
+#include "micro_bench.h"
+#include "../../src/thread_pool/thread_pool.h"
+
+// Runs empty tasks on a pool of Arg() workers, one operation is one task queued and run.
+static void ThreadPoolTasks(MicroBench::State& state) {
+    std::unique_ptr<ThreadPool> pool(new ThreadPool(state.Arg()));
+    std::atomic<uint64_t> done(0);
+    state.ResetTimer();
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        pool->AddTask([&done]() {
+            done.fetch_add(1, std::memory_order_relaxed);
+        });
+    }
+    while (done.load(std::memory_order_relaxed) < state.Iterations()) {
+        std::this_thread::yield();
+    }
+    state.PauseTiming();
+    pool.reset();
+}
+SLIM_BENCH(ThreadPoolTasks, 1, 4, 8);
@@ -0,0 +1,71 @@
+//
+// Created by pyq on 10/19/26.
+//
+#include "micro_bench.h"
+#include "../../src/timer/timer.h"
+
+namespace {
+
+// xorshift32, cheap enough not to show up in the timings
+uint32_t NextRandom(uint32_t& x) {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+}
+
+// Adds Arg() timers to an empty timer, the clear between batches is not timed.
+static void TimerAdd(MicroBench::State& state) {
+    Timer timer;
+    TimeoutCallBack cb = []() {};
+    uint32_t x = 2463534242;
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        if (i % state.Arg() == 0) {
+            state.PauseTiming();
+            timer.Clear();
+            state.ResumeTiming();
+        }
+        timer.Add(i % state.Arg() + 1, 1000 + NextRandom(x) % 60000, cb);
+    }
+}
+SLIM_BENCH(TimerAdd, 10000, 100000);
+
+// Adjusts a random timer of Arg() timers, as every read or write event does.
+static void TimerAdjust(MicroBench::State& state) {
+    Timer timer;
+    TimeoutCallBack cb = []() {};
+    uint32_t x = 2463534242;
+    for (int64_t i = 0; i < state.Arg(); ++i) {
+        timer.Add(i + 1, 1000 + NextRandom(x) % 60000, cb);
+    }
+    state.ResetTimer();
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        timer.Adjust(NextRandom(x) % state.Arg() + 1, 1000 + NextRandom(x) % 60000);
+    }
+}
+SLIM_BENCH(TimerAdjust, 10000, 100000);
+
+// Expires timers in batches of Arg(), one operation is one expired timer, adding them is not timed.
+static void TimerTick(MicroBench::State& state) {
+    Timer timer;
+    int expired = 0;
+    TimeoutCallBack cb = [&expired]() { ++expired; };
+    uint64_t done = 0;
+    while (done < state.Iterations()) {
+        uint64_t batch = std::min<uint64_t>(state.Arg(), state.Iterations() - done);
+        state.PauseTiming();
+        for (uint64_t i = 0; i < batch; ++i) {
+            timer.Add(i + 1, 0, cb);
+        }
+        state.ResumeTiming();
+        // the timeouts are due now, Tick expires the whole batch
+        while (expired < (int)batch) {
+            timer.Tick();
+        }
+        expired = 0;
+        done += batch;
+    }
+}
+SLIM_BENCH(TimerTick, 10000, 100000);
@@ -0,0 +1,303 @@
+#!/usr/bin/env python3
+#
+# Created by pyq on 10/19/26.
+#
+# End-to-end performance regression harness, see README.md.
+# Builds slim-regress-server and slim-load-gen, runs every workload against a fresh server on loopback
+# for each thread count and trigMode, writes the results as JSON and compares them with a baseline.
+
+import argparse
+import json
+import os
+import resource
+import shlex
+import shutil
+import socket
+import subprocess
+import sys
+import tempfile
+import time
+
+ROOT = os.path.dirname(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+BASELINE = os.path.join(ROOT, "bench", "regress", "baseline.json")
+SERVER = os.path.join(ROOT, "slim-regress-server")
+LOAD_GEN = os.path.join(ROOT, "slim-load-gen")
+
+# workload name -> path, extra load generator arguments and idle connections held open during the run
+WORKLOADS = {
+    "static_small": {"path": "/index.html", "args": [], "idle": 0},
+    "static_large": {"path": "/images/instagram-image4.jpg", "args": [], "idle": 0},
+    "static_close": {"path": "/index.html", "args": ["--close"], "idle": 0},
+    "login": {"path": "/", "args": ["-s", "login"], "idle": 0},
+    "idle_flood": {"path": "/index.html", "args": [], "idle": 1000},
+}
+
+# allowed relative change of every metric, "higher" metrics regress when they drop
+DEFAULT_TOLERANCE = {
+    "rps": 0.10,
+    "p50_us": 0.25,
+    "p99_us": 0.50,
+    "p999_us": 1.00,
+    "rss_kb": 0.20,
+    "cpu_us_per_req": 0.20,
+}
+HIGHER_IS_BETTER = {"rps"}
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description="End-to-end performance regression harness.")
+    parser.add_argument("--threads", default="2,6", help="server thread counts to sweep (default 2,6)")
+    parser.add_argument("--trig", default="1,3", help="trigMode values to sweep (default 1,3)")
+    parser.add_argument("--workloads", default=",".join(WORKLOADS), help="workloads to run")
+    parser.add_argument("--duration", type=int, default=5, help="measured seconds per case (default 5)")
+    parser.add_argument("--warmup", type=int, default=1, help="warmup seconds per case (default 1)")
+    parser.add_argument("--connections", type=int, default=64, help="load generator connections (default 64)")
+    parser.add_argument("--lg-threads", type=int, default=2, help="load generator threads (default 2)")
+    parser.add_argument("--idle", type=int, default=None, help="idle connections of idle_flood (default 1000)")
+    parser.add_argument("--out", default="regress-result.json", help="result file (default regress-result.json)")
+    parser.add_argument("--baseline", default=BASELINE, help="baseline file")
+    parser.add_argument("--update-baseline", action="store_true", help="write the results as the new baseline")
+    parser.add_argument("--no-compare", action="store_true", help="only write the results, e.g. for PGO training")
+    parser.add_argument("--no-build", action="store_true", help="use the binaries already built")
+    parser.add_argument("--make-arg", action="append", default=[], help="extra argument for make, repeatable")
+    parser.add_argument("--server-cpus", default=None,
+                        help="cpus of the server, e.g. 0-3 (default the first half of the usable cpus)")
+    parser.add_argument("--lg-cpus", default=None,
+                        help="cpus of the load generator, e.g. 4-7 (default the second half of the usable cpus)")
+    return parser.parse_args()
+
+
+def parse_cpus(text):
+    # "0-3,6" -> {0, 1, 2, 3, 6}
+    cpus = set()
+    for part in text.split(","):
+        first, _, last = part.partition("-")
+        cpus.update(range(int(first), int(last or first) + 1))
+    return cpus
+
+
+def pick_cpus(args):
+    # a server sharing its cores with the load generator measures the load generator as much as itself,
+    # so the two are pinned to disjoint halves of the usable cpus unless told otherwise
+    usable = sorted(os.sched_getaffinity(0))
+    half = len(usable) // 2
+    server = parse_cpus(args.server_cpus) if args.server_cpus else set(usable[:half])
+    load_gen = parse_cpus(args.lg_cpus) if args.lg_cpus else set(usable[half:])
+    if not server or not load_gen:
+        print("warning: only %d usable cpu(s), the server and the load generator share them; "
+              "the results are not comparable with a pinned baseline" % len(usable), flush=True)
+        return None, None
+    if server & load_gen:
+        print("warning: the server and the load generator share cpus %s" % sorted(server & load_gen), flush=True)
+    return server, load_gen
+
+
+def pinned(cpus):
+    # runs in the child between fork and exec
+    if cpus is None:
+        return None
+    return lambda: os.sched_setaffinity(0, cpus)
+
+
+def format_cpus(cpus):
+    return ",".join(str(c) for c in sorted(cpus)) if cpus else None
+
+
+def build(make_args):
+    cmd = ["make", "-j%d" % (os.cpu_count() or 2), "slim-regress-server", "slim-load-gen"] + make_args
+    print("$ " + " ".join(shlex.quote(c) for c in cmd), flush=True)
+    subprocess.check_call(cmd, cwd=ROOT, stdout=subprocess.DEVNULL)
+
+
+def free_port():
+    with socket.socket() as sock:
+        sock.bind(("127.0.0.1", 0))
+        return sock.getsockname()[1]
+
+
+def wait_ready(port, proc, timeout=10.0):
+    deadline = time.time() + timeout
+    while time.time() < deadline:
+        if proc.poll() is not None:
+            return False
+        try:
+            socket.create_connection(("127.0.0.1", port), timeout=0.2).close()
+            return True
+        except OSError:
+            time.sleep(0.05)
+    return False
+
+
+def cpu_ticks(pid):
+    # utime and stime are fields 14 and 15, counted after the parenthesized command name
+    with open("/proc/%d/stat" % pid) as f:
+        fields = f.read().rsplit(")", 1)[1].split()
+    return int(fields[11]) + int(fields[12])
+
+
+def rss_kb(pid):
+    with open("/proc/%d/status" % pid) as f:
+        for line in f:
+            if line.startswith("VmRSS:"):
+                return int(line.split()[1])
+    return 0
+
+
+def open_idle(port, count):
+    conns = []
+    for _ in range(count):
+        try:
+            conns.append(socket.create_connection(("127.0.0.1", port), timeout=2))
+        except OSError:
+            break
+    return conns
+
+
+def run_case(args, workload, threads, trig, server_cpus, lg_cpus):
+    spec = WORKLOADS[workload]
+    idle = spec["idle"] if args.idle is None or not spec["idle"] else args.idle
+    workdir = tempfile.mkdtemp(prefix="slim-regress-")
+    os.symlink(os.path.join(ROOT, "resources"), os.path.join(workdir, "resources"))
+    port = free_port()
+    server = subprocess.Popen([SERVER, str(port), str(trig), str(threads)], cwd=workdir,
+                              stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL, preexec_fn=pinned(server_cpus))
+    idle_conns = []
+    try:
+        if not wait_ready(port, server):
+            raise RuntimeError("server did not start on port %d" % port)
+        idle_conns = open_idle(port, idle)
+        out = os.path.join(workdir, "load.json")
+        cmd = [LOAD_GEN, "-t", str(args.lg_threads), "-c", str(args.connections), "-d", str(args.duration),
+               "-w", str(args.warmup), "-j", out] + spec["args"] + ["http://127.0.0.1:%d%s" % (port, spec["path"])]
+        load = subprocess.Popen(cmd, stdout=subprocess.DEVNULL, preexec_fn=pinned(lg_cpus))
+        # the server cpu is sampled over the measurement only, the warmup is left out
+        time.sleep(args.warmup)
+        start = cpu_ticks(server.pid)
+        load.wait()
+        cpu = cpu_ticks(server.pid) - start
+        rss = rss_kb(server.pid)
+        with open(out) as f:
+            result = json.load(f)
+    finally:
+        for conn in idle_conns:
+            conn.close()
+        server.terminate()
+        server.wait()
+        shutil.rmtree(workdir, ignore_errors=True)
+
+    responses = max(result["responses"], 1)
+    latency = result["latency_us"]
+    return {
+        "rps": result["rps"],
+        "p50_us": latency["p50"],
+        "p99_us": latency["p99"],
+        "p999_us": latency["p999"],
+        "rss_kb": rss,
+        "cpu_us_per_req": round(cpu * 1e6 / os.sysconf("SC_CLK_TCK") / responses, 2),
+        "errors": sum(result["errors"].values()),
+        "idle": len(idle_conns),
+    }
+
+
+def check_machine(meta, baseline):
+    # numbers from another machine or another cpu split give no verdict, say so before the table
+    base_meta = baseline.get("meta", {})
+    warnings = 0
+    for key in ("host", "cpus", "server_cpus", "lg_cpus"):
+        if base_meta.get(key) != meta.get(key):
+            print("warning: baseline %s is %s, this run %s" % (key, base_meta.get(key), meta.get(key)))
+            warnings += 1
+    if not base_meta.get("server_cpus"):
+        print("warning: the baseline was recorded with the server and the load generator on the same cpus")
+        warnings += 1
+    if warnings:
+        print("warning: the comparison below is only meaningful on the machine and cpu split of the baseline, "
+              "record a baseline here with --update-baseline")
+    return warnings
+
+
+def compare(cases, baseline):
+    tolerance = dict(DEFAULT_TOLERANCE, **baseline.get("tolerance", {}))
+    base_cases = baseline.get("cases", {})
+    regressions = 0
+    print("\n%-28s %-15s %12s %12s %9s  %s" % ("case", "metric", "baseline", "current", "change", "verdict"))
+    for key, current in sorted(cases.items()):
+        base = base_cases.get(key)
+        if base is None:
+            print("%-28s %-15s %12s %12s %9s  %s" % (key, "-", "-", "-", "-", "new case"))
+            continue
+        for metric, allowed in sorted(tolerance.items()):
+            old, new = base.get(metric), current.get(metric)
+            if not old or new is None:
+                continue
+            change = (new - old) / old
+            worse = -change if metric in HIGHER_IS_BETTER else change
+            verdict = "REGRESSION" if worse > allowed else ("better" if -worse > allowed else "ok")
+            regressions += verdict == "REGRESSION"
+            print("%-28s %-15s %12.1f %12.1f %+8.1f%%  %s" % (key, metric, old, new, change * 100, verdict))
+        if current["errors"] > base.get("errors", 0):
+            regressions += 1
+            print("%-28s %-15s %12d %12d %9s  %s" % (key, "errors", base.get("errors", 0), current["errors"], "", "REGRESSION"))
+    return regressions
+
+
+def main():
+    args = parse_args()
+    # idle floods need more descriptors than the usual soft limit, the server inherits it
+    soft, hard = resource.getrlimit(resource.RLIMIT_NOFILE)
+    resource.setrlimit(resource.RLIMIT_NOFILE, (hard, hard))
+    if not args.no_build:
+        build(args.make_arg)
+    server_cpus, lg_cpus = pick_cpus(args)
+
+    cases = {}
+    for threads in [int(t) for t in args.threads.split(",")]:
+        for trig in [int(m) for m in args.trig.split(",")]:
+            for workload in args.workloads.split(","):
+                key = "%s/t%d/m%d" % (workload, threads, trig)
+                cases[key] = run_case(args, workload, threads, trig, server_cpus, lg_cpus)
+                c = cases[key]
+                print("%-28s rps %10.1f  p50 %8.1fus  p99 %8.1fus  p999 %8.1fus  rss %7dKB  cpu %7.2fus/req  errors %d"
+                      % (key, c["rps"], c["p50_us"], c["p99_us"], c["p999_us"], c["rss_kb"], c["cpu_us_per_req"], c["errors"]),
+                      flush=True)
+
+    meta = {
+        "duration": args.duration,
+        "warmup": args.warmup,
+        "connections": args.connections,
+        "lg_threads": args.lg_threads,
+        "cpus": os.cpu_count(),
+        "host": socket.gethostname(),
+        "server_cpus": format_cpus(server_cpus),
+        "lg_cpus": format_cpus(lg_cpus),
+        "time": time.strftime("%Y-%m-%dT%H:%M:%S"),
+    }
+    with open(args.out, "w") as f:
+        json.dump({"meta": meta, "cases": cases}, f, indent=2, sort_keys=True)
+    print("\nresults written to %s" % args.out)
+
+    if args.no_compare:
+        return 0
+    baseline = {}
+    if os.path.exists(args.baseline):
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+    if args.update_baseline:
+        merged = dict(baseline.get("cases", {}), **cases)
+        with open(args.baseline, "w") as f:
+            json.dump({"meta": meta, "tolerance": baseline.get("tolerance", DEFAULT_TOLERANCE), "cases": merged},
+                      f, indent=2, sort_keys=True)
+            f.write("\n")
+        print("baseline %s updated" % args.baseline)
+        return 0
+    if not baseline:
+        print("no baseline at %s, run with --update-baseline to create one" % args.baseline)
+        return 0
+    check_machine(meta, baseline)
+    regressions = compare(cases, baseline)
+    print("\n%s: %d regression(s)" % ("FAIL" if regressions else "PASS", regressions))
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,39 @@
+//
+// Created by pyq on 10/19/26.
+//
+#include <cstdio>
+#include <cstdlib>
+#include "../../src/server/web_server.h"
+#ifdef SLIM_PGO_GEN
+#include <csignal>
+#include <unistd.h>
+
+extern "C" void __gcov_dump();
+
+// The server has no clean shutdown, the profile of an instrumented build is written when the harness stops it.
+void DumpProfile(int) {
+    __gcov_dump();
+    _exit(0);
+}
+#endif
+
+/* Server of the regression harness (bench/regress/regress.py), it needs no MySql server */
+/* usage: slim-regress-server port trigMode threadNum [timeoutMs] */
+/* the embedded user store keeps its data in ./data, resources are served from ./resources */
+/* logs and the slow request log are off so that they do not skew the results */
+
+int main(int argc, char* argv[]) {
+    if (argc < 4) {
+        fprintf(stderr, "usage: %s port trigMode threadNum [timeoutMs]\n", argv[0]);
+        return 1;
+    }
+#ifdef SLIM_PGO_GEN
+    signal(SIGTERM, DumpProfile);
+#endif
+    WebServer server (
+        atoi(argv[1]), atoi(argv[2]), argc > 4 ? atoi(argv[4]) : 60000, false,
+        3306, "root", "", "slimwebserver",
+        1, atoi(argv[3]), false, 1, 0,
+        10000, UserStore::EMBEDDED_BACKEND, nullptr, "/metrics", 0);
+    server.Start();
+}
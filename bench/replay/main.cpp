@@ -0,0 +1,180 @@
+//
+// Created by pyq on 10/19/26.
+//
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <getopt.h>
+#include "replay.h"
+
+namespace {
+
+const double PERCENTILES[] = {50, 75, 90, 99, 99.9, 99.99};
+const char* PERCENTILE_KEYS[] = {"p50", "p75", "p90", "p99", "p999", "p9999"};
+
+void Usage() {
+    fprintf(stderr,
+        "Usage: slim-replay [options] capture-file http://host:port\n"
+        "  -s, --speed X          time scale, 1 real time, 2 twice as fast, 0 as fast as possible (default 1)\n"
+        "  -t, --threads N        worker threads (default 1)\n"
+        "  -c, --connections N    captured connections replayed at once per thread at speed 0 (default 64)\n"
+        "  -T, --timeout MS       response timeout (default 5000)\n"
+        "  -j, --json FILE        write the results as JSON, - for stdout\n");
+}
+
+// Parses http://host[:port][/path], the port defaults to 80 and the path is ignored.
+bool ParseUrl(const std::string& url, std::string* host, int* port) {
+    if (url.compare(0, 7, "http://") != 0) {
+        return false;
+    }
+    std::string hostPort = url.substr(7, url.find('/', 7) - 7);
+    size_t colon = hostPort.find(':');
+    *host = hostPort.substr(0, colon);
+    *port = colon == std::string::npos ? 80 : atoi(hostPort.c_str() + colon + 1);
+    return !host->empty() && *port > 0 && *port < 65536;
+}
+
+void PrintHistogram(FILE* out, const char* name, const HdrHistogram& histogram) {
+    fprintf(out, "  %-8s mean %.3fms  stdev %.3fms  max %.3fms\n          ",
+            name, histogram.Mean() / 1e6, histogram.Stdev() / 1e6, histogram.Max() / 1e6);
+    for (size_t i = 0; i < sizeof(PERCENTILES) / sizeof(PERCENTILES[0]); ++i) {
+        fprintf(out, "  %g%% %.3fms", PERCENTILES[i], histogram.Percentile(PERCENTILES[i]) / 1e6);
+    }
+    fprintf(out, "\n");
+}
+
+void PrintText(FILE* out, const Replay::Config& config, const Replay::Result& result) {
+    fprintf(out, "%llu connections, %llu connects, %llu of %llu responses in %.2fs, %.2fMB read\n",
+            (unsigned long long)result.sessions, (unsigned long long)result.connects,
+            (unsigned long long)result.responses, (unsigned long long)result.requests,
+            result.seconds, result.bytesIn / 1048576.0);
+    PrintHistogram(out, "Latency", result.latency);
+    if (config.speed > 0) {
+        PrintHistogram(out, "Lag", result.lag);
+    }
+    fprintf(out, "  Codes");
+    for (auto& code : result.codes) {
+        fprintf(out, "  %d: %llu", code.first, (unsigned long long)code.second);
+    }
+    fprintf(out, "\n  Differ from capture  code %llu, size %llu\n",
+            (unsigned long long)result.codeMismatches, (unsigned long long)result.sizeMismatches);
+    fprintf(out, "  Errors  connect %llu, read %llu, write %llu, timeout %llu, bad response %llu\n",
+            (unsigned long long)result.connectErrors, (unsigned long long)result.readErrors,
+            (unsigned long long)result.writeErrors, (unsigned long long)result.timeouts,
+            (unsigned long long)result.badResponses);
+    fprintf(out, "Requests/sec: %.2f\n", result.responses / result.seconds);
+}
+
+void WriteHistogram(FILE* out, const char* key, const HdrHistogram& histogram) {
+    fprintf(out, "  \"%s\": {\"min\": %.1f, \"mean\": %.1f, \"stdev\": %.1f, \"max\": %.1f", key,
+            histogram.Min() / 1e3, histogram.Mean() / 1e3, histogram.Stdev() / 1e3, histogram.Max() / 1e3);
+    for (size_t i = 0; i < sizeof(PERCENTILES) / sizeof(PERCENTILES[0]); ++i) {
+        fprintf(out, ", \"%s\": %.1f", PERCENTILE_KEYS[i], histogram.Percentile(PERCENTILES[i]) / 1e3);
+    }
+    fprintf(out, "}");
+}
+
+void WriteJson(FILE* out, const std::string& capture, const std::string& url,
+               const Replay::Config& config, const Replay::Result& result) {
+    fprintf(out, "{\n  \"capture\": \"%s\",\n  \"url\": \"%s\",\n  \"speed\": %g,\n", capture.c_str(), url.c_str(), config.speed);
+    fprintf(out, "  \"connections\": %llu,\n  \"connects\": %llu,\n  \"requests\": %llu,\n  \"responses\": %llu,\n",
+            (unsigned long long)result.sessions, (unsigned long long)result.connects,
+            (unsigned long long)result.requests, (unsigned long long)result.responses);
+    fprintf(out, "  \"duration_s\": %.3f,\n  \"rps\": %.2f,\n  \"bytes_in\": %llu,\n",
+            result.seconds, result.responses / result.seconds, (unsigned long long)result.bytesIn);
+    fprintf(out, "  \"mismatches\": {\"code\": %llu, \"size\": %llu},\n",
+            (unsigned long long)result.codeMismatches, (unsigned long long)result.sizeMismatches);
+    fprintf(out, "  \"errors\": {\"connect\": %llu, \"read\": %llu, \"write\": %llu, \"timeout\": %llu, \"bad_response\": %llu},\n",
+            (unsigned long long)result.connectErrors, (unsigned long long)result.readErrors,
+            (unsigned long long)result.writeErrors, (unsigned long long)result.timeouts,
+            (unsigned long long)result.badResponses);
+    fprintf(out, "  \"codes\": {");
+    const char* sep = "";
+    for (auto& code : result.codes) {
+        fprintf(out, "%s\"%d\": %llu", sep, code.first, (unsigned long long)code.second);
+        sep = ", ";
+    }
+    fprintf(out, "},\n");
+    WriteHistogram(out, "latency_us", result.latency);
+    fprintf(out, ",\n");
+    WriteHistogram(out, "lag_us", result.lag);
+    fprintf(out, "\n}\n");
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    Replay::Config config;
+    config.speed = 1;
+    config.threads = 1;
+    config.maxOpen = 64;
+    config.timeoutMs = 5000;
+    const char* jsonFile = nullptr;
+
+    static const option OPTIONS[] = {
+        {"speed", required_argument, nullptr, 's'},
+        {"threads", required_argument, nullptr, 't'},
+        {"connections", required_argument, nullptr, 'c'},
+        {"timeout", required_argument, nullptr, 'T'},
+        {"json", required_argument, nullptr, 'j'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "s:t:c:T:j:h", OPTIONS, nullptr)) != -1) {
+        switch (opt) {
+            case 's': config.speed = atof(optarg); break;
+            case 't': config.threads = atoi(optarg); break;
+            case 'c': config.maxOpen = atoi(optarg); break;
+            case 'T': config.timeoutMs = atoi(optarg); break;
+            case 'j': jsonFile = optarg; break;
+            default: Usage(); return 1;
+        }
+    }
+    if (argc - optind != 2) {
+        Usage();
+        return 1;
+    }
+    std::string capture = argv[optind], url = argv[optind + 1];
+    if (!ParseUrl(url, &config.host, &config.port) || config.speed < 0 || config.threads <= 0 ||
+        config.maxOpen <= 0 || config.timeoutMs <= 0) {
+        Usage();
+        return 1;
+    }
+
+    Replay replay(config);
+    std::string error;
+    if (!replay.Load(capture.c_str(), &error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    // with the JSON on stdout the text summary goes to stderr
+    FILE* text = jsonFile && strcmp(jsonFile, "-") == 0 ? stderr : stdout;
+    char speed[32] = "max";
+    if (config.speed > 0) {
+        snprintf(speed, sizeof(speed), "%gx", config.speed);
+    }
+    fprintf(text, "Replaying %zu requests on %zu connections captured over %.1fs @ %s, speed %s\n",
+            replay.RequestNum(), replay.SessionNum(), replay.SpanSec(), url.c_str(), speed);
+    fflush(text);
+    Replay::Result result;
+    if (!replay.Run(&result)) {
+        fprintf(stderr, "can not resolve %s\n", config.host.c_str());
+        return 1;
+    }
+    PrintText(text, config, result);
+
+    if (jsonFile) {
+        FILE* out = strcmp(jsonFile, "-") == 0 ? stdout : fopen(jsonFile, "w");
+        if (!out) {
+            fprintf(stderr, "can not write %s\n", jsonFile);
+            return 1;
+        }
+        WriteJson(out, capture, url, config, result);
+        if (out != stdout) {
+            fclose(out);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,440 @@
+//
+// Created by pyq on 10/19/26.
+//
+#include "replay.h"
+#include <thread>
+#include <numeric>
+#include <algorithm>
+#include <unordered_map>
+#include <cerrno>
+#include <cstring>
+#include <netdb.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/tcp.h>
+
+Replay::Replay(const Config& config) : config_(config), baseUs_(0), endUs_(0), startNs_(0) {
+    memset(&addr_, 0, sizeof(addr_));
+    if (config_.threads <= 0) {
+        config_.threads = 1;
+    }
+    if (config_.maxOpen <= 0) {
+        config_.maxOpen = 1;
+    }
+}
+
+bool Replay::Load(const char* path, std::string* error) {
+    TrafficCapture::Reader reader;
+    if (!reader.Open(path)) {
+        *error = std::string("can not read the capture ") + path;
+        return false;
+    }
+    records_.clear();
+    sessions_.clear();
+    baseUs_ = UINT64_MAX;
+    endUs_ = 0;
+    std::unordered_map<uint64_t, uint32_t> sessionOf;
+    TrafficCapture::Record record;
+    while (reader.Next(&record)) {
+        auto it = sessionOf.find(record.connId);
+        if (it == sessionOf.end()) {
+            it = sessionOf.emplace(record.connId, sessions_.size()).first;
+            sessions_.emplace_back();
+            Session& session = sessions_.back();
+            // a connection whose first request fell before the capture starts at its first recorded one
+            session.startUs = (record.flags & TrafficCapture::FIRST) ? record.acceptUs : record.arrivalUs;
+            session.next = 0;
+            session.fd = -1;
+            session.connecting = false;
+            session.watchOut = false;
+            session.inFlight = false;
+            session.sentAt = 0;
+            session.receivedBytes = 0;
+            session.outOffset = 0;
+            baseUs_ = std::min(baseUs_, session.startUs);
+        }
+        sessions_[it->second].records.push_back(records_.size());
+        endUs_ = std::max(endUs_, record.arrivalUs);
+        records_.push_back(std::move(record));
+    }
+    if (records_.empty()) {
+        *error = std::string("no request in the capture ") + path;
+        return false;
+    }
+    return true;
+}
+
+size_t Replay::RequestNum() const {
+    return records_.size();
+}
+
+size_t Replay::SessionNum() const {
+    return sessions_.size();
+}
+
+double Replay::SpanSec() const {
+    return records_.empty() ? 0 : (endUs_ - baseUs_) / 1e6;
+}
+
+bool Replay::Run(Result* result) {
+    if (!Resolve_() || sessions_.empty()) {
+        return false;
+    }
+
+    // captured connections in order of their start, dealt to the threads in turn
+    std::vector<uint32_t> order(sessions_.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+        return sessions_[a].startUs < sessions_[b].startUs;
+    });
+    std::vector<Worker> workers(config_.threads);
+    for (size_t i = 0; i < order.size(); ++i) {
+        workers[i % config_.threads].sessions.push_back(order[i]);
+    }
+
+    startNs_ = LoadGen::NowNs();
+    std::vector<std::thread> threads;
+    for (auto& worker : workers) {
+        threads.emplace_back(&Replay::Work_, this, &worker);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    *result = Result();
+    for (auto& worker : workers) {
+        Result& part = worker.result;
+        result->connects += part.connects;
+        result->requests += part.requests;
+        result->responses += part.responses;
+        result->bytesIn += part.bytesIn;
+        result->connectErrors += part.connectErrors;
+        result->readErrors += part.readErrors;
+        result->writeErrors += part.writeErrors;
+        result->timeouts += part.timeouts;
+        result->badResponses += part.badResponses;
+        result->codeMismatches += part.codeMismatches;
+        result->sizeMismatches += part.sizeMismatches;
+        for (auto& code : part.codes) {
+            result->codes[code.first] += code.second;
+        }
+        result->latency.Merge(part.latency);
+        result->lag.Merge(part.lag);
+    }
+    result->sessions = sessions_.size();
+    result->seconds = (LoadGen::NowNs() - startNs_) / 1e9;
+    return true;
+}
+
+void Replay::Work_(Worker* worker) {
+    worker->epollFd = epoll_create1(EPOLL_CLOEXEC);
+    worker->nextStart = 0;
+    worker->open = 0;
+    worker->finished = 0;
+
+    epoll_event events[256];
+    uint64_t timeoutNs = config_.timeoutMs * 1000000ULL;
+    size_t total = worker->sessions.size();
+    uint64_t now = LoadGen::NowNs();
+    uint64_t lastScan = now;
+    while (worker->finished < total) {
+        // start the captured connections whose time came, at speed 0 up to maxOpen at once
+        bool canStart = false;
+        while (worker->nextStart < total && (config_.speed > 0 || worker->open < (size_t)config_.maxOpen)) {
+            uint32_t id = worker->sessions[worker->nextStart];
+            if (DueNs_(sessions_[id].startUs) > now) {
+                canStart = true;
+                break;
+            }
+            ++worker->nextStart;
+            ++worker->open;
+            // connect at the captured accept time, a failure is retried by the first request
+            Connect_(worker, id);
+            Schedule_(worker, id, now);
+        }
+        while (!worker->due.empty() && worker->due.top().first <= now) {
+            uint32_t id = worker->due.top().second;
+            worker->due.pop();
+            Send_(worker, id, now);
+        }
+        if (now - lastScan >= TIMEOUT_SCAN_NS) {
+            lastScan = now;
+            for (size_t i = 0; i < worker->nextStart; ++i) {
+                uint32_t id = worker->sessions[i];
+                if (sessions_[id].inFlight && now - sessions_[id].sentAt > timeoutNs) {
+                    Fail_(worker, id, &worker->result.timeouts, now);
+                }
+            }
+        }
+
+        // sleep until the next start or request is due, the timeout scan runs at least every 100ms;
+        // the wait is rounded down and the last millisecond polled so requests are not sent late
+        uint64_t wake = now + TIMEOUT_SCAN_NS;
+        if (canStart) {
+            wake = std::min(wake, DueNs_(sessions_[worker->sessions[worker->nextStart]].startUs));
+        }
+        if (!worker->due.empty()) {
+            wake = std::min(wake, worker->due.top().first);
+        }
+        int waitMs = wake > now ? (wake - now) / 1000000 : 0;
+        int eventCnt = worker->finished < total ? epoll_wait(worker->epollFd, events, 256, waitMs) : 0;
+        now = LoadGen::NowNs();
+        for (int i = 0; i < eventCnt; ++i) {
+            uint32_t id = events[i].data.u32;
+            Session& session = sessions_[id];
+            int fd = session.fd;
+            if (fd < 0) {
+                continue;
+            }
+            if (session.connecting) {
+                int error = 0;
+                socklen_t len = sizeof(error);
+                getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len);
+                if (error != 0 || (events[i].events & (EPOLLERR | EPOLLHUP))) {
+                    if (session.inFlight) {
+                        Fail_(worker, id, &worker->result.connectErrors, now);
+                    } else {
+                        // the connect at the accept time failed, the first request tries again
+                        ++worker->result.connectErrors;
+                        Close_(worker, &session);
+                    }
+                    continue;
+                }
+                session.connecting = false;
+                ++worker->result.connects;
+                if (!Flush_(worker, id)) {
+                    Fail_(worker, id, &worker->result.writeErrors, now);
+                }
+                continue;
+            }
+            if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+                Receive_(worker, id);
+            }
+            // the connection may have been closed by the response
+            if (session.fd == fd && (events[i].events & EPOLLOUT) && !Flush_(worker, id)) {
+                Fail_(worker, id, &worker->result.writeErrors, now);
+            }
+        }
+    }
+    close(worker->epollFd);
+}
+
+uint64_t Replay::DueNs_(uint64_t capturedUs) const {
+    if (config_.speed <= 0) {
+        return 0;
+    }
+    return startNs_ + (uint64_t)((capturedUs - baseUs_) * 1000.0 / config_.speed);
+}
+
+void Replay::Schedule_(Worker* worker, uint32_t id, uint64_t now) {
+    const Session& session = sessions_[id];
+    uint64_t due = DueNs_(records_[session.records[session.next]].arrivalUs);
+    worker->due.push(std::make_pair(std::max(due, now), id));
+}
+
+void Replay::Send_(Worker* worker, uint32_t id, uint64_t now) {
+    Session& session = sessions_[id];
+    if (session.fd < 0 && !Connect_(worker, id)) {
+        Fail_(worker, id, &worker->result.connectErrors, now);
+        return;
+    }
+    session.inFlight = true;
+    session.sentAt = now;
+    session.receivedBytes = 0;
+    session.outOffset = 0;
+    session.parser.Reset();
+    ++worker->result.requests;
+    if (config_.speed > 0) {
+        uint64_t due = DueNs_(records_[session.records[session.next]].arrivalUs);
+        worker->result.lag.Record(now > due ? now - due : 0);
+    }
+    if (!session.connecting && !Flush_(worker, id)) {
+        Fail_(worker, id, &worker->result.writeErrors, now);
+    }
+}
+
+bool Replay::Connect_(Worker* worker, uint32_t id) {
+    Session& session = sessions_[id];
+    session.connecting = false;
+    session.watchOut = false;
+    session.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (session.fd < 0) {
+        return false;
+    }
+    int on = 1;
+    setsockopt(session.fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    if (connect(session.fd, (sockaddr*)&addr_, sizeof(addr_)) < 0) {
+        if (errno != EINPROGRESS) {
+            close(session.fd);
+            session.fd = -1;
+            return false;
+        }
+        session.connecting = true;
+    }
+    epoll_event event = {0};
+    event.events = EPOLLIN | (session.connecting ? EPOLLOUT : 0);
+    event.data.u32 = id;
+    session.watchOut = session.connecting;
+    epoll_ctl(worker->epollFd, EPOLL_CTL_ADD, session.fd, &event);
+    if (!session.connecting) {
+        ++worker->result.connects;
+    }
+    return true;
+}
+
+void Replay::Close_(Worker* worker, Session* session) {
+    if (session->fd < 0) {
+        return;
+    }
+    epoll_ctl(worker->epollFd, EPOLL_CTL_DEL, session->fd, nullptr);
+    close(session->fd);
+    session->fd = -1;
+    session->connecting = false;
+    session->watchOut = false;
+}
+
+void Replay::Fail_(Worker* worker, uint32_t id, uint64_t* errorCounter, uint64_t now) {
+    Session& session = sessions_[id];
+    ++*errorCounter;
+    Close_(worker, &session);
+    session.inFlight = false;
+    Advance_(worker, id, now);
+}
+
+bool Replay::Flush_(Worker* worker, uint32_t id) {
+    Session& session = sessions_[id];
+    const std::string& request = records_[session.records[session.next]].request;
+    while (session.inFlight && session.outOffset < request.size()) {
+        ssize_t len = write(session.fd, request.data() + session.outOffset, request.size() - session.outOffset);
+        if (len < 0) {
+            if (errno == EAGAIN) {
+                break;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        session.outOffset += len;
+    }
+    Watch_(worker, &session);
+    return true;
+}
+
+void Replay::Receive_(Worker* worker, uint32_t id) {
+    Session& session = sessions_[id];
+    char buf[65536];
+    while (true) {
+        ssize_t len = read(session.fd, buf, sizeof(buf));
+        uint64_t now = LoadGen::NowNs();
+        if (len < 0 && errno == EINTR) {
+            continue;
+        }
+        if (len < 0 && errno == EAGAIN) {
+            return;
+        }
+        if (len <= 0) {
+            Close_(worker, &session);
+            if (!session.inFlight) {
+                // an idle keep-alive connection closed by the server, the next request reconnects
+                return;
+            }
+            // a response delimited by the end of the connection is complete now
+            if (len == 0 && session.parser.Eof()) {
+                Complete_(worker, id, now);
+            } else {
+                Fail_(worker, id, &worker->result.readErrors, now);
+            }
+            return;
+        }
+        worker->result.bytesIn += len;
+        int fd = session.fd;
+        for (ssize_t offset = 0; offset < len;) {
+            if (!session.inFlight) {
+                // a response nobody asked for
+                ++worker->result.badResponses;
+                Close_(worker, &session);
+                return;
+            }
+            bool done = false;
+            long used = session.parser.Feed(buf + offset, len - offset, &done);
+            if (used < 0) {
+                Fail_(worker, id, &worker->result.badResponses, now);
+                return;
+            }
+            offset += used;
+            session.receivedBytes += used;
+            if (done) {
+                Complete_(worker, id, now);
+                if (session.fd != fd) {
+                    return;
+                }
+            }
+        }
+    }
+}
+
+void Replay::Complete_(Worker* worker, uint32_t id, uint64_t now) {
+    Session& session = sessions_[id];
+    const TrafficCapture::Record& record = records_[session.records[session.next]];
+    Result& result = worker->result;
+    int code = session.parser.Code();
+    ++result.responses;
+    ++result.codes[code];
+    result.latency.Record(now - session.sentAt);
+    if (record.code != 0 && code != record.code) {
+        ++result.codeMismatches;
+    }
+    if (record.responseBytes != 0 && session.receivedBytes != record.responseBytes) {
+        ++result.sizeMismatches;
+    }
+    bool keepAlive = session.parser.KeepAlive();
+    session.inFlight = false;
+    session.parser.Reset();
+    if (!keepAlive) {
+        Close_(worker, &session);
+    }
+    Advance_(worker, id, now);
+}
+
+void Replay::Watch_(Worker* worker, Session* session) {
+    bool watchOut = session->connecting ||
+                    (session->inFlight && session->outOffset < records_[session->records[session->next]].request.size());
+    if (session->fd < 0 || watchOut == session->watchOut) {
+        return;
+    }
+    epoll_event event = {0};
+    event.events = EPOLLIN | (watchOut ? EPOLLOUT : 0);
+    event.data.u32 = session - sessions_.data();
+    epoll_ctl(worker->epollFd, EPOLL_CTL_MOD, session->fd, &event);
+    session->watchOut = watchOut;
+}
+
+void Replay::Advance_(Worker* worker, uint32_t id, uint64_t now) {
+    Session& session = sessions_[id];
+    if (++session.next < session.records.size()) {
+        Schedule_(worker, id, now);
+        return;
+    }
+    Close_(worker, &session);
+    --worker->open;
+    ++worker->finished;
+}
+
+bool Replay::Resolve_() {
+    if (addr_.sin_port != 0) {
+        return true;
+    }
+    addrinfo hints, *info = nullptr;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(config_.host.c_str(), nullptr, &hints, &info) != 0 || !info) {
+        return false;
+    }
+    addr_ = *(sockaddr_in*)info->ai_addr;
+    addr_.sin_port = htons(config_.port);
+    freeaddrinfo(info);
+    return true;
+}
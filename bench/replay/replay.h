@@ -0,0 +1,150 @@
+//
+// Created by pyq on 10/19/26.
+//
+#pragma once
+#ifndef SLIM_WEB_SERVER_REPLAY_H
+#define SLIM_WEB_SERVER_REPLAY_H
+
+#include <map>
+#include <queue>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <netinet/in.h>
+#include "../load_gen/load_gen.h"
+#include "../../src/capture/traffic_capture.h"
+
+// Plays a traffic capture back against a server.
+// Every captured connection becomes a client connection sending its requests in their captured order,
+// one at a time, each no earlier than its captured arrival time divided by the speed. A connection the
+// server closes is reopened for the next request of the captured connection.
+// At speed 0 (as fast as possible) the requests only wait for the previous response and at most
+// maxOpen captured connections are replayed at once.
+class Replay {
+public:
+    // Run configuration.
+    struct Config {
+        std::string host;       // Server address, IPv4 or a host name.
+        int port;               // Server port.
+        double speed;           // Time scale, 1 replays in real time, 0 as fast as possible.
+        int threads;            // Worker threads, the captured connections are spread over them.
+        int maxOpen;            // Connections replayed at once per thread at speed 0.
+        int timeoutMs;          // A response slower than this counts as a timeout and closes the connection.
+    };
+
+    // Results of a run, summed over the threads.
+    struct Result {
+        uint64_t sessions;          // Captured connections replayed.
+        uint64_t connects;          // Connections opened.
+        uint64_t requests;          // Requests sent.
+        uint64_t responses;         // Responses completed.
+        uint64_t bytesIn;           // Bytes received.
+        uint64_t connectErrors;     // Failed connects.
+        uint64_t readErrors;        // Connections reset or closed with a request in flight.
+        uint64_t writeErrors;       // Failed writes.
+        uint64_t timeouts;          // Responses slower than timeoutMs.
+        uint64_t badResponses;      // Malformed responses.
+        uint64_t codeMismatches;    // Responses whose status code differs from the capture.
+        uint64_t sizeMismatches;    // Responses whose size differs from the capture.
+        double seconds;             // Length of the replay.
+        std::map<int, uint64_t> codes;  // Responses by status code.
+        HdrHistogram latency;       // Time from sending a request to its complete response in nanoseconds.
+        HdrHistogram lag;           // Time a request was sent after its scheduled time in nanoseconds.
+    };
+
+    explicit Replay(const Config& config);
+
+    // Reads a capture file, returns false with an error message if it can not be read.
+    bool Load(const char* path, std::string* error);
+
+    // Returns the number of requests loaded.
+    size_t RequestNum() const;
+
+    // Returns the number of captured connections loaded.
+    size_t SessionNum() const;
+
+    // Returns the captured time span in seconds, from the first accept to the last arrival.
+    double SpanSec() const;
+
+    // Replays the capture, returns false if the address can not be resolved.
+    bool Run(Result* result);
+
+private:
+    // State of one captured connection.
+    struct Session {
+        std::vector<uint32_t> records;  // Requests of the connection in captured order.
+        uint64_t startUs;               // Captured accept time, or arrival of its first request.
+        size_t next;                    // Index into records of the request to send or in flight.
+        int fd;                         // Socket, -1 while not connected.
+        bool connecting;                // Non blocking connect in progress.
+        bool watchOut;                  // EPOLLOUT is part of the epoll interest.
+        bool inFlight;                  // records[next] was sent and its response is awaited.
+        uint64_t sentAt;                // Time records[next] was sent.
+        uint64_t receivedBytes;         // Bytes of the current response.
+        size_t outOffset;               // Bytes of the current request already written.
+        ResponseParser parser;          // Parser of the current response.
+    };
+
+    // Captured connections and counters of one worker thread.
+    struct Worker {
+        int epollFd;                        // Epoll of the thread's connections.
+        std::vector<uint32_t> sessions;     // Captured connections of the thread ordered by start time.
+        size_t nextStart;                   // Index into sessions of the next one to start.
+        size_t open;                        // Started and not yet finished.
+        size_t finished;                    // Finished.
+        std::priority_queue<std::pair<uint64_t, uint32_t>, std::vector<std::pair<uint64_t, uint32_t>>,
+                            std::greater<std::pair<uint64_t, uint32_t>>> due;     // Requests waiting for their time.
+        Result result;                      // Results of the thread.
+    };
+
+    static const uint64_t TIMEOUT_SCAN_NS = 100000000ULL;  // Interval of the response timeout scan.
+
+    Config config_;                             // Run configuration.
+    sockaddr_in addr_;                          // Resolved server address.
+    std::vector<TrafficCapture::Record> records_;   // Requests of the capture in file order.
+    std::vector<Session> sessions_;             // Captured connections.
+    uint64_t baseUs_;                           // Earliest captured time, replayed at the start.
+    uint64_t endUs_;                            // Latest captured arrival.
+    uint64_t startNs_;                          // Start of the replay.
+
+    // Body of a worker thread.
+    void Work_(Worker* worker);
+
+    // Returns the time a captured time is replayed at, 0 at speed 0.
+    uint64_t DueNs_(uint64_t capturedUs) const;
+
+    // Queues the next request of a session until it is due, the worker loop sends it.
+    void Schedule_(Worker* worker, uint32_t id, uint64_t now);
+
+    // Sends records[next] of a session, connecting first if needed.
+    void Send_(Worker* worker, uint32_t id, uint64_t now);
+
+    // Starts a non blocking connect, returns false if it failed at once.
+    bool Connect_(Worker* worker, uint32_t id);
+
+    // Closes the socket of a session.
+    void Close_(Worker* worker, Session* session);
+
+    // Gives up on the request in flight after an error counted in errorCounter and moves on.
+    void Fail_(Worker* worker, uint32_t id, uint64_t* errorCounter, uint64_t now);
+
+    // Writes as much of the request as the socket takes, returns false on error.
+    bool Flush_(Worker* worker, uint32_t id);
+
+    // Reads and parses the response of a session.
+    void Receive_(Worker* worker, uint32_t id);
+
+    // Records the response in flight and schedules the next request.
+    void Complete_(Worker* worker, uint32_t id, uint64_t now);
+
+    // Adds EPOLLOUT to the epoll interest while a request is not fully written or a connect is pending.
+    void Watch_(Worker* worker, Session* session);
+
+    // Moves to the next request of a session, or finishes the session after its last one.
+    void Advance_(Worker* worker, uint32_t id, uint64_t now);
+
+    // Resolves the server address, returns false if it can not be resolved.
+    bool Resolve_();
+};
+
+#endif //SLIM_WEB_SERVER_REPLAY_H
@@ -0,0 +1,179 @@
+//
+// Created by pyq on 10/19/26.
+//
+#include "admin_server.h"
+#include <sstream>
+
+AdminServer::AdminServer() : listenFd_(-1), wakeFd_{-1, -1} {}
+
+AdminServer::~AdminServer() {
+    Stop();
+}
+
+void AdminServer::AddCommand(const std::string& name, const std::string& usage, const CommandCallBack& cb) {
+    std::lock_guard<std::mutex> locker(mutex_);
+    commands_[name] = Command{usage, cb};
+}
+
+bool AdminServer::Start(const char* path) {
+    assert(path && listenFd_ < 0);
+    sockaddr_un addr;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        LOG_ERROR("Admin Socket Path Too Long: %s", path);
+        return false;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+
+    listenFd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0) {
+        LOG_ERROR("Create Admin Socket Error!");
+        return false;
+    }
+    // a stale socket of a previous run would make bind fail
+    unlink(path);
+    if (bind(listenFd_, (sockaddr*)&addr, sizeof(addr)) < 0 || chmod(path, 0600) < 0 || listen(listenFd_, 4) < 0) {
+        LOG_ERROR("Bind Admin Socket %s Error: %s", path, strerror(errno));
+        close(listenFd_);
+        listenFd_ = -1;
+        return false;
+    }
+    if (pipe(wakeFd_) < 0) {
+        close(listenFd_);
+        listenFd_ = -1;
+        return false;
+    }
+    path_ = path;
+    thread_ = std::thread(&AdminServer::Loop_, this);
+    LOG_INFO("Admin Socket: %s", path);
+    return true;
+}
+
+void AdminServer::Stop() {
+    if (listenFd_ < 0) {
+        return;
+    }
+    ssize_t ret = write(wakeFd_[1], "x", 1);
+    (void)ret;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    close(listenFd_);
+    close(wakeFd_[0]);
+    close(wakeFd_[1]);
+    listenFd_ = -1;
+    unlink(path_.c_str());
+}
+
+void AdminServer::Loop_() {
+    while (true) {
+        pollfd fds[2] = {{listenFd_, POLLIN, 0}, {wakeFd_[0], POLLIN, 0}};
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("Admin Poll Error: %s", strerror(errno));
+            return;
+        }
+        if (fds[1].revents) {
+            return;
+        }
+        int fd = accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        LOG_INFO("Admin Session[%d] In", fd);
+        bool stop = !Serve_(fd);
+        close(fd);
+        LOG_INFO("Admin Session[%d] Quit", fd);
+        if (stop) {
+            return;
+        }
+    }
+}
+
+bool AdminServer::Serve_(int fd) {
+    std::string input;
+    char buf[1024];
+    while (true) {
+        pollfd fds[2] = {{fd, POLLIN, 0}, {wakeFd_[0], POLLIN, 0}};
+        int ret = poll(fds, 2, CLIENT_TIMEOUT_MS);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            return true;
+        }
+        if (fds[1].revents) {
+            return false;
+        }
+        ssize_t len = read(fd, buf, sizeof(buf));
+        if (len < 0 && errno == EINTR) {
+            continue;
+        }
+        if (len <= 0) {
+            return true;
+        }
+        input.append(buf, len);
+        std::string::size_type end;
+        while ((end = input.find('\n')) != std::string::npos) {
+            std::string line = input.substr(0, end);
+            input.erase(0, end + 1);
+            std::string reply = Execute_(line);
+            // the reply is small, a blocking write is fine on the admin thread
+            size_t written = 0;
+            while (written < reply.size()) {
+                ssize_t n = write(fd, reply.data() + written, reply.size() - written);
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (n <= 0) {
+                    return true;
+                }
+                written += n;
+            }
+        }
+        if (input.size() > MAX_LINE) {
+            return true;
+        }
+    }
+}
+
+std::string AdminServer::Execute_(const std::string& line) {
+    std::istringstream stream(line);
+    std::vector<std::string> args;
+    std::string word;
+    while (stream >> word) {
+        args.push_back(word);
+    }
+    if (args.empty()) {
+        return "";
+    }
+    std::string name = args[0];
+    args.erase(args.begin());
+
+    std::string out;
+    if (name == "help") {
+        std::lock_guard<std::mutex> locker(mutex_);
+        out += "help\n";
+        for (auto& command : commands_) {
+            out += command.second.usage + "\n";
+        }
+        return out + "OK\n";
+    }
+    CommandCallBack cb;
+    {
+        std::lock_guard<std::mutex> locker(mutex_);
+        auto it = commands_.find(name);
+        if (it == commands_.end()) {
+            return "ERR unknown command " + name + ", try help\n";
+        }
+        cb = it->second.cb;
+    }
+    LOG_INFO("Admin Command: %s", line.c_str());
+    if (!cb(args, out)) {
+        return "ERR " + out + "\n";
+    }
+    return out + "OK\n";
+}
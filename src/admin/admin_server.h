@@ -0,0 +1,73 @@
+//
+// Created by pyq on 10/19/26.
+//
+#pragma once
+#ifndef SLIM_WEB_SERVER_ADMIN_SERVER_H
+#define SLIM_WEB_SERVER_ADMIN_SERVER_H
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <thread>
+#include <functional>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include "../log/log.h"
+
+// Line based admin console on a Unix domain socket, served by its own thread so that
+// commands never pause the event loop. Every reply ends with a line "OK" or "ERR <reason>",
+// e.g. echo "threads 16" | socat - UNIX-CONNECT:./slim-admin.sock
+class AdminServer {
+public:
+    // Runs a command, writes the reply to out and returns false if the command failed.
+    using CommandCallBack = std::function<bool(const std::vector<std::string>& args, std::string& out)>;
+
+    AdminServer();
+
+    ~AdminServer();
+
+    // Registers a command, usage is shown by "help".
+    void AddCommand(const std::string& name, const std::string& usage, const CommandCallBack& cb);
+
+    // Listens on path (mode 0600, only the owner of the server may connect) and starts the admin thread.
+    bool Start(const char* path);
+
+    // Stops the admin thread and removes the socket.
+    void Stop();
+
+private:
+    static const int CLIENT_TIMEOUT_MS = 30000;     // Idle admin sessions are closed after this long.
+    static const size_t MAX_LINE = 4096;            // Longest accepted command line.
+
+    // A registered command.
+    struct Command {
+        std::string usage;
+        CommandCallBack cb;
+    };
+
+    std::string path_;                          // Path of the socket.
+    int listenFd_;                              // Listening socket.
+    int wakeFd_[2];                             // Pipe waking up the admin thread on Stop.
+    std::thread thread_;                        // Admin thread.
+    std::map<std::string, Command> commands_;   // Registered commands, sorted for help.
+    std::mutex mutex_;                          // Mutex protecting commands_.
+
+    AdminServer(const AdminServer& other) = delete;
+    AdminServer& operator=(const AdminServer& other) = delete;
+
+    // Accepts and serves admin sessions one at a time until Stop.
+    void Loop_();
+
+    // Serves the commands of one session, returns false if Stop was requested.
+    bool Serve_(int fd);
+
+    // Parses and runs one command line, returns the full reply.
+    std::string Execute_(const std::string& line);
+};
+
+#endif //SLIM_WEB_SERVER_ADMIN_SERVER_H
@@ -0,0 +1,160 @@
+//
+// Created by pyq on 10/19/26.
+//
+#include "auth_cache.h"
+
+AuthCache::AuthCache() : isOpen_(false), shardCapacity_(0), ttl_(0), negativeTtl_(0), seed_(0) {}
+
+AuthCache* AuthCache::Instance() {
+    static AuthCache instance;
+    return &instance;
+}
+
+void AuthCache::Init(size_t capacity, int ttlMs, int negativeTtlMs, size_t shardNum) {
+    assert(shardNum > 0 && ttlMs >= 0 && negativeTtlMs >= 0);
+    shards_.clear();
+    isOpen_ = capacity > 0;
+    if (!isOpen_) {
+        return;
+    }
+    shardCapacity_ = (capacity + shardNum - 1) / shardNum;
+    ttl_ = std::chrono::milliseconds(ttlMs);
+    negativeTtl_ = std::chrono::milliseconds(negativeTtlMs);
+    std::random_device rd;
+    seed_ = (static_cast<uint64_t>(rd()) << 32) | rd();
+    for (size_t i = 0; i < shardNum; ++i) {
+        shards_.emplace_back(new Shard());
+    }
+}
+
+int AuthCache::CheckLogin(const std::string& name, const std::string& pwd) {
+    if (!isOpen_) {
+        return MISS;
+    }
+    Shard& shard = GetShard_(name);
+    std::lock_guard<std::mutex> locker(shard.mutex);
+    Entry* entry = Find_(shard, name);
+    if (!entry) {
+        return MISS;
+    }
+    if (!entry->exists) {
+        return HIT_FAIL;
+    }
+    // a different password may have been changed in the database, 
+    // so only a match is answered from the cache
+    if (entry->hasPwd && entry->pwdHash == HashPwd_(pwd)) {
+        return HIT_OK;
+    }
+    return MISS;
+}
+
+int AuthCache::CheckRegister(const std::string& name) {
+    if (!isOpen_) {
+        return MISS;
+    }
+    Shard& shard = GetShard_(name);
+    std::lock_guard<std::mutex> locker(shard.mutex);
+    Entry* entry = Find_(shard, name);
+    // an absent user name still has to be inserted into the database
+    if (entry && entry->exists) {
+        return HIT_FAIL;
+    }
+    return MISS;
+}
+
+void AuthCache::OnLoginVerified(const std::string& name, const std::string& pwd) {
+    if (!isOpen_) {
+        return;
+    }
+    Shard& shard = GetShard_(name);
+    std::lock_guard<std::mutex> locker(shard.mutex);
+    Put_(shard, {name, true, true, HashPwd_(pwd), Clock::now() + ttl_});
+}
+
+void AuthCache::OnUserExists(const std::string& name) {
+    if (!isOpen_) {
+        return;
+    }
+    Shard& shard = GetShard_(name);
+    std::lock_guard<std::mutex> locker(shard.mutex);
+    Entry* entry = Find_(shard, name);
+    if (entry && entry->exists) {
+        // keep the verified password hash
+        entry->expires = Clock::now() + ttl_;
+        return;
+    }
+    Put_(shard, {name, true, false, 0, Clock::now() + ttl_});
+}
+
+void AuthCache::OnUserAbsent(const std::string& name) {
+    if (!isOpen_) {
+        return;
+    }
+    Shard& shard = GetShard_(name);
+    std::lock_guard<std::mutex> locker(shard.mutex);
+    Entry* entry = Find_(shard, name);
+    if (entry && entry->exists) {
+        // users are never deleted, so a positive entry is newer than this lookup,
+        // e.g. a register that finished while a slow login was reading NOT_FOUND
+        return;
+    }
+    Put_(shard, {name, false, false, 0, Clock::now() + negativeTtl_});
+}
+
+void AuthCache::OnRegistered(const std::string& name, const std::string& pwd) {
+    // the inserted row is the source of truth, so the entry is the same as a verified login
+    OnLoginVerified(name, pwd);
+}
+
+void AuthCache::Clear() {
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> locker(shard->mutex);
+        shard->index.clear();
+        shard->lru.clear();
+    }
+}
+
+bool AuthCache::IsOpen() const {
+    return isOpen_;
+}
+
+AuthCache::Shard& AuthCache::GetShard_(const std::string& name) {
+    return *shards_[std::hash<std::string>()(name) % shards_.size()];
+}
+
+AuthCache::Entry* AuthCache::Find_(Shard& shard, const std::string& name) {
+    auto it = shard.index.find(name);
+    if (it == shard.index.end()) {
+        return nullptr;
+    }
+    if (it->second->expires <= Clock::now()) {
+        // expired entries are dropped lazily on lookup
+        shard.lru.erase(it->second);
+        shard.index.erase(it);
+        return nullptr;
+    }
+    // move the entry to the front of the LRU list
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    return &shard.lru.front();
+}
+
+void AuthCache::Put_(Shard& shard, Entry&& entry) {
+    auto it = shard.index.find(entry.name);
+    if (it != shard.index.end()) {
+        *it->second = std::move(entry);
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        return;
+    }
+    shard.lru.push_front(std::move(entry));
+    shard.index[shard.lru.front().name] = shard.lru.begin();
+    while (shard.lru.size() > shardCapacity_) {
+        // evict the least recently used entry
+        shard.index.erase(shard.lru.back().name);
+        shard.lru.pop_back();
+    }
+}
+
+uint64_t AuthCache::HashPwd_(const std::string& pwd) const {
+    // seeded FNV-1a followed by a splitmix64 finalizer
+    return Hash::Mix64(Hash::Fnv1a64(pwd.data(), pwd.size(), seed_));
+}
@@ -0,0 +1,109 @@
+//
+// Created by pyq on 10/19/26.
+//
+#pragma once
+#ifndef SLIM_WEB_SERVER_AUTH_CACHE_H
+#define SLIM_WEB_SERVER_AUTH_CACHE_H
+
+#include <list>
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <random>
+#include <cassert>
+#include <cstdint>
+#include <unordered_map>
+#include "../hash/hash.h"
+
+// Sharded LRU cache with TTL that sits in front of UserVerify. 
+// It remembers known user names (and the hash of passwords verified by the database) 
+// as well as user names known to be absent, so most auth checks skip the database round trip.
+class AuthCache {
+public:
+    // Enumerates the results of a cache lookup.
+    enum LOOKUP {
+        MISS = 0,   // Nothing is known, the database must be consulted.
+        HIT_OK,     // The check is known to succeed.
+        HIT_FAIL,   // The check is known to fail.
+    };
+
+    // Singleton instance access method.
+    static AuthCache* Instance();
+
+    // Initializes the cache, capacity 0 disables it.
+    void Init(size_t capacity = 10000, int ttlMs = 60000, int negativeTtlMs = 5000, size_t shardNum = 16);
+
+    // Checks a login request: HIT_OK if the password matches the verified one, HIT_FAIL if the user is known absent.
+    int CheckLogin(const std::string& name, const std::string& pwd);
+
+    // Checks a register request: HIT_FAIL if the user name is known to be taken.
+    int CheckRegister(const std::string& name);
+
+    // Records a password the database has just verified.
+    void OnLoginVerified(const std::string& name, const std::string& pwd);
+
+    // Records that the user name exists without knowing its password.
+    void OnUserExists(const std::string& name);
+
+    // Records that the user name does not exist (negative caching), a live positive entry is kept.
+    void OnUserAbsent(const std::string& name);
+
+    // Write-through after a successful registration.
+    void OnRegistered(const std::string& name, const std::string& pwd);
+
+    // Removes all cached entries.
+    void Clear();
+
+    // Returns true if the cache is enabled.
+    bool IsOpen() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // A cached user entry.
+    struct Entry {
+        std::string name;           // User name, also the key.
+        bool exists;                // False for a negative entry.
+        bool hasPwd;                // True if pwdHash holds a password verified by the database.
+        uint64_t pwdHash;           // Seeded hash of the verified password, the password itself is never kept.
+        Clock::time_point expires;  // Expiration time of the entry.
+    };
+
+    // Each shard owns a part of the key space with its own lock and LRU list.
+    struct Shard {
+        std::mutex mutex;                                               // Mutex protecting the shard.
+        std::list<Entry> lru;                                           // Most recently used entry at the front.
+        std::unordered_map<std::string, std::list<Entry>::iterator> index;  // Maps user names to LRU nodes.
+    };
+
+    bool isOpen_;                                   // Flag indicating if the cache is enabled.
+    size_t shardCapacity_;                          // Maximum number of entries of each shard.
+    std::chrono::milliseconds ttl_;                 // Time to live of positive entries.
+    std::chrono::milliseconds negativeTtl_;         // Time to live of negative entries.
+    uint64_t seed_;                                 // Per-process random seed of the password hash.
+    std::vector<std::unique_ptr<Shard>> shards_;    // Shards of the cache.
+
+    AuthCache();
+
+    ~AuthCache() = default;
+
+    AuthCache(const AuthCache& other) = delete;
+
+    AuthCache& operator=(const AuthCache& other) = delete;
+
+    // Returns the shard responsible for a user name.
+    Shard& GetShard_(const std::string& name);
+
+    // Returns the live entry of a user name (moved to the LRU front), or nullptr. Requires the shard lock.
+    Entry* Find_(Shard& shard, const std::string& name);
+
+    // Inserts or replaces an entry and evicts the least recently used ones. Requires the shard lock.
+    void Put_(Shard& shard, Entry&& entry);
+
+    // Hashes a password with the per-process seed.
+    uint64_t HashPwd_(const std::string& pwd) const;
+};
+
+#endif //SLIM_WEB_SERVER_AUTH_CACHE_H
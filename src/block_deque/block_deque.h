@@ -10,6 +10,7 @@
 #include <condition_variable>
 #include <chrono>
 #include <cassert>
+#include "../lock_profiler/lock_profiler.h"
 
 // A thread-safe, blocking deque implementation that allows for synchronized access from multiple threads.
 template<class T>
@@ -63,15 +64,16 @@ public:
 private:
     std::deque<T> deque_;             // Internal deque used for storage.
     size_t capacity_;                 // Maximum number of items the deque can hold.
-    std::mutex mutex_;                // Mutex to protect access to the internal deque.
+    SlimMutex mutex_;                 // Mutex to protect access to the internal deque.
     bool isClose_;                    // Indicates whether the deque has been closed.
-    std::condition_variable consumer_; // Condition variable to notify consumers.
-    std::condition_variable producer_; // Condition variable to notify producers.
+    SlimCondition consumer_;          // Condition variable to notify consumers.
+    SlimCondition producer_;          // Condition variable to notify producers.
 };
 
 template<class T>
 BlockDeque<T>::BlockDeque(size_t capacity) : capacity_(capacity), isClose_(false) {
     assert(capacity > 0);
+    SLIM_LOCK_NAME(mutex_, "block_deque");
 }
 
 template<class T>
@@ -86,14 +88,14 @@ void BlockDeque<T>::flush() {
 
 template<class T>
 void BlockDeque<T>::clear() {
-    std::lock_guard<std::mutex> locker(mutex_);
+    std::lock_guard<SlimMutex> locker(mutex_);
     deque_.clear();
 }
 
 template<class T>
 void BlockDeque<T>::close() {
     {
-        std::lock_guard<std::mutex> locker(mutex_);
+        std::lock_guard<SlimMutex> locker(mutex_);
         deque_.clear();
         isClose_ = true;
     }
@@ -103,43 +105,43 @@ void BlockDeque<T>::close() {
 
 template<class T>
 bool BlockDeque<T>::empty() {
-    std::lock_guard<std::mutex> locker(mutex_);
+    std::lock_guard<SlimMutex> locker(mutex_);
     return deque_.empty();
 }
 
 template<class T>
 bool BlockDeque<T>::full() {
-    std::lock_guard<std::mutex> locker(mutex_);
+    std::lock_guard<SlimMutex> locker(mutex_);
     return deque_.size() >= capacity_;
 }
 
 template<class T>
 size_t BlockDeque<T>::size() {
-    std::lock_guard<std::mutex> locker(mutex_);
+    std::lock_guard<SlimMutex> locker(mutex_);
     return deque_.size();
 }
 
 template<class T>
 size_t BlockDeque<T>::capacity() {
-    std::lock_guard<std::mutex> locker(mutex_);
+    std::lock_guard<SlimMutex> locker(mutex_);
     return capacity_;
 }
 
 template<class T>
 T BlockDeque<T>::front() {
-    std::lock_guard<std::mutex> locker(mutex_);
+    std::lock_guard<SlimMutex> locker(mutex_);
     return deque_.front();
 }
 
 template<class T>
 T BlockDeque<T>::back() {
-    std::lock_guard<std::mutex> locker(mutex_);
+    std::lock_guard<SlimMutex> locker(mutex_);
     return deque_.back();
 }
 
 template<class T>
 void BlockDeque<T>::push_back(const T &item) {
-    std::unique_lock<std::mutex> locker(mutex_);
+    std::unique_lock<SlimMutex> locker(mutex_);
     while (deque_.size() >= capacity_) {
         producer_.wait(locker);
     }
@@ -149,7 +151,7 @@ void BlockDeque<T>::push_back(const T &item) {
 
 template<class T>
 void BlockDeque<T>::push_front(const T &item) {
-    std::unique_lock<std::mutex> locker(mutex_);
+    std::unique_lock<SlimMutex> locker(mutex_);
     while (deque_.size() >= capacity_) {
         producer_.wait(locker);
     }
@@ -159,7 +161,7 @@ void BlockDeque<T>::push_front(const T &item) {
 
 template<class T>
 bool BlockDeque<T>::pop_front(T &item) {
-    std::unique_lock<std::mutex> locker(mutex_);
+    std::unique_lock<SlimMutex> locker(mutex_);
     while (deque_.empty()) {
         consumer_.wait(locker);
         if (isClose_) {
@@ -174,7 +176,7 @@ bool BlockDeque<T>::pop_front(T &item) {
 
 template<class T>
 bool BlockDeque<T>::pop_front(T &item, int timeout) {
-    std::unique_lock<std::mutex> locker(mutex_);
+    std::unique_lock<SlimMutex> locker(mutex_);
     while (deque_.empty()) {
         if (consumer_.wait_for(locker, std::chrono::seconds(timeout)) == std::cv_status::timeout) {
             return false;  
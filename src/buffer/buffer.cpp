@@ -95,6 +95,13 @@ void Buffer::Append(const Buffer& buff) {
 
 // Reads data from a file descriptor into the buffer, handling overflow.
 ssize_t Buffer::ReadFromFd(int fd, int* error) {
+    SocketTransport socket;
+    socket.Reset(fd);
+    return ReadFrom(socket, error);
+}
+
+// Reads data from a transport into the buffer, overflowing into a stack buffer like ReadFromFd.
+ssize_t Buffer::ReadFrom(Transport& transport, int* error) {
     char tempBuffer[65535];
     struct iovec iov[2];
     const size_t writable = GetWritableBytes();
@@ -104,7 +111,7 @@ ssize_t Buffer::ReadFromFd(int fd, int* error) {
     iov[1].iov_base = tempBuffer;
     iov[1].iov_len = sizeof(tempBuffer);
 
-    const ssize_t len = readv(fd, iov, 2);
+    const ssize_t len = transport.Readv(iov, 2);
     if (len < 0) {
         *error = errno;
     } else if (static_cast<size_t>(len) <= writable){
@@ -12,6 +12,7 @@
 #include <vector>
 #include <atomic>
 #include <cassert>
+#include "../transport/transport.h"
 
 // A thread-safe buffer class for managing a dynamic array of bytes.
 class Buffer {
@@ -70,6 +71,9 @@ public:
     // Reads data from a file descriptor into the buffer.
     ssize_t ReadFromFd(int fd, int* error);
 
+    // Reads data from a transport into the buffer.
+    ssize_t ReadFrom(Transport& transport, int* error);
+
     // Writes data from the buffer to a file descriptor.
     ssize_t WriteToFd(int fd, int* error);
 
@@ -0,0 +1,228 @@
+//
+// Created by pyq on 10/19/26.
+//
+#include "traffic_capture.h"
+#include <time.h>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+namespace {
+
+const char MAGIC[] = "SLIMCAP1";
+const size_t MAGIC_LEN = 8;
+const uint64_t MAX_REQUEST = 64 << 20;      // Longest request accepted by the reader.
+
+uint64_t MonotonicNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+std::atomic<uint64_t> connIdSeq(1);
+
+}
+
+TrafficCapture* TrafficCapture::Instance() {
+    static TrafficCapture capture;
+    return &capture;
+}
+
+TrafficCapture::TrafficCapture() :
+        isOpen_(false), sampleEvery_(1), firstConnId_(0), startNs_(0), lastFlushNs_(0), maxBytes_(0),
+        bytes_(0), records_(0), dropped_(0), isFull_(false), fp_(nullptr) {}
+
+TrafficCapture::~TrafficCapture() {
+    Close();
+}
+
+uint64_t TrafficCapture::NextConnId() {
+    return connIdSeq++;
+}
+
+bool TrafficCapture::Open(const char* path, int sampleEvery, uint64_t maxBytes) {
+    std::lock_guard<std::mutex> locker(mutex_);
+    Close_();
+    if (sampleEvery <= 0) {
+        return false;
+    }
+    // the raw requests hold the passwords of login and register forms, only the owner may read them;
+    // the mode of open only applies to a new file, fchmod also covers one that is overwritten
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        return false;
+    }
+    if (fchmod(fd, 0600) < 0 || (fp_ = fdopen(fd, "wb")) == nullptr) {
+        close(fd);
+        return false;
+    }
+    setvbuf(fp_, nullptr, _IOFBF, 1 << 20);
+
+    struct timeval now = {0, 0};
+    gettimeofday(&now, nullptr);
+    std::string header(MAGIC, MAGIC_LEN);
+    AppendVarint_(header, (uint64_t)now.tv_sec * 1000000 + now.tv_usec);
+    AppendVarint_(header, sampleEvery);
+    fwrite(header.data(), 1, header.size(), fp_);
+
+    path_ = path;
+    maxBytes_ = maxBytes;
+    bytes_ = header.size();
+    records_ = 0;
+    dropped_ = 0;
+    isFull_ = false;
+    startNs_ = MonotonicNs();
+    lastFlushNs_ = startNs_;
+    sampleEvery_ = sampleEvery;
+    firstConnId_ = connIdSeq.load();
+    isOpen_ = true;
+    return true;
+}
+
+bool TrafficCapture::IsSampled(uint64_t connId) const {
+    return isOpen_ && connId >= firstConnId_ && connId % sampleEvery_ == 0;
+}
+
+void TrafficCapture::Write(uint64_t connId, bool isFirst, uint64_t acceptNs, uint64_t arrivalNs,
+                           const char* request, size_t len, int code, uint64_t responseBytes, bool keepAlive) {
+    // the record is encoded outside the lock, only the write is serialized
+    std::string record;
+    record.reserve(len + 48);
+    AppendVarint_(record, connId);
+    AppendVarint_(record, (isFirst ? FIRST : 0) | (keepAlive ? KEEP_ALIVE : 0));
+    uint64_t startNs = startNs_;
+    if (isFirst) {
+        AppendVarint_(record, acceptNs > startNs ? (acceptNs - startNs) / 1000 : 0);
+    }
+    AppendVarint_(record, arrivalNs > startNs ? (arrivalNs - startNs) / 1000 : 0);
+    AppendVarint_(record, code < 0 ? 0 : code);
+    AppendVarint_(record, responseBytes);
+    AppendVarint_(record, len);
+    record.append(request, len);
+
+    std::lock_guard<std::mutex> locker(mutex_);
+    // a connection of an earlier capture must not leak into this one
+    if (!fp_ || connId < firstConnId_ || startNs != startNs_) {
+        return;
+    }
+    if (isFull_ || (maxBytes_ && bytes_ + record.size() > maxBytes_)) {
+        isFull_ = true;
+        dropped_++;
+        return;
+    }
+    fwrite(record.data(), 1, record.size(), fp_);
+    bytes_ += record.size();
+    records_++;
+    uint64_t now = MonotonicNs();
+    if (now - lastFlushNs_ > (uint64_t)FLUSH_MS * 1000000) {
+        fflush(fp_);
+        lastFlushNs_ = now;
+    }
+}
+
+TrafficCapture::Stats TrafficCapture::GetStats() {
+    std::lock_guard<std::mutex> locker(mutex_);
+    Stats stats;
+    stats.isOpen = fp_ != nullptr;
+    stats.isFull = isFull_;
+    stats.sampleEvery = sampleEvery_;
+    stats.records = records_;
+    stats.bytes = bytes_;
+    stats.maxBytes = maxBytes_;
+    stats.dropped = dropped_;
+    stats.path = path_;
+    return stats;
+}
+
+void TrafficCapture::Close() {
+    std::lock_guard<std::mutex> locker(mutex_);
+    Close_();
+}
+
+void TrafficCapture::Close_() {
+    isOpen_ = false;
+    if (fp_) {
+        fclose(fp_);
+        fp_ = nullptr;
+    }
+}
+
+void TrafficCapture::AppendVarint_(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back((char)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((char)value);
+}
+
+TrafficCapture::Reader::Reader() : fp_(nullptr), startUs_(0), sampleEvery_(1) {}
+
+TrafficCapture::Reader::~Reader() {
+    if (fp_) {
+        fclose(fp_);
+    }
+}
+
+bool TrafficCapture::Reader::Open(const char* path) {
+    if (fp_) {
+        fclose(fp_);
+    }
+    fp_ = fopen(path, "rb");
+    if (fp_ == nullptr) {
+        return false;
+    }
+    char magic[MAGIC_LEN];
+    uint64_t sampleEvery = 0;
+    if (fread(magic, 1, MAGIC_LEN, fp_) != MAGIC_LEN || memcmp(magic, MAGIC, MAGIC_LEN) != 0 ||
+        !ReadVarint_(&startUs_) || !ReadVarint_(&sampleEvery)) {
+        fclose(fp_);
+        fp_ = nullptr;
+        return false;
+    }
+    sampleEvery_ = sampleEvery;
+    return true;
+}
+
+bool TrafficCapture::Reader::Next(Record* record) {
+    uint64_t flags = 0, code = 0, len = 0;
+    if (!fp_ || !ReadVarint_(&record->connId) || !ReadVarint_(&flags)) {
+        return false;
+    }
+    record->flags = flags;
+    record->acceptUs = 0;
+    if ((flags & FIRST) && !ReadVarint_(&record->acceptUs)) {
+        return false;
+    }
+    if (!ReadVarint_(&record->arrivalUs) || !ReadVarint_(&code) || !ReadVarint_(&record->responseBytes) ||
+        !ReadVarint_(&len) || len > MAX_REQUEST) {
+        return false;
+    }
+    record->code = code;
+    record->request.resize(len);
+    return len == 0 || fread(&record->request[0], 1, len, fp_) == len;
+}
+
+uint64_t TrafficCapture::Reader::StartUs() const {
+    return startUs_;
+}
+
+int TrafficCapture::Reader::SampleEvery() const {
+    return sampleEvery_;
+}
+
+bool TrafficCapture::Reader::ReadVarint_(uint64_t* value) {
+    *value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int c = fgetc(fp_);
+        if (c == EOF) {
+            return false;
+        }
+        *value |= (uint64_t)(c & 0x7f) << shift;
+        if (!(c & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
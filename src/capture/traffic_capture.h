@@ -0,0 +1,137 @@
+//
+// Created by pyq on 10/19/26.
+//
+#pragma once
+#ifndef SLIM_WEB_SERVER_TRAFFIC_CAPTURE_H
+#define SLIM_WEB_SERVER_TRAFFIC_CAPTURE_H
+
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+
+// Records the request streams of sampled connections to a binary capture file for slim-replay.
+//
+// File layout, integers are unsigned LEB128 varints unless noted:
+//   header   "SLIMCAP1", start time in microseconds since the epoch, sampleEvery
+//   record   connId, flags, [acceptUs if FIRST], arrivalUs, code, responseBytes, requestLen, request bytes
+// Times of the records are microseconds since the capture was opened. A record cut short by a crash
+// or the size cap is never written partially, so the reader stops cleanly at the last complete one.
+class TrafficCapture {
+public:
+    // Enumerates the record flags.
+    enum FLAG {
+        FIRST = 1,          // First request of the connection, the accept time follows.
+        KEEP_ALIVE = 2,     // The response kept the connection open.
+    };
+
+    // A request of the capture.
+    struct Record {
+        uint64_t connId;        // Connection of the request, unique within the capture.
+        uint32_t flags;         // FLAG bits.
+        uint64_t acceptUs;      // Accept time of the connection, set for FIRST records.
+        uint64_t arrivalUs;     // Time the request became readable.
+        int code;               // Status code of the response.
+        uint64_t responseBytes; // Bytes of the response, headers included.
+        std::string request;    // Raw request bytes.
+    };
+
+    // Counters of the current capture.
+    struct Stats {
+        bool isOpen;            // A capture file is open.
+        bool isFull;            // The size cap was reached, later requests are dropped.
+        int sampleEvery;        // One connection in sampleEvery is recorded.
+        uint64_t records;       // Records written.
+        uint64_t bytes;         // Bytes of the file.
+        uint64_t maxBytes;      // Size cap, 0 means no limit.
+        uint64_t dropped;       // Records dropped by the size cap.
+        std::string path;       // Capture file.
+    };
+
+    // Retrieves the singleton instance.
+    static TrafficCapture* Instance();
+
+    // Starts a new capture file recording one connection in sampleEvery, up to maxBytes (0 means no limit).
+    // Connections accepted before the call are not recorded, their first requests would be missing.
+    bool Open(const char* path, int sampleEvery = 1, uint64_t maxBytes = 0);
+
+    // Returns true if the connection connId, just accepted, should be recorded.
+    bool IsSampled(uint64_t connId) const;
+
+    // Writes a record, times are monotonic nanoseconds as returned by RequestTrace::NowNs.
+    void Write(uint64_t connId, bool isFirst, uint64_t acceptNs, uint64_t arrivalNs,
+               const char* request, size_t len, int code, uint64_t responseBytes, bool keepAlive);
+
+    // Returns the counters of the current capture.
+    Stats GetStats();
+
+    // Flushes and closes the capture file.
+    void Close();
+
+    // Returns a new connection id, ids only grow so a capture can tell the connections accepted before it.
+    static uint64_t NextConnId();
+
+    // Reads a capture file written by TrafficCapture.
+    class Reader {
+    public:
+        Reader();
+
+        ~Reader();
+
+        // Opens a capture file and reads its header, returns false if it is not a capture.
+        bool Open(const char* path);
+
+        // Reads the next record, returns false at the end of the file or of the last complete record.
+        bool Next(Record* record);
+
+        // Returns the wall clock start of the capture in microseconds since the epoch.
+        uint64_t StartUs() const;
+
+        // Returns the sampling of the capture.
+        int SampleEvery() const;
+
+    private:
+        FILE* fp_;              // Capture file.
+        uint64_t startUs_;      // Wall clock start of the capture.
+        int sampleEvery_;       // Sampling of the capture.
+
+        // Reads a varint, returns false at the end of the file.
+        bool ReadVarint_(uint64_t* value);
+
+        Reader(const Reader& other) = delete;
+        Reader& operator=(const Reader& other) = delete;
+    };
+
+private:
+    static const int FLUSH_MS = 1000;   // Longest time a record stays in the stdio buffer.
+
+    std::atomic<bool> isOpen_;          // A capture file is open.
+    std::atomic<int> sampleEvery_;      // One connection in sampleEvery_ is recorded.
+    std::atomic<uint64_t> firstConnId_; // Connections below this id were accepted before the capture.
+    std::atomic<uint64_t> startNs_;     // Monotonic time of Open, also tells the captures apart.
+    uint64_t lastFlushNs_;              // Monotonic time of the last fflush.
+    uint64_t maxBytes_;                 // Size cap, 0 means no limit.
+    uint64_t bytes_;                    // Bytes written.
+    uint64_t records_;                  // Records written.
+    uint64_t dropped_;                  // Records dropped by the size cap.
+    bool isFull_;                       // The size cap was reached.
+    std::string path_;                  // Capture file.
+    FILE* fp_;                          // Capture file.
+    std::mutex mutex_;                  // Mutex serializing the writers.
+
+    TrafficCapture();
+
+    ~TrafficCapture();
+
+    // Closes the file. Requires mutex_.
+    void Close_();
+
+    // Appends a varint to out.
+    static void AppendVarint_(std::string& out, uint64_t value);
+
+    TrafficCapture(const TrafficCapture& other) = delete;
+    TrafficCapture& operator=(const TrafficCapture& other) = delete;
+};
+
+#endif //SLIM_WEB_SERVER_TRAFFIC_CAPTURE_H
@@ -0,0 +1,86 @@
+//
+// Created by pyq on 10/19/26.
+//
+#include "circuit_breaker.h"
+
+CircuitBreaker::CircuitBreaker(int failureThreshold, int openMs, int probeNum) :
+    failureThreshold_(failureThreshold), openTime_(openMs), probeNum_(probeNum), state_(CLOSED),
+    failures_(0), probes_(0), probeSuccesses_(0), successCount_(0), failureCount_(0), rejectCount_(0), tripCount_(0) {
+    assert(failureThreshold > 0 && openMs > 0 && probeNum > 0);
+}
+
+bool CircuitBreaker::Allow(Ticket* ticket) {
+    std::lock_guard<std::mutex> locker(mutex_);
+    ticket->isProbe = false;
+    ticket->trip = tripCount_;
+    if (state_ == OPEN) {
+        if (Clock::now() - openedAt_ < openTime_) {
+            rejectCount_++;
+            return false;
+        }
+        // the open time is over, let a few probes find out if the dependency is back
+        state_ = HALF_OPEN;
+        probes_ = 0;
+        probeSuccesses_ = 0;
+    }
+    if (state_ == HALF_OPEN) {
+        if (probes_ + probeSuccesses_ >= probeNum_) {
+            rejectCount_++;
+            return false;
+        }
+        probes_++;
+        ticket->isProbe = true;
+    }
+    return true;
+}
+
+void CircuitBreaker::OnSuccess(const Ticket& ticket) {
+    std::lock_guard<std::mutex> locker(mutex_);
+    successCount_++;
+    // a call admitted before the breaker last tripped says nothing about the dependency now,
+    // and only probes of the current HALF_OPEN period may close it
+    if (ticket.trip != tripCount_) {
+        return;
+    }
+    if (state_ == HALF_OPEN && ticket.isProbe) {
+        probes_--;
+        if (++probeSuccesses_ >= probeNum_) {
+            state_ = CLOSED;
+            failures_ = 0;
+        }
+    } else if (state_ == CLOSED) {
+        failures_ = 0;
+    }
+}
+
+void CircuitBreaker::OnFailure(const Ticket& ticket) {
+    std::lock_guard<std::mutex> locker(mutex_);
+    failureCount_++;
+    if (ticket.trip != tripCount_) {
+        return;
+    }
+    if (state_ == HALF_OPEN && ticket.isProbe) {
+        Trip_();
+    } else if (state_ == CLOSED && ++failures_ >= failureThreshold_) {
+        Trip_();
+    }
+}
+
+int CircuitBreaker::GetState() {
+    std::lock_guard<std::mutex> locker(mutex_);
+    return state_;
+}
+
+CircuitBreaker::Stats CircuitBreaker::GetStats() {
+    std::lock_guard<std::mutex> locker(mutex_);
+    return {state_, successCount_, failureCount_, rejectCount_, tripCount_};
+}
+
+void CircuitBreaker::Trip_() {
+    state_ = OPEN;
+    openedAt_ = Clock::now();
+    failures_ = 0;
+    probes_ = 0;
+    probeSuccesses_ = 0;
+    tripCount_++;
+}
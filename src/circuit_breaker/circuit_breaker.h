@@ -0,0 +1,81 @@
+//
+// Created by pyq on 10/19/26.
+//
+#pragma once
+#ifndef SLIM_WEB_SERVER_CIRCUIT_BREAKER_H
+#define SLIM_WEB_SERVER_CIRCUIT_BREAKER_H
+
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include <cassert>
+
+// Circuit breaker guarding a slow or failing dependency. 
+// CLOSED lets every call through and OPENs after failureThreshold consecutive failures,
+// OPEN rejects every call for openMs and then goes HALF_OPEN,
+// HALF_OPEN lets up to probeNum calls through, closes after probeNum successes and reopens on any failure.
+class CircuitBreaker {
+public:
+    // Enumerates the states of the breaker.
+    enum STATE {
+        CLOSED = 0,
+        OPEN,
+        HALF_OPEN,
+    };
+
+    // Snapshot of the breaker state and counters.
+    struct Stats {
+        int state;              // Current STATE.
+        uint64_t successCount;  // Calls reported as succeeded.
+        uint64_t failureCount;  // Calls reported as failed or timed out.
+        uint64_t rejectCount;   // Calls rejected while OPEN or while HALF_OPEN probes are in flight.
+        uint64_t tripCount;     // Transitions to OPEN.
+    };
+
+    // Issued by Allow for one call and handed back with its outcome.
+    struct Ticket {
+        bool isProbe;           // Admitted as a probe while HALF_OPEN.
+        uint64_t trip;          // Transitions to OPEN before the call was admitted.
+    };
+
+    explicit CircuitBreaker(int failureThreshold = 5, int openMs = 5000, int probeNum = 3);
+
+    ~CircuitBreaker() = default;
+
+    // Returns true if the call may go on, it must then be reported with *ticket by OnSuccess or OnFailure.
+    bool Allow(Ticket* ticket);
+
+    // Reports a call that succeeded.
+    void OnSuccess(const Ticket& ticket);
+
+    // Reports a call that failed or timed out.
+    void OnFailure(const Ticket& ticket);
+
+    // Returns the current state.
+    int GetState();
+
+    // Returns a snapshot of the state and counters.
+    Stats GetStats();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    int failureThreshold_;          // Consecutive failures that open the breaker.
+    std::chrono::milliseconds openTime_;    // How long the breaker stays open.
+    int probeNum_;                  // Successful probes needed to close the breaker.
+    int state_;                     // Current STATE.
+    int failures_;                  // Consecutive failures while CLOSED.
+    int probes_;                    // Probes in flight while HALF_OPEN.
+    int probeSuccesses_;            // Successful probes while HALF_OPEN.
+    Clock::time_point openedAt_;    // Time the breaker last opened.
+    uint64_t successCount_;         // Calls reported as succeeded.
+    uint64_t failureCount_;         // Calls reported as failed or timed out.
+    uint64_t rejectCount_;          // Calls rejected.
+    uint64_t tripCount_;            // Transitions to OPEN.
+    std::mutex mutex_;              // Mutex protecting the state.
+
+    // Moves to OPEN. Requires mutex_.
+    void Trip_();
+};
+
+#endif //SLIM_WEB_SERVER_CIRCUIT_BREAKER_H
@@ -0,0 +1,50 @@
+//
+// Created by pyq on 10/19/26.
+//
+#pragma once
+#ifndef SLIM_WEB_SERVER_HASH_H
+#define SLIM_WEB_SERVER_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+
+// FNV-1a hashes shared by the modules that need a hash whose value is fixed across builds and processes,
+// unlike std::hash: shard selection, on-disk indexes and record checksums. Not meant to resist collisions
+// chosen by an attacker, a caller hashing untrusted keys mixes in a seed.
+class Hash {
+public:
+    // Returns the 64-bit FNV-1a hash of len bytes, seed is xored into the offset basis.
+    static uint64_t Fnv1a64(const void* data, size_t len, uint64_t seed = 0) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        uint64_t h = 14695981039346656037ULL ^ seed;
+        for (size_t i = 0; i < len; ++i) {
+            h ^= bytes[i];
+            h *= 1099511628211ULL;
+        }
+        return h;
+    }
+
+    // Returns h with every bit mixed into every other (the splitmix64 finalizer), FNV-1a alone leaves the
+    // low bits depending only on the low bits of the input, which is poor for a table indexed by them.
+    static uint64_t Mix64(uint64_t h) {
+        h ^= h >> 30;
+        h *= 0xbf58476d1ce4e5b9ULL;
+        h ^= h >> 27;
+        h *= 0x94d049bb133111ebULL;
+        h ^= h >> 31;
+        return h;
+    }
+
+    // Returns the 32-bit FNV-1a hash of len bytes.
+    static uint32_t Fnv1a32(const void* data, size_t len) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        uint32_t h = 2166136261U;
+        for (size_t i = 0; i < len; ++i) {
+            h ^= bytes[i];
+            h *= 16777619U;
+        }
+        return h;
+    }
+};
+
+#endif //SLIM_WEB_SERVER_HASH_H
@@ -1,6 +1,7 @@
 //
 // Created by pyq on 5/10/24.
 //
+#include <strings.h>
 #include "http_connect.h"
 
 // *srcDir can't be changed, value of srcDir can be changed
@@ -10,29 +11,47 @@ std::atomic<int> HttpConn::userCount;
 
 bool HttpConn::isET;
 
-HttpConn::HttpConn() : fd_(-1), isClose_(true), addr_({0}) {}
+std::atomic<bool> HttpConn::isDraining(false);
+
+HttpConn::HttpConn() : fd_(-1), transport_(&socket_), isClose_(true), addr_({0}),
+                       connId_(0), isCaptured_(false), isFirstRequest_(false), handler_(nullptr), isRouted_(false) {}
 
 HttpConn::~HttpConn() {
     Close();
 }
 
-void HttpConn::Init(int sockFd, const sockaddr_in& addr) {
+void HttpConn::Init(int sockFd, const sockaddr_in& addr, Transport* transport) {
     assert(sockFd > 0);
     userCount++;
     addr_ = addr;
     fd_ = sockFd;
+    socket_.Reset(sockFd);
+    transport_ = transport ? transport : &socket_;
     writeBuff_.RetrieveAll();
     readBuff_.RetrieveAll();
+    httpRequest_.Init();
+    handler_ = nullptr;
+    isRouted_ = false;
+    captured_.clear();
+    trace_.Reset();
+    trace_.Mark(RequestTrace::ACCEPT);
+    connId_ = TrafficCapture::NextConnId();
+    isCaptured_ = TrafficCapture::Instance()->IsSampled(connId_);
+    isFirstRequest_ = true;
     isClose_ = false;
+    Metrics::Instance()->Set(Metrics::CONNECTIONS, userCount);
     LOG_INFO("Client[%d](%s:%d) in, userCount:%d", fd_, GetIP(), GetPort(), (int)userCount);
 }
 
 void HttpConn::Close() {
     httpResponse_.UnmapFile();
+    httpResponse_.ResetStream();
+    httpRequest_.SetBodyReader(nullptr);
     if (isClose_ == false) {
         isClose_ = true;
         userCount--;
-        close(fd_);
+        Metrics::Instance()->Set(Metrics::CONNECTIONS, userCount);
+        transport_->Close();
         LOG_INFO("Client[%d](%s:%d) quit, userCount:%d", fd_, GetIP(), GetPort(), (int)userCount);
     }
 }
@@ -54,33 +73,38 @@ int HttpConn::GetPort() const {
 }
 
 bool HttpConn::IsKeepAlive() const {
-    return httpRequest_.IsKeepAlive();
+    return !isDraining && httpRequest_.IsKeepAlive();
 }
 
 ssize_t HttpConn::Read(int* saveErrno) {
-    // read data from fd_ into readBuff_
+    // read data from the transport into readBuff_
     ssize_t len = -1;
     // do-while loop guarantees that whether it is ET or LT, 
     // a read will be performed.
     do {
-        len = readBuff_.ReadFromFd(fd_, saveErrno);
+        len = readBuff_.ReadFrom(*transport_, saveErrno);
         // ET mode will read data as much as possible until 
         // there is no data or an error occurs.
         if (len <= 0) {
             break;
         }
-    } while (isET);
+        Metrics::Instance()->Add(Metrics::BYTES_IN, len);
+        // or until a window of data waits for the parser, e.g. a large body;
+        // the EPOLLIN re-armed after Process reports the rest
+    } while (isET && readBuff_.GetReadableBytes() < READ_WINDOW);
     return len;
 }
 
 ssize_t HttpConn::Write(int* saveErrno) {
     ssize_t len = -1;
     do {
-        len = writev(fd_, iov_, iovCnt_);
+        len = transport_->Writev(iov_, iovCnt_);
         if (len <= 0) {
             *saveErrno = errno;
             break;
         }
+        Metrics::Instance()->Add(Metrics::BYTES_OUT, len);
+        trace_.Mark(RequestTrace::FIRST_BYTE);
         if (iov_[0].iov_len + iov_[1].iov_len == 0) {
             // all of the data in writeBuff_ has been written
             break;
@@ -98,8 +122,15 @@ ssize_t HttpConn::Write(int* saveErrno) {
             iov_[0].iov_len -= len;
             writeBuff_.AdvanceReadPointer(len);
         }
+        if (ToWriteBytes() == 0 && !PullStream_()) {
+            break;
+        }
     } while (isET || ToWriteBytes() > 10240); // ET mode ordata to be written is large (> 10240B), 
     // write data as much as possible to reduce system calls.
+    if (ToWriteBytes() == 0) {
+        SLIM_PROBE2(write_done, fd_, httpResponse_.GetCode());
+        FinishTrace_();
+    }
     return len;
 }
 
@@ -109,20 +140,72 @@ int HttpConn::ToWriteBytes() {
 }
 
 bool HttpConn::Process() {
-    httpRequest_.Init();
+    if (httpRequest_.State() == HttpRequest::FINISH) {
+        // the previous request was answered, the buffer starts the next one
+        httpRequest_.Init();
+        handler_ = nullptr;
+        isRouted_ = false;
+    }
     if (readBuff_.GetReadableBytes() <= 0) {
+        if (httpRequest_.State() == HttpRequest::REQUEST_LINE) {
+            // nothing to serve, drop the marks of this wakeup but keep the accept time
+            trace_.Reset(RequestTrace::READABLE);
+        }
         return false;
-    } else if (httpRequest_.ParseHttpRequest(readBuff_)) {
+    }
+    if (trace_.At(RequestTrace::READABLE) == 0) {
+        // a pipelined request already in the buffer is served from OnWrite_ without another read,
+        // it starts when the previous response is done instead of reporting a total of 0
+        trace_.Mark(RequestTrace::READABLE);
+        trace_.Mark(RequestTrace::DEQUEUE);
+    }
+    Metrics* metrics = Metrics::Instance();
+    SLIM_PROBE2(parse_start, fd_, readBuff_.GetReadableBytes());
+    // the parser only moves the read pointer, the raw bytes stay in place for the capture
+    const char* raw = readBuff_.BeginRead();
+    size_t rawLen = readBuff_.GetReadableBytes();
+    bool parsed = httpRequest_.ParseHttpRequest(readBuff_);
+    if (parsed && !isRouted_ && httpRequest_.State() >= HttpRequest::BODY) {
+        // the headers are complete, the handler decides where the body goes before any of it is parsed
+        Route_();
+        parsed = httpRequest_.ParseHttpRequest(readBuff_);
+    }
+    if (isCaptured_) {
+        // a malformed request is recorded with all the bytes it came with
+        captured_.append(raw, parsed ? rawLen - readBuff_.GetReadableBytes() : rawLen);
+    }
+    if (parsed && httpRequest_.State() != HttpRequest::FINISH) {
+        // the rest of the request comes with a later read
+        return false;
+    }
+    trace_.Mark(RequestTrace::PARSED);
+    SLIM_PROBE3(parse_end, fd_, parsed, httpRequest_.Path().c_str());
+    if (parsed) {
         LOG_DEBUG("HttpRequest Path: %s", httpRequest_.Path().c_str());
-        httpResponse_.Init(srcDir, httpRequest_.Path(), httpRequest_.IsKeepAlive(), 200);
+        httpResponse_.Init(srcDir, httpRequest_.Path(), IsKeepAlive(), httpRequest_.Code());
+        // a request without a route is served from srcDir
+        if (handler_) {
+            Router::Context context = {httpRequest_, addr_, params_};
+            handler_->Handle(context, httpResponse_);
+        }
+        if (httpResponse_.IsStreaming() && httpRequest_.Version() != "1.1") {
+            // HTTP/1.0 has no chunked encoding
+            httpResponse_.StreamUntilClose();
+        }
     } else {
-        httpResponse_.Init(srcDir, httpRequest_.Path(), false, 400);
+        httpResponse_.Init(srcDir, httpRequest_.Path(), false, httpRequest_.Code());
+        httpResponse_.SetError(httpRequest_.Code());
     }
 
-    // iov_[0] stores the data of http response except response body
+    // iov_[0] stores the data of http response except response body,
+    // a streamed body starts right after the header so that both go out in the first write
     httpResponse_.MakeResponse(writeBuff_);
+    httpResponse_.NextChunk(writeBuff_, STREAM_WINDOW);
+    trace_.Mark(RequestTrace::HANDLED);
+    metrics->AddRequest(httpResponse_.GetCode());
     iov_[0].iov_base = const_cast<char*> (writeBuff_.BeginRead());
     iov_[0].iov_len = writeBuff_.GetReadableBytes();
+    iov_[1].iov_len = 0;
     iovCnt_ = 1;
 
     // iov_[1] stores the data of response body
@@ -132,5 +215,99 @@ bool HttpConn::Process() {
         iovCnt_ = 2;
     }
     LOG_DEBUG("File Size: %d, %d to %d", httpResponse_.GetFileLen(), iovCnt_, ToWriteBytes());
+    if (isCaptured_) {
+        Capture_(captured_.data(), captured_.size(), parsed && IsKeepAlive());
+        captured_.clear();
+    }
     return true;
-}
\ No newline at end of file
+}
+
+void HttpConn::Route_() {
+    isRouted_ = true;
+    handler_ = Router::Instance()->Find(httpRequest_.Method(), httpRequest_.Path(), &params_);
+    if (handler_) {
+        Router::Context context = {httpRequest_, addr_, params_};
+        if (!handler_->OnHeaders(context)) {
+            httpRequest_.AbortBody();
+            return;
+        }
+    }
+    if (httpRequest_.State() == HttpRequest::BODY && readBuff_.GetReadableBytes() == 0 &&
+        strcasecmp(httpRequest_.GetHeader("Expect").c_str(), "100-continue") == 0) {
+        // the client holds the body back until this interim response, a refused request gets its final
+        // response instead; nothing is queued on the socket between two requests, so it takes one write
+        static const char CONTINUE[] = "HTTP/1.1 100 Continue\r\n\r\n";
+        iovec iov = {const_cast<char*>(CONTINUE), sizeof(CONTINUE) - 1};
+        if (transport_->Writev(&iov, 1) != static_cast<ssize_t>(iov.iov_len)) {
+            LOG_WARN("Client[%d] 100 Continue Write Error!", fd_);
+        }
+    }
+}
+
+bool HttpConn::PullStream_() {
+    if (!httpResponse_.IsStreaming()) {
+        return false;
+    }
+    // the producer only runs when the socket took everything before, which bounds the memory of a response
+    writeBuff_.RetrieveAll();
+    httpResponse_.NextChunk(writeBuff_, STREAM_WINDOW);
+    iov_[0].iov_base = const_cast<char*> (writeBuff_.BeginRead());
+    iov_[0].iov_len = writeBuff_.GetReadableBytes();
+    iov_[1].iov_len = 0;
+    iovCnt_ = 1;
+    return iov_[0].iov_len > 0;
+}
+
+void HttpConn::Capture_(const char* request, size_t len, bool keepAlive) {
+    uint64_t arrival = trace_.At(RequestTrace::READABLE);
+    if (arrival == 0) {
+        arrival = trace_.At(RequestTrace::PARSED);
+    }
+    // the size of a streamed body is not known yet, 0 makes the replay skip the size check
+    size_t responseBytes = httpResponse_.IsStreaming() ? 0 : ToWriteBytes();
+    TrafficCapture::Instance()->Write(connId_, isFirstRequest_, trace_.At(RequestTrace::ACCEPT), arrival,
+                                      request, len, httpResponse_.GetCode(), responseBytes, keepAlive);
+    isFirstRequest_ = false;
+}
+
+RequestTrace& HttpConn::Trace() {
+    return trace_;
+}
+
+void HttpConn::FinishTrace_() {
+    if (trace_.At(RequestTrace::HANDLED) == 0) {
+        return;
+    }
+    trace_.Mark(RequestTrace::LAST_BYTE);
+    RequestTrace::PHASE start = trace_.At(RequestTrace::ACCEPT) ? RequestTrace::ACCEPT : RequestTrace::READABLE;
+    uint64_t phases[] = {
+        trace_.Between(RequestTrace::ACCEPT, RequestTrace::READABLE),
+        trace_.Between(RequestTrace::READABLE, RequestTrace::DEQUEUE),
+        trace_.Between(RequestTrace::DEQUEUE, RequestTrace::PARSED),
+        trace_.Between(RequestTrace::PARSED, RequestTrace::HANDLED),
+        trace_.Between(RequestTrace::HANDLED, RequestTrace::FIRST_BYTE),
+        trace_.Between(RequestTrace::FIRST_BYTE, RequestTrace::LAST_BYTE),
+    };
+    uint64_t total = trace_.Between(start, RequestTrace::LAST_BYTE);
+
+    Metrics* metrics = Metrics::Instance();
+    if (start == RequestTrace::ACCEPT) {
+        metrics->Record(Metrics::PHASE_READ, phases[0] / 1000);
+    }
+    for (int i = 1; i < 6; ++i) {
+        metrics->Record(static_cast<Metrics::HISTOGRAM>(Metrics::PHASE_READ + i), phases[i] / 1000);
+    }
+    metrics->Record(Metrics::REQUEST_TIME, total / 1000);
+
+    SlowLog* slowLog = SlowLog::Instance();
+    if (slowLog->IsSlow(total)) {
+        char detail[512];
+        snprintf(detail, sizeof(detail),
+                "client=%s:%d %s %s %d read=%.3fms queue=%.3fms parse=%.3fms handle=%.3fms first_write=%.3fms write=%.3fms",
+                GetIP(), GetPort(), httpRequest_.Method().c_str(), httpRequest_.Path().c_str(), httpResponse_.GetCode(),
+                phases[0] / 1e6, phases[1] / 1e6, phases[2] / 1e6, phases[3] / 1e6, phases[4] / 1e6, phases[5] / 1e6);
+        slowLog->Write(total, detail);
+    }
+    // the next request on this connection starts at its read readiness
+    trace_.Reset();
+}
@@ -13,9 +13,16 @@
 #include <arpa/inet.h> 
 #include "http_request.h"
 #include "http_response.h"  
+#include "request_trace.h"
 #include "../log/log.h"
 #include "../buffer/buffer.h"
+#include "../transport/transport.h"
 #include "../sql_connect/sql_connect_raii.h"
+#include "../metrics/metrics.h"
+#include "../log/slow_log.h"
+#include "../probe/probe.h"
+#include "../router/router.h"
+#include "../capture/traffic_capture.h"
 
 // Class representing an HTTP connection, handling both requests and responses.
 class HttpConn {
@@ -25,7 +32,8 @@ public:
     ~HttpConn();
 
     // Initializes the connection with a socket file descriptor and client address.
-    void Init(int sockFd, const sockaddr_in& addr);
+    // I/O goes through transport when given (e.g. a MemoryTransport in benchmarks), otherwise through the socket.
+    void Init(int sockFd, const sockaddr_in& addr, Transport* transport = nullptr);
 
     // Closes the connection, cleans up resources, and logs the closure.
     void Close();
@@ -57,11 +65,17 @@ public:
     // Processes the request from the read buffer, forms a response, and prepares it for sending.
     bool Process();
 
+    // Returns the phase timestamps of the current request.
+    RequestTrace& Trace();
+
     static bool isET;                   // Flag indicating if the socket is using Edge Triggered mode.
     static const char* srcDir;          // Directory path for serving files.
     static std::atomic<int> userCount;  // Counter for the number of active users/connections.
+    static std::atomic<bool> isDraining;    // Set by the admin drain command, responses close their connection.
 private:
     int fd_;                            // File descriptor for the socket.
+    SocketTransport socket_;            // Transport over fd_.
+    Transport* transport_;              // Transport used for I/O, socket_ unless Init was given another one.
     bool isClose_;                      // Flag to check if the connection is closed.
     int iovCnt_;                        // Number of IOV structures being used.
     iovec iov_[2];                      // Array of IOV structures for writev operations.
@@ -70,6 +84,30 @@ private:
     Buffer writeBuff_;                  // Buffer for writing data to the socket.
     HttpRequest httpRequest_;           // HTTP request parser.
     HttpResponse httpResponse_;         // HTTP response generator.
+    RequestTrace trace_;                // Phase timestamps of the current request.
+    uint64_t connId_;                   // Id of the connection, unique over the life of the process.
+    bool isCaptured_;                   // The connection was sampled by the traffic capture.
+    bool isFirstRequest_;               // No request of the connection was captured yet.
+    std::string captured_;              // Raw bytes of the current request parsed so far, for the capture.
+    Router::Handler* handler_;          // Handler of the current request, nullptr if it has no route.
+    Router::Params params_;             // Parameters of the route of the current request.
+    bool isRouted_;                     // The headers of the current request were parsed and routed.
+    static const size_t STREAM_WINDOW = 32768;  // Bytes of a streamed body produced ahead of the socket.
+    static const size_t READ_WINDOW = 65536;    // Bytes read ahead of the parser in ET mode.
+
+    // Finds the handler of a request whose headers were just parsed, lets it pick where the body goes
+    // and answers Expect: 100-continue.
+    void Route_();
+
+    // Refills writeBuff_ with the next chunks of a streamed body once the previous ones were written,
+    // returns false if there is nothing more to write.
+    bool PullStream_();
+
+    // Writes the raw request and the size of its response to the traffic capture.
+    void Capture_(const char* request, size_t len, bool keepAlive);
+
+    // Feeds the phases of a completed response to the metrics and the slow log, then resets the trace.
+    void FinishTrace_();
 };
 
 #endif //SLIM_WEB_SERVER_HTTP_CONNECT_H
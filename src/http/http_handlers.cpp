@@ -0,0 +1,199 @@
+//
+// Created by pyq on 10/19/26.
+//
+#include <cstring>
+#include <algorithm>
+#include "http_handlers.h"
+
+PageHandler::PageHandler(const std::string& file) : file_(file) {}
+
+void PageHandler::Handle(Router::Context& context, HttpResponse& response) {
+    response.SetFile(file_);
+}
+
+AuthHandler::AuthHandler(bool isLogin, const std::string& page) : isLogin_(isLogin), page_(page) {}
+
+void AuthHandler::Handle(Router::Context& context, HttpResponse& response) {
+    HttpRequest& request = context.request;
+    if (request.GetHeader("Content-Type") != "application/x-www-form-urlencoded") {
+        response.SetFile(page_);
+        return;
+    }
+    int ret = UserVerify(request.GetPost("username"), request.GetPost("password"), isLogin_);
+    if (ret == UserStore::OK) {
+        response.SetFile("/welcome.html");
+    } else if (ret == UserStore::STORE_UNAVAILABLE || ret == UserStore::STORE_TIMEOUT) {
+        // the user store is down or overloaded, tell the client to retry later
+        response.SetFile("/503.html", 503);
+    } else {
+        response.SetFile("/error.html");
+    }
+}
+
+int AuthHandler::UserVerify(const std::string& name, const std::string& pwd, bool isLogin) {
+    if (name == "" || pwd == "") {
+        return UserStore::NOT_FOUND;
+    }
+    LOG_INFO("Verify User: Name:%s", name.c_str());
+
+    // answer from the cache if possible
+    AuthCache* authCache = AuthCache::Instance();
+    int cached = isLogin ? authCache->CheckLogin(name, pwd) : authCache->CheckRegister(name);
+    if (cached != AuthCache::MISS) {
+        LOG_DEBUG("User %s Verified by Cache: %d", name.c_str(), cached);
+        if (cached == AuthCache::HIT_OK) {
+            return UserStore::OK;
+        }
+        return isLogin ? UserStore::NOT_FOUND : UserStore::ALREADY_EXISTS;
+    }
+
+    UserStore* userStore = UserStore::Instance();
+    if (!userStore) {
+        LOG_ERROR("UserStore is not Initialized!");
+        return UserStore::STORE_ERROR;
+    }
+    // fail fast while the user store is known to be down, 
+    // instead of piling requests up behind its timeouts
+    CircuitBreaker* breaker = UserStore::Breaker();
+    CircuitBreaker::Ticket ticket;
+    if (!breaker->Allow(&ticket)) {
+        LOG_WARN("UserStore Circuit Breaker Open, User %s Rejected", name.c_str());
+        return UserStore::STORE_UNAVAILABLE;
+    }
+    UserStore::Deadline deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(AUTH_TIMEOUT_MS);
+    int ret = isLogin ? userStore->Login(name, pwd, deadline) : userStore->Register(name, pwd, deadline);
+    if (ret == UserStore::STORE_ERROR || ret == UserStore::STORE_TIMEOUT) {
+        breaker->OnFailure(ticket);
+    } else {
+        breaker->OnSuccess(ticket);
+    }
+
+    if (ret == UserStore::OK) {
+        if (isLogin) {
+            LOG_DEBUG("User %s Logged In Successfully", name.c_str());
+            authCache->OnLoginVerified(name, pwd);
+        } else {
+            LOG_DEBUG("Registered User %s", name.c_str());
+            authCache->OnRegistered(name, pwd);
+        }
+    } else if (ret == UserStore::NOT_FOUND) {
+        // login request and the user does not exist
+        LOG_DEBUG("User %s not found!", name.c_str());
+        authCache->OnUserAbsent(name);
+    } else if (ret == UserStore::WRONG_PASSWORD) {
+        LOG_DEBUG("User %s Password Error", name.c_str());
+        authCache->OnUserExists(name);
+    } else if (ret == UserStore::ALREADY_EXISTS) {
+        // register request and user name already exists
+        LOG_DEBUG("User %s Already Exists", name.c_str());
+        authCache->OnUserExists(name);
+    }
+    return ret;
+}
+
+void MetricsHandler::Handle(Router::Context& context, HttpResponse& response) {
+    // Prometheus text exposition format
+    response.SetContent(Metrics::Instance()->Scrape(), "text/plain; version=0.0.4");
+}
+
+void ProfileHandler::Handle(Router::Context& context, HttpResponse& response) {
+    // admin only: the profiler pauses a worker for seconds and exposes the code layout
+    if (context.addr.sin_addr.s_addr != htonl(INADDR_LOOPBACK)) {
+        LOG_WARN("Client(%s) Denied Profile", inet_ntoa(context.addr.sin_addr));
+        response.SetContent("forbidden\n", "text/plain", 403);
+        return;
+    }
+    // /debug/profile?seconds=10&hz=99 eg.
+    // the request must finish well within the connection timeout of the timer
+    int seconds = atoi(context.request.GetQuery("seconds").c_str());
+    int hz = atoi(context.request.GetQuery("hz").c_str());
+    seconds = seconds > 0 ? std::min(seconds, 30) : 10;
+    hz = hz > 0 ? std::min(hz, 1000) : 99;
+    std::string folded;
+    int ret = CpuProfiler::Instance()->Profile(seconds, hz, &folded);
+    if (ret == CpuProfiler::BUSY) {
+        response.SetContent("another profile is running\n", "text/plain", 409);
+        return;
+    }
+    if (ret != CpuProfiler::OK) {
+        response.SetContent("profiler timer error\n", "text/plain", 500);
+        return;
+    }
+    response.SetContent(folded, "text/plain");
+}
+
+UploadHandler::UploadHandler(const std::string& dir) : dir_(dir) {}
+
+bool UploadHandler::OnHeaders(Router::Context& context) {
+    std::string boundary;
+    if (!MultipartReader::ParseBoundary(context.request.GetHeader("Content-Type"), &boundary)) {
+        // not a form with files, answered with 415 before the body is read
+        return false;
+    }
+    context.request.SetBodyReader(std::unique_ptr<HttpRequest::BodyReader>(new MultipartReader(boundary, dir_)));
+    return true;
+}
+
+void UploadHandler::Handle(Router::Context& context, HttpResponse& response) {
+    MultipartReader* reader = static_cast<MultipartReader*>(context.request.GetBodyReader());
+    if (!reader) {
+        response.SetError(415);
+        return;
+    }
+    if (!reader->IsComplete()) {
+        // the temporary files are removed with the reader
+        response.SetError(reader->Code() ? reader->Code() : 400);
+        return;
+    }
+    // {"files": [{"name": "a.txt", "bytes": 12}]} eg. a file that is already there is not replaced
+    int code = 200;
+    std::string out = "{\"files\": [";
+    const std::vector<MultipartReader::Part>& parts = reader->Parts();
+    for (size_t i = 0; i < parts.size(); ++i) {
+        if (parts[i].filename.empty()) {
+            continue;
+        }
+        std::string name = SafeName_(parts[i].filename);
+        std::string error;
+        // only a name that is taken is the client's conflict, a failing disk is the server's error
+        int partCode = 409;
+        if (name.empty()) {
+            error = "bad name";
+        } else if (!reader->Keep(i, dir_ + "/" + name)) {
+            if (errno == EEXIST) {
+                error = "exists";
+            } else {
+                error = strerror(errno);
+                partCode = errno == ENOSPC ? 507 : 500;
+            }
+        }
+        if (!error.empty()) {
+            LOG_WARN("Client(%s) Upload %s Error: %s", inet_ntoa(context.addr.sin_addr), name.c_str(), error.c_str());
+            // the most severe error of the parts is the status of the response
+            code = std::max(code, partCode);
+        }
+        if (out.back() == '}') {
+            out += ", ";
+        }
+        out += "{\"name\": \"" + name + "\", \"bytes\": " + std::to_string(parts[i].size);
+        out += error.empty() ? "}" : ", \"error\": \"" + error + "\"}";
+    }
+    out += "]}\n";
+    response.SetContent(out, "application/json", code);
+}
+
+std::string UploadHandler::SafeName_(const std::string& filename) {
+    // browsers on Windows may send C:\path\a.txt
+    size_t slash = filename.find_last_of("/\\");
+    std::string name = filename.substr(slash == std::string::npos ? 0 : slash + 1, 255);
+    for (char& ch : name) {
+        if (!isalnum(static_cast<unsigned char>(ch)) && ch != '.' && ch != '_' && ch != '-') {
+            ch = '_';
+        }
+    }
+    // no hidden files, which is also where the temporary files live
+    if (name.empty() || name[0] == '.') {
+        return "";
+    }
+    return name;
+}
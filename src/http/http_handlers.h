@@ -0,0 +1,82 @@
+//
+// Created by pyq on 10/19/26.
+//
+#pragma once
+#ifndef SLIM_WEB_SERVER_HTTP_HANDLERS_H
+#define SLIM_WEB_SERVER_HTTP_HANDLERS_H
+
+#include <string>
+#include <arpa/inet.h>
+#include "http_request.h"
+#include "http_response.h"
+#include "multipart_reader.h"
+#include "../router/router.h"
+#include "../log/log.h"
+#include "../auth_cache/auth_cache.h"
+#include "../user_store/user_store.h"
+#include "../metrics/metrics.h"
+#include "../profiler/cpu_profiler.h"
+
+// Serves a fixed file under srcDir, e.g. /index.html for "/".
+class PageHandler : public Router::Handler {
+public:
+    explicit PageHandler(const std::string& file);
+
+    void Handle(Router::Context& context, HttpResponse& response) override;
+
+private:
+    std::string file_;      // Path of the file under srcDir.
+};
+
+// Verifies the form of a login or register POST against the user store and serves the welcome, error or 503 page.
+// A POST that is not a form gets the page of the form itself.
+class AuthHandler : public Router::Handler {
+public:
+    // page is the file of the form, e.g. /login.html.
+    AuthHandler(bool isLogin, const std::string& page);
+
+    void Handle(Router::Context& context, HttpResponse& response) override;
+
+    // Verifies user credentials for login or registration, returns a UserStore::RESULT.
+    static int UserVerify(const std::string& name, const std::string& pwd, bool isLogin);
+
+private:
+    // Time budget of a login or register request in the user store.
+    static const int AUTH_TIMEOUT_MS = 2000;
+
+    bool isLogin_;          // Login, otherwise register.
+    std::string page_;      // File of the form.
+};
+
+// Serves the Prometheus text rendered by the metrics module.
+class MetricsHandler : public Router::Handler {
+public:
+    void Handle(Router::Context& context, HttpResponse& response) override;
+};
+
+// Runs the CPU profiler for the requested duration and serves the folded stacks, only to loopback clients.
+class ProfileHandler : public Router::Handler {
+public:
+    void Handle(Router::Context& context, HttpResponse& response) override;
+};
+
+// Stores the files of a multipart/form-data POST under a directory and lists them as JSON.
+// The files go from the read buffer to disk while they arrive, an upload is not held in memory.
+class UploadHandler : public Router::Handler {
+public:
+    // dir holds the uploaded files and, while they arrive, their temporary files.
+    explicit UploadHandler(const std::string& dir);
+
+    bool OnHeaders(Router::Context& context) override;
+
+    void Handle(Router::Context& context, HttpResponse& response) override;
+
+private:
+    std::string dir_;       // Directory of the uploaded files.
+
+    // Returns a name to store a file under, made of the last path segment of the name sent by the client
+    // with every character but [A-Za-z0-9._-] replaced, empty if no safe name can be made.
+    static std::string SafeName_(const std::string& filename);
+};
+
+#endif //SLIM_WEB_SERVER_HTTP_HANDLERS_H
@@ -1,27 +1,26 @@
 //
 // Created by pyq on 5/10/24.
 //
+#include <cctype>
+#include <strings.h>
 #include "http_request.h"
 
-const std::unordered_set<std::string> HttpRequest::DEFAULT_HTML = {
-    "/index",
-    "/register",
-    "/login",
-    "/welcome",
-    "/video",
-    "/picture",
-};
-
-const std::unordered_map<std::string, int> HttpRequest::DEFAULT_HTML_TAG = {
-    {"/register.html", 0},
-    {"/login.html", 1},
-};
+size_t HttpRequest::maxBodySize = 1 << 20;
 
 void HttpRequest::Init() {
-    method_ = path_ = version_ = body_ = "";
+    method_ = path_ = query_ = version_ = body_ = "";
     state_ =  REQUEST_LINE;
+    code_ = 200;
     header_.clear();
-    post_.clear();
+    postForm_.Clear();
+    queryForm_.Clear();
+    bodyReader_.reset();
+    headerBytes_ = 0;
+    isChunked_ = false;
+    chunkState_ = CHUNK_SIZE;
+    bodyLeft_ = 0;
+    bodyBytes_ = 0;
+    isAborted_ = false;
 }
 
 std::string HttpRequest::Path() const {
@@ -42,68 +41,140 @@ std::string HttpRequest::Version() const {
 
 std::string HttpRequest::GetPost(const std::string& key) const {
     assert(key != "");
-    if (post_.count(key) > 0) {
-        return post_.find(key)->second;
-    }
-    return "";
+    return postForm_.Get(key);
 }
 
 std::string HttpRequest::GetPost(const char* key) const {
     assert(key && key[0] != '\0');
-    if (post_.count(key) > 0) {
-        return post_.find(key)->second;
+    const char* value;
+    size_t len;
+    if (postForm_.Get(key, strlen(key), &value, &len)) {
+        return std::string(value, len);
     }
     return "";
 }
 
+std::string HttpRequest::GetQuery(const std::string& key) const {
+    assert(key != "");
+    return queryForm_.Get(key);
+}
+
+const UrlForm& HttpRequest::Post() const {
+    return postForm_;
+}
+
+const UrlForm& HttpRequest::Query() const {
+    return queryForm_;
+}
+
+std::string HttpRequest::GetHeader(const std::string& key) const {
+    auto it = header_.find(CanonicalName_(key));
+    return it == header_.end() ? "" : it->second;
+}
+
+int HttpRequest::Code() const {
+    return code_;
+}
+
+HttpRequest::PARSE_STATE HttpRequest::State() const {
+    return state_;
+}
+
+const std::string& HttpRequest::Body() const {
+    return body_;
+}
+
+void HttpRequest::SetBodyReader(std::unique_ptr<BodyReader> reader) {
+    bodyReader_ = std::move(reader);
+}
+
+HttpRequest::BodyReader* HttpRequest::GetBodyReader() const {
+    return bodyReader_.get();
+}
+
+void HttpRequest::AbortBody() {
+    if (state_ == BODY) {
+        isAborted_ = true;
+        state_ = FINISH;
+    }
+}
+
+bool HttpRequest::IsBodyAborted() const {
+    return isAborted_;
+}
+
 bool HttpRequest::IsKeepAlive() const {
-    if (header_.count("Connection") > 0) {
-        return header_.find("Connection")->second == "keep-alive" && version_ == "1.1"; 
+    // the unread rest of an aborted body would be taken for the next request
+    if (header_.count("Connection") > 0 && !isAborted_) {
+        return strcasecmp(header_.find("Connection")->second.c_str(), "keep-alive") == 0 && version_ == "1.1";
     }
     return false;
 }
 
 bool HttpRequest::ParseHttpRequest(Buffer& buff) {
-    const char CRLF[] = "\r\n";
-    if (buff.GetReadableBytes() <= 0) {
-        return false;
+    if (Parse_(buff)) {
+        return true;
     }
-    while (buff.GetReadableBytes() && state_ != FINISH) {
+    // nothing after a malformed request can be framed, it is the last one of the connection
+    state_ = FINISH;
+    isAborted_ = true;
+    return false;
+}
+
+bool HttpRequest::Parse_(Buffer& buff) {
+    const char CRLF[] = "\r\n";
+    while (state_ == REQUEST_LINE || state_ == HEADER) {
         // lineEnd is a pointer to the beginning of the found CRLF sequence in buffer. 
         // If not found, lineEnd will point to the return value of buff.BeginWriteConst().
         const char* lineEnd = std::search(buff.BeginRead(), buff.BeginWriteConst(), CRLF, CRLF + 2);
+        if (lineEnd == buff.BeginWriteConst()) {
+            // the rest of the line comes with a later read, unless the line is already too long
+            if (buff.GetReadableBytes() > MAX_LINE) {
+                code_ = state_ == REQUEST_LINE ? 414 : 431;
+                return false;
+            }
+            return true;
+        }
+        // a whole line that came with one read is held to the same limit as one still arriving
+        if (static_cast<size_t>(lineEnd - buff.BeginRead()) > MAX_LINE) {
+            code_ = state_ == REQUEST_LINE ? 414 : 431;
+            return false;
+        }
 
         // line contains all characters from the beginning of the buffer to the first CRLF, excluding the CRLF itself.
         // parse the request according to state_
         std::string line(buff.BeginRead(), lineEnd);
-        switch (state_) {
-            case REQUEST_LINE:
-                if (!ParseRequestLine_(line)) {
-                    return false;
-                }
-                ParsePath_();
-                break;
-            case HEADER:
-                ParseHeader_(line);
-                if (buff.GetReadableBytes() <= 2) {
-                    state_ = FINISH;
-                }
-                break;
-            case BODY:
-                ParseBody_(line);
-                break;
-            default:
-                break;
+        buff.AdvanceReadPointer(lineEnd + 2 - buff.BeginRead());
+        headerBytes_ += line.size() + 2;
+        if (headerBytes_ > MAX_HEADER) {
+            code_ = 431;
+            return false;
         }
-        if (lineEnd == buff.BeginWrite()) {
-            if(method_=="POST"&&state_==FINISH){
-                buff.AdvanceReadPointer(lineEnd - buff.BeginRead());
+        if (state_ == REQUEST_LINE) {
+            // empty lines before a request, e.g. a CRLF sent after the previous body, are ignored
+            if (line.empty()) {
+                continue;
             }
-            break;
+            if (!ParseRequestLine_(line)) {
+                code_ = 400;
+                return false;
+            }
+            if (!ParsePath_()) {
+                code_ = 400;
+                return false;
+            }
+        } else if (line.empty()) {
+            // the headers end at an empty line, stop so that the caller can set a body reader
+            LOG_DEBUG("[%s], [%s], [%s]", method_.c_str(), path_.c_str(), version_.c_str());
+            return ParseFraming_();
+        } else if (!ParseHeader_(line)) {
+            code_ = 400;
+            return false;
         }
-        buff.AdvanceReadPointer(lineEnd + 2 - buff.BeginRead());
     }
-    LOG_DEBUG("[%s], [%s], [%s]", method_.c_str(), path_.c_str(), version_.c_str());
+    if (state_ == BODY) {
+        return isChunked_ ? ParseChunked_(buff) : ParseBody_(buff);
+    }
     return true;
 }
 
@@ -124,20 +195,29 @@ bool HttpRequest::ParseRequestLine_(const std::string& line) {
     return false;
 }
 
-void HttpRequest::ParsePath_() {
-    if (path_ == "/") {
-        path_ = "/index.html";
-    } else {
-        for (auto &item : DEFAULT_HTML) {
-            if (path_ == item) {
-                path_ += ".html";
-                break;
-            }
+bool HttpRequest::ParsePath_() {
+    std::string::size_type idx = path_.find('?');
+    if (idx != std::string::npos) {
+        // the fields point into query_, which keeps its capacity from request to request
+        query_.assign(path_, idx + 1, std::string::npos);
+        path_.erase(idx);
+        query_.resize(queryForm_.Parse(&query_[0], query_.size()));
+    }
+    path_.resize(UrlForm::DecodePath(&path_[0], path_.size()));
+    // a ".." segment, also when sent as %2e%2e, would leave srcDir, and a NUL would cut the file name short
+    if (path_.find('\0') != std::string::npos) {
+        return false;
+    }
+    for (idx = path_.find("/.."); idx != std::string::npos; idx = path_.find("/..", idx + 1)) {
+        if (idx + 3 == path_.size() || path_[idx + 3] == '/') {
+            LOG_WARN("Path %s Outside srcDir!", path_.c_str());
+            return false;
         }
     }
+    return true;
 }
 
-void HttpRequest::ParseHeader_(const std::string& header) {
+bool HttpRequest::ParseHeader_(const std::string& header) {
     // use regular expressions to parse a single header line in an HTTP request. 
     // separate the key and value of the header and store them in a map.
     // Host: www.example.com
@@ -147,79 +227,166 @@ void HttpRequest::ParseHeader_(const std::string& header) {
     std::regex pattern("^([^:]*): ?(.*)$");
     std::smatch subMatch;
     if (std::regex_match(header, subMatch, pattern)) {
-        header_[subMatch[1]] = subMatch[2];
-    } else {
+        // field names are case-insensitive, content-length and Content-Length are one header
+        header_[CanonicalName_(subMatch[1])] = subMatch[2];
+        return true;
+    }
+    LOG_ERROR("Parse Header Error!");
+    return false;
+}
+
+bool HttpRequest::ParseFraming_() {
+    // a client waiting for 100 Continue is answered by the connection, other expectations are not supported
+    auto expect = header_.find("Expect");
+    if (expect != header_.end() && strcasecmp(expect->second.c_str(), "100-continue") != 0) {
+        code_ = 417;
+        return false;
+    }
+    // a request with both may be framed differently by a proxy in front, which is how requests are smuggled,
+    // so it is refused instead of letting Transfer-Encoding win; a request without either has no body
+    auto encoding = header_.find("Transfer-Encoding");
+    auto length = header_.find("Content-Length");
+    if (encoding != header_.end() && length != header_.end()) {
+        LOG_WARN("Both Transfer-Encoding and Content-Length!");
+        code_ = 400;
+        return false;
+    }
+    if (encoding != header_.end()) {
+        if (strcasecmp(encoding->second.c_str(), "chunked") != 0) {
+            code_ = 501;
+            return false;
+        }
+        isChunked_ = true;
+        chunkState_ = CHUNK_SIZE;
+        state_ = BODY;
+        return true;
+    }
+    if (length != header_.end()) {
+        const std::string& value = length->second;
+        if (value.empty() || value.size() > 18 || value.find_first_not_of("0123456789") != std::string::npos) {
+            code_ = 400;
+            return false;
+        }
+        bodyLeft_ = std::stoull(value);
+        if (bodyLeft_ > maxBodySize) {
+            code_ = 413;
+            return false;
+        }
+    }
+    if (bodyLeft_ > 0) {
         state_ = BODY;
+    } else {
+        FinishBody_();
     }
+    return true;
 }
 
-void HttpRequest::ParseBody_(const std::string& body) {
-    body_ = body;
-    ParsePostBody_();
-    state_ = FINISH;
-    LOG_DEBUG("RequestBody:%s, Len:%d", body.c_str(), body.size());
+bool HttpRequest::ParseBody_(Buffer& buff) {
+    size_t len = std::min(buff.GetReadableBytes(), bodyLeft_);
+    if (!AppendBody_(buff.BeginRead(), len)) {
+        return false;
+    }
+    buff.AdvanceReadPointer(len);
+    bodyLeft_ -= len;
+    if (bodyLeft_ == 0 && state_ == BODY) {
+        FinishBody_();
+    }
+    return true;
 }
 
-void HttpRequest::ParsePostBody_() {
-    if (method_ == "POST" && header_["Content-Type"] == "application/x-www-form-urlencoded") {
-        ParseFromUrlEncoded_();
-        if (DEFAULT_HTML_TAG.count(path_)) {
-            int tag = DEFAULT_HTML_TAG.find(path_)->second;
-            LOG_DEBUG("Tag:%d", tag);
-            if (tag == 0 || tag == 1) {
-                bool isLogin = (tag == 1);
-                if (UserVerify(post_["username"], post_["password"], isLogin)) {
-                    path_ = "/welcome.html";
-                } else {
-                    path_ = "/error.html";
+bool HttpRequest::ParseChunked_(Buffer& buff) {
+    // 1a;name=value\r\n<26 bytes>\r\n ... 0\r\n<trailer lines>\r\n eg. the extensions are ignored
+    const char CRLF[] = "\r\n";
+    while (state_ == BODY && buff.GetReadableBytes() > 0) {
+        if (chunkState_ == CHUNK_DATA) {
+            size_t len = std::min(buff.GetReadableBytes(), bodyLeft_);
+            if (!AppendBody_(buff.BeginRead(), len)) {
+                return false;
+            }
+            buff.AdvanceReadPointer(len);
+            bodyLeft_ -= len;
+            if (bodyLeft_ == 0) {
+                chunkState_ = CHUNK_DATA_END;
+            }
+            continue;
+        }
+        const char* lineEnd = std::search(buff.BeginRead(), buff.BeginWriteConst(), CRLF, CRLF + 2);
+        if (lineEnd == buff.BeginWriteConst()) {
+            if (buff.GetReadableBytes() > MAX_LINE) {
+                code_ = 400;
+                return false;
+            }
+            break;
+        }
+        const char* line = buff.BeginRead();
+        size_t lineLen = lineEnd - line;
+        if (lineLen > MAX_LINE) {
+            code_ = 400;
+            return false;
+        }
+        buff.AdvanceReadPointer(lineLen + 2);
+        if (chunkState_ == CHUNK_DATA_END) {
+            // the data of a chunk ends with a CRLF
+            if (lineLen != 0) {
+                code_ = 400;
+                return false;
+            }
+            chunkState_ = CHUNK_SIZE;
+        } else if (chunkState_ == CHUNK_SIZE) {
+            size_t size = 0, i = 0;
+            for (; i < lineLen && isxdigit(static_cast<unsigned char>(line[i])); ++i) {
+                size = size * 16 + ConvertHexToDec(line[i]);
+                if (bodyBytes_ + size > maxBodySize) {
+                    code_ = 413;
+                    return false;
                 }
             }
+            if (i == 0 || (i < lineLen && line[i] != ';' && line[i] != ' ' && line[i] != '\t')) {
+                code_ = 400;
+                return false;
+            }
+            bodyLeft_ = size;
+            chunkState_ = size > 0 ? CHUNK_DATA : CHUNK_TRAILER;
+        } else {
+            // the trailer fields are dropped, they count against the size of the headers
+            headerBytes_ += lineLen + 2;
+            if (headerBytes_ > MAX_HEADER) {
+                code_ = 431;
+                return false;
+            }
+            if (lineLen == 0) {
+                FinishBody_();
+            }
         }
     }
+    return true;
 }
 
-void HttpRequest::ParseFromUrlEncoded_() {
-    if (body_.size() == 0) {
-        return;
+bool HttpRequest::AppendBody_(const char* data, size_t len) {
+    bodyBytes_ += len;
+    if (bodyBytes_ > maxBodySize) {
+        code_ = 413;
+        return false;
     }
-    // username=johndoe&password=12345%21 for key value eg.
-    std::string key, value;
-    int num = 0, i = 0, j = 0, n = body_.size();
-    for (; i < n; ++i) {
-        char ch = body_[i];
-        switch (ch) {
-            case '=':
-                key = body_.substr(j, i - j);
-                j = i + 1;
-                break;
-            case '+':
-                body_[i] = ' ';
-                break;
-            case '%':
-                // Convert hexadecimal to characters
-                // %23 -> '#'
-                // standard url encoding format is %xx
-                num = ConvertHexToDec(body_[i + 1]) * 16 + ConvertHexToDec(body_[i + 2]);               
-                body_[i + 2] = num % 10 + '0';
-                body_[i + 1] = num / 10 + '0';
-                i += 2;
-                break;
-            case '&':
-                value = body_.substr(j, i - j);
-                j = i + 1;
-                post_[key] = value;
-                LOG_DEBUG("%s = %s", key.c_str(), value.c_str());
-                break;
-            default:
-                break;
-        }
+    if (!bodyReader_) {
+        body_.append(data, len);
+    } else if (!bodyReader_->Write(data, len)) {
+        // the reader refused the body, the handler answers with what it has
+        AbortBody();
     }
-    assert(j <= i);
-    // add the last key-value pair
-    // only if key does not exist and value is not empty
-    if (post_.count(key) == 0 && j < i) {
-        value = body_.substr(j, i - j);
-        post_[key] = value;
+    return true;
+}
+
+void HttpRequest::FinishBody_() {
+    state_ = FINISH;
+    ParsePostBody_();
+    LOG_DEBUG("RequestBody Len:%zu", bodyBytes_);
+}
+
+void HttpRequest::ParsePostBody_() {
+    // what the form means is up to the handler of the route, e.g. AuthHandler for /login
+    if (method_ == "POST" && header_["Content-Type"] == "application/x-www-form-urlencoded") {
+        body_.resize(postForm_.Parse(&body_[0], body_.size()));
     }
 }
 
@@ -239,75 +406,13 @@ int HttpRequest::ConvertHexToDec(char ch) {
     return ch;
 }
 
-bool HttpRequest::UserVerify (const std::string& name, const std::string& pwd, bool isLogin) {
-    if (name == "" || pwd == "") {
-        return false;
-    }
-    LOG_INFO("Verify User: Name:%s", name.c_str());
-    
-    // RAII must use named objects. 
-    // anonymous objects will be destructed 
-    // and resources will be released after this line of code is executed.
-    MYSQL* sqlConn;
-    SqlConnRAII sqlConnRAII(&sqlConn, SqlConnPool::Instance());
-    assert(sqlConn);
-
-    std::string query;
-    if (isLogin) {
-        // login request
-        query = "SELECT password FROM user WHERE username='" + name + "' LIMIT 1";
-    } else {
-        // register request
-        query = "SELECT username FROM user WHERE username='" + name + "' LIMIT 1";
-    }
-    LOG_DEBUG("SQL Query: %s", query.c_str());
-    
-    // send SQL statements to the MySQL server and execute 
-    if (mysql_query(sqlConn, query.c_str())) {
-        LOG_ERROR("SQL Error: %s", mysql_error(sqlConn));
-        return false;
-    }
-
-    // retrieve the complete result set returned by the SELECT, SHOW, DESCRIBE, or EXPLAIN statement 
-    // executed by the most recent call to mysql_query
-    MYSQL_RES* res = mysql_store_result(sqlConn);
-    // retrieve data row by row from the result set returned by mysql_store_result. 
-    // it returns a MYSQL_ROW structure, which is actually an array of strings 
-    // where each element corresponds to a field value in a row in the result set.
-    MYSQL_ROW row = mysql_fetch_row(res);
-    if (!row) {
-        // query result is empty
-        mysql_free_result(res);
-        if (isLogin) {
-            // login request and the user does not exist
-            LOG_DEBUG("User %s not found!", name.c_str());
-            return false;
-        } else {
-            // register user (user name is not been used)
-            query = "INSERT INTO user(username, password) VALUES('" + name + "','" + pwd + "')";
-            LOG_DEBUG("SQL Query: %s", query.c_str());
-            if (mysql_query(sqlConn, query.c_str())) {
-                LOG_ERROR("SQL Insert Error: %s", mysql_error(sqlConn));
-                return false;
-            }
-            LOG_DEBUG("Registered User %s", name.c_str());
-            return true;
-        }
-    } else if (isLogin) {
-        // check the login information
-        std::string password(row[0]);
-        mysql_free_result(res);
-        if (pwd == password) {
-            LOG_DEBUG("User %s Logged In Successfully", name.c_str());
-            return true;
-        } else {
-            LOG_DEBUG("User %s Password Error", name.c_str());
-            return false;
-        }
-    } else {
-        // register request and user name already exists
-        mysql_free_result(res);
-        LOG_DEBUG("User %s Already Exists", name.c_str());
-        return false;
+std::string HttpRequest::CanonicalName_(const std::string& name) {
+    // a letter at the start or after '-' is upper case, the others lower case
+    std::string canonical(name);
+    bool isStart = true;
+    for (char& ch : canonical) {
+        ch = isStart ? toupper(static_cast<unsigned char>(ch)) : tolower(static_cast<unsigned char>(ch));
+        isStart = ch == '-';
     }
-}
\ No newline at end of file
+    return canonical;
+}
@@ -6,15 +6,13 @@
 #define SLIM_WEB_SERVER_HTTP_REQUEST_H
 
 #include <string>
+#include <memory>
 #include <regex>
 #include <unordered_map>
-#include <unordered_set>
 #include <errno.h>
-#include <mysql/mysql.h>
 #include "../log/log.h"
 #include "../buffer/buffer.h"
-#include "../sql_connect/sql_connect.h"
-#include "../sql_connect/sql_connect_raii.h"
+#include "url_form.h"
 
 // HttpRequest class handles parsing and storage of an HTTP request.
 class HttpRequest {
@@ -39,6 +37,16 @@ public:
         CLOSED_CONNECTION,
     };
 
+    // Consumer of a request body, handed the decoded body slice by slice as it arrives.
+    class BodyReader {
+    public:
+        virtual ~BodyReader() = default;
+
+        // Takes the next slice of the body, which points into the read buffer and is only valid during the call.
+        // Returning false stops the body, the rest is not read and the connection closes after the response.
+        virtual bool Write(const char* data, size_t len) = 0;
+    };
+
     HttpRequest() {Init();};
 
     ~HttpRequest() = default;
@@ -58,56 +66,126 @@ public:
     // Returns the HTTP version specified in the request.
     std::string Version() const;
 
-    // Retrieves the value associated with a key in the POST request body.
-    
+    // Retrieves the decoded value associated with a key in a URL-encoded form POST body.
     std::string GetPost(const std::string& key) const;
 
     // Overloaded version of GetPost to handle C-style string keys.
     std::string GetPost(const char* key) const;
 
+    // Retrieves the decoded value of a key in the query string.
+    std::string GetQuery(const std::string& key) const;
+
+    // Returns the fields of a URL-encoded form POST body, views into the body without copies.
+    const UrlForm& Post() const;
+
+    // Returns the fields of the query string, views into the request without copies.
+    const UrlForm& Query() const;
+
+    // Retrieves the value of a header field, empty if the request does not have it. The name is case-insensitive.
+    std::string GetHeader(const std::string& key) const;
+
+    // Returns the HTTP status code decided while parsing.
+    int Code() const;
+
+    // Returns the state of the parser, BODY while the body is still arriving.
+    PARSE_STATE State() const;
+
+    // Returns the body collected in memory, empty if it went to a BodyReader. A URL-encoded form is decoded
+    // in place, its fields are read through GetPost or Post.
+    const std::string& Body() const;
+
+    // Hands the body to reader instead of collecting it, called once the headers are parsed.
+    void SetBodyReader(std::unique_ptr<BodyReader> reader);
+
+    // Returns the reader given to SetBodyReader, nullptr if none.
+    BodyReader* GetBodyReader() const;
+
+    // Gives up on the rest of the body, the request is finished and the connection closes after the response.
+    void AbortBody();
+
+    // Returns true if the request was not read to its end, because of AbortBody, its reader or an error.
+    bool IsBodyAborted() const;
+
     // Determines whether the connection should be kept alive based on the "Connection" header.
     bool IsKeepAlive() const;
 
-    // Parses the HTTP request from a buffer.
+    // Parses as much of the request as the buffer holds and consumes what it parsed, a request may come in
+    // several reads. Stops once the headers are parsed so that the caller can pick a BodyReader, the next
+    // call goes on with the body. Returns false on a malformed request, Code() is then its status code.
     bool ParseHttpRequest(Buffer& buff);
 
+    static size_t maxBodySize;      // Largest body accepted, larger ones are answered with 413.
+
 private:
+    // Enumerates the states of the chunked transfer coding.
+    enum CHUNK_STATE {
+        CHUNK_SIZE,         // Size line of the next chunk.
+        CHUNK_DATA,         // Data of a chunk, bodyLeft_ bytes to go.
+        CHUNK_DATA_END,     // CRLF after the data.
+        CHUNK_TRAILER,      // Trailer lines after the last chunk, up to an empty line.
+    };
+
+    static const size_t MAX_LINE = 8192;        // Longest request, header, chunk size or trailer line.
+    static const size_t MAX_HEADER = 65536;     // Largest request line and headers together.
+
     // Current state of the parsing process.
     PARSE_STATE state_;
 
+    // HTTP status code decided while parsing.
+    int code_;
+
     // Stores the method, path, version, and body of the HTTP request.
     std::string method_;
     std::string path_;
+    std::string query_;     // Query string after '?', removed from path_, decoded in place.
     std::string version_;
-    std::string body_;
-    std::unordered_map<std::string, std::string> header_;               // Stores header key-value pairs.
-    std::unordered_map<std::string, std::string> post_;                 // Stores POST data key-value pairs.
-    static const std::unordered_set<std::string> DEFAULT_HTML;          // Stores HttpRequest object by resetting all member variables.
-    static const std::unordered_map<std::string, int> DEFAULT_HTML_TAG; // Used to distinguish between login and registration according to the path_
+    std::string body_;      // Body collected in memory when there is no body reader.
+    std::unique_ptr<BodyReader> bodyReader_;    // Consumer of the body, nullptr to collect it in body_.
+    size_t headerBytes_;    // Bytes of the request line and headers parsed so far.
+    bool isChunked_;        // The body uses the chunked transfer coding, otherwise it has a Content-Length.
+    CHUNK_STATE chunkState_;    // State of the chunked decoder.
+    size_t bodyLeft_;       // Bytes left of the body, or of the current chunk if chunked.
+    size_t bodyBytes_;      // Bytes of the body decoded so far.
+    bool isAborted_;        // The body was not read to its end.
+    std::unordered_map<std::string, std::string> header_;               // Stores header key-value pairs, canonical names.
+    UrlForm postForm_;      // Fields of a URL-encoded form POST body, views into body_.
+    UrlForm queryForm_;     // Fields of the query string, views into query_.
+
+    // Parses what the buffer holds for ParseHttpRequest, returns false on a malformed request.
+    bool Parse_(Buffer& buff);
 
     // Parses the request line to extract method, path, and version.
     bool ParseRequestLine_(const std::string& line);
 
-    // Adjusts the path to handle default and HTML requests.
-    void ParsePath_();
+    // Splits the query string off the path and decodes both, returns false if the path leaves srcDir.
+    bool ParsePath_();
 
-    // Parses a header line and stores the key-value pair in the header map.
-    void ParseHeader_(const std::string& header);
+    // Parses a header line and stores the key-value pair in the header map, returns false if malformed.
+    bool ParseHeader_(const std::string& header);
 
-    // Sets the body of the request and parses POST data if applicable.
-    void ParseBody_(const std::string& body);
+    // Reads the framing of the body from the headers once they are complete, returns false if invalid.
+    bool ParseFraming_();
 
-    // Parses the body for URL-encoded POST data.
-    void ParsePostBody_();
+    // Consumes the body bytes of a Content-Length body that the buffer holds, returns false on an error.
+    bool ParseBody_(Buffer& buff);
+
+    // Consumes the chunks of a chunked body that the buffer holds, returns false on an error.
+    bool ParseChunked_(Buffer& buff);
 
-    // Decodes URL-encoded strings into their original form.
-    void ParseFromUrlEncoded_();
+    // Hands a slice of the decoded body to the reader or appends it to body_, returns false past the limit.
+    bool AppendBody_(const char* data, size_t len);
+
+    // Finishes the request once the body is complete.
+    void FinishBody_();
+
+    // Decodes the body of a URL-encoded form POST.
+    void ParsePostBody_();
 
     // Converts a single hexadecimal character to its decimal equivalent.
     static int ConvertHexToDec(char ch);
 
-    // Verifies user credentials for login or registration.
-    static bool UserVerify (const std::string& name, const std::string& pwd, bool isLogin);
+    // Returns the canonical form of a header name, content-length -> Content-Length eg.
+    static std::string CanonicalName_(const std::string& name);
 };
 
 #endif //SLIM_WEB_SERVER_HTTP_REQUEST_H
@@ -30,15 +30,27 @@ const std::unordered_map<int, std::string> HttpResponse::CODE_STATUS = {
     {400, "Bad Request"},
     {403, "Forbidden"},
     {404, "Not Found"},
+    {409, "Conflict"},
+    {413, "Payload Too Large"},
+    {414, "URI Too Long"},
+    {415, "Unsupported Media Type"},
+    {417, "Expectation Failed"},
+    {431, "Request Header Fields Too Large"},
+    {500, "Internal Server Error"},
+    {501, "Not Implemented"},
+    {503, "Service Unavailable"},
+    {507, "Insufficient Storage"},
 };
 
 const std::unordered_map<int, std::string> HttpResponse::ERROR_CODE_PATH = {
     {400, "/400.html"},
     {403, "/403.html"},
     {404, "/404.html"},
+    {503, "/503.html"},
 };
 
-HttpResponse::HttpResponse() : code_(-1), isKeepAlive_(false), path_(""), srcDir_(""), mmFile_(nullptr), mmFileStat_({0}) {}
+HttpResponse::HttpResponse() : code_(-1), isKeepAlive_(false), path_(""), srcDir_(""), mmFile_(nullptr), mmFileStat_({0}), hasContent_(false),
+                               isStreamDone_(false), isChunked_(true) {}
 
 HttpResponse::~HttpResponse() {
     UnmapFile();
@@ -55,6 +67,87 @@ void HttpResponse::Init(const std::string& srcDir, std::string& path, bool isKee
     code_ = code;
     mmFile_ = nullptr;
     mmFileStat_ = {0};
+    hasContent_ = false;
+    content_.clear();
+    ResetStream();
+}
+
+void HttpResponse::SetContent(const std::string& content, const std::string& type, int code) {
+    hasContent_ = true;
+    content_ = content;
+    contentType_ = type;
+    code_ = code;
+}
+
+void HttpResponse::SetStream(std::unique_ptr<Stream> stream, const std::string& type, int code) {
+    hasContent_ = false;
+    stream_ = std::move(stream);
+    isStreamDone_ = false;
+    isChunked_ = true;
+    contentType_ = type;
+    code_ = code;
+}
+
+void HttpResponse::StreamUntilClose() {
+    isChunked_ = false;
+    isKeepAlive_ = false;
+}
+
+bool HttpResponse::IsStreaming() const {
+    return stream_ && !isStreamDone_;
+}
+
+void HttpResponse::NextChunk(Buffer& buff, size_t maxBytes) {
+    if (!IsStreaming()) {
+        return;
+    }
+    size_t start = buff.GetReadableBytes();
+    while (IsStreaming() && buff.GetReadableBytes() - start < maxBytes) {
+        piece_.clear();
+        isStreamDone_ = !stream_->Next(piece_, maxBytes - (buff.GetReadableBytes() - start));
+        if (piece_.empty()) {
+            continue;
+        }
+        if (isChunked_) {
+            // 1a2f\r\n<piece>\r\n eg.
+            char size[24];
+            int len = snprintf(size, sizeof(size), "%zx\r\n", piece_.size());
+            buff.Append(size, len);
+        }
+        buff.Append(piece_);
+        if (isChunked_) {
+            buff.Append("\r\n", 2);
+        }
+    }
+    if (isStreamDone_ && isChunked_) {
+        // the last chunk, no trailers
+        buff.Append("0\r\n\r\n", 5);
+    }
+}
+
+void HttpResponse::ResetStream() {
+    stream_.reset();
+    isStreamDone_ = false;
+    isChunked_ = true;
+}
+
+void HttpResponse::SetFile(const std::string& path, int code) {
+    hasContent_ = false;
+    path_ = path;
+    if (code != -1) {
+        code_ = code;
+    }
+}
+
+void HttpResponse::SetError(int code) {
+    auto it = ERROR_CODE_PATH.find(code);
+    if (it != ERROR_CODE_PATH.end()) {
+        SetFile(it->second, code);
+    } else if (CODE_STATUS.count(code) > 0) {
+        SetContent(CODE_STATUS.find(code)->second + "\n", "text/plain", code);
+    } else {
+        SetFile("/400.html", 400);
+    }
 }
 
 void HttpResponse::UnmapFile() {
@@ -65,6 +158,23 @@ void HttpResponse::UnmapFile() {
 }
 
 void HttpResponse::MakeResponse(Buffer& buff) {
+    if (hasContent_) {
+        // the body is already in memory, no file to map
+        AddStateLine_(buff);
+        AddHeader_(buff);
+        buff.Append("Content-Length: " + std::to_string(content_.size()) + "\r\n\r\n");
+        buff.Append(content_);
+        SLIM_PROBE3(make_response, code_, path_.c_str(), content_.size());
+        return;
+    }
+    if (stream_) {
+        // the body follows as it is produced, without a length
+        AddStateLine_(buff);
+        AddHeader_(buff);
+        buff.Append(isChunked_ ? "Transfer-Encoding: chunked\r\n\r\n" : "\r\n");
+        SLIM_PROBE3(make_response, code_, path_.c_str(), 0);
+        return;
+    }
     // construct a response header and push to the buffer
     if (stat((srcDir_ + path_).data(), &mmFileStat_) < 0 || S_ISDIR(mmFileStat_.st_mode)) {
         // file does not exist or directory accessed
@@ -81,6 +191,7 @@ void HttpResponse::MakeResponse(Buffer& buff) {
     AddStateLine_(buff);
     AddHeader_(buff);
     AddContent_(buff);
+    SLIM_PROBE3(make_response, code_, path_.c_str(), mmFileStat_.st_size);
 }
 
 char* HttpResponse::GetFile() {
@@ -165,6 +276,9 @@ void HttpResponse::SetErrorCodePath_() {
 }
 
 std::string HttpResponse::GetFileType_() {
+    if (hasContent_ || stream_) {
+        return contentType_;
+    }
     std::string::size_type idx = path_.find_last_of('.');
     if (idx == std::string::npos) {
         // not find '.'
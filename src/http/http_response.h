@@ -9,13 +9,27 @@
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/mman.h>
+#include <memory>
 #include <unordered_map>
 #include "../log/log.h"
 #include "../buffer/buffer.h"
+#include "../probe/probe.h"
 
 // Class for handling HTTP responses, including file mapping, status management, and header content generation.
 class HttpResponse {
 public:
+    // Produces the body of a streamed response piece by piece, see SetStream.
+    // The connection asks for the next piece only after everything before it was written to the socket,
+    // so a slow client pauses the producer instead of letting the body pile up in memory.
+    class Stream {
+    public:
+        virtual ~Stream() = default;
+
+        // Appends the next piece of the body to out, about maxBytes at most, and returns false after the last one.
+        // Runs on a worker thread and must not block; a call that returns true must append something.
+        virtual bool Next(std::string& out, size_t maxBytes) = 0;
+    };
+
     // Constructor: Initializes response with default values.
     HttpResponse();
 
@@ -40,6 +54,31 @@ public:
     // Returns the HTTP status code.
     int GetCode() const;
 
+    // Serves content generated in memory instead of a file under srcDir, call after Init.
+    void SetContent(const std::string& content, const std::string& type, int code = 200);
+
+    // Serves another file under srcDir instead of the request path, call after Init; -1 keeps the code of Init.
+    void SetFile(const std::string& path, int code = -1);
+
+    // Serves the error page of code, or a short text body for a code without a page, call after Init.
+    void SetError(int code);
+
+    // Serves a body produced by a stream with Transfer-Encoding: chunked, call after Init.
+    void SetStream(std::unique_ptr<Stream> stream, const std::string& type, int code = 200);
+
+    // Delimits a streamed body by closing the connection instead of chunks, for HTTP/1.0 clients.
+    void StreamUntilClose();
+
+    // Returns true while a streamed body has pieces left.
+    bool IsStreaming() const;
+
+    // Appends the next pieces of a streamed body to buff, about maxBytes, framed as chunks.
+    // The last chunk is appended together with the final piece.
+    void NextChunk(Buffer& buff, size_t maxBytes);
+
+    // Drops the stream, e.g. when the connection closes before the body was complete.
+    void ResetStream();
+
     // Generates HTML content for error messages and appends it to the response buffer.
     void MakeErrorContent(Buffer& buff, std::string message);
 
@@ -50,6 +89,13 @@ private:
     std::string srcDir_;        // Directory of the source files.
     char* mmFile_;              // Pointer to the memory-mapped file data.
     struct stat mmFileStat_;    // File status structure.
+    bool hasContent_;           // Flag indicating the body is content_ rather than a file.
+    std::string content_;       // Body generated in memory.
+    std::string contentType_;   // MIME type of content_ or of the stream.
+    std::unique_ptr<Stream> stream_;    // Producer of a streamed body, nullptr for a file or content_.
+    bool isStreamDone_;         // The stream returned its last piece.
+    bool isChunked_;            // The streamed body is framed as chunks, otherwise it ends with the connection.
+    std::string piece_;         // Piece of the stream being framed, reused between pieces.
     static const std::unordered_map<std::string, std::string> CONTENT_TYPE;     // Map of file extensions to MIME types.
     static const std::unordered_map<int, std::string> CODE_STATUS;              // Map of status codes to messages.
     static const std::unordered_map<int, std::string> ERROR_CODE_PATH;          // Map of error codes to error document paths.
@@ -0,0 +1,320 @@
+//
+// Created by pyq on 10/19/26.
+//
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <strings.h>
+#include "multipart_reader.h"
+
+MultipartReader::MultipartReader(const std::string& boundary, const std::string& tempDir) :
+        delimiter_("\r\n--" + boundary), tempDir_(tempDir), state_(PREAMBLE), code_(0),
+        headerBytes_(0), fieldBytes_(0), fd_(-1), offset_(0) {
+    // the first boundary starts the body without a CRLF before it, a CRLF left over makes it a delimiter
+    carry_ = "\r\n";
+}
+
+MultipartReader::~MultipartReader() {
+    ClosePart_();
+    for (const Part& part : parts_) {
+        if (!part.path.empty()) {
+            unlink(part.path.c_str());
+        }
+    }
+}
+
+bool MultipartReader::Write(const char* data, size_t len) {
+    // the bytes left over from the previous slices are parsed together with the start of this slice,
+    // a slice without a leftover before it is parsed in place
+    size_t pos = 0;
+    while (!carry_.empty() && pos < len && state_ != FAILED) {
+        size_t carried = carry_.size();
+        size_t take = std::min(len - pos, MAX_HEADER);
+        carry_.append(data + pos, take);
+        size_t used = Parse_(carry_.data(), carry_.size());
+        if (used >= carried) {
+            pos += used - carried;
+            carry_.clear();
+        } else {
+            carry_.erase(0, used);
+            pos += take;
+        }
+    }
+    if (carry_.empty() && pos < len && state_ != FAILED) {
+        size_t used = Parse_(data + pos, len - pos);
+        carry_.assign(data + pos + used, len - pos - used);
+    }
+    return state_ != FAILED;
+}
+
+bool MultipartReader::IsComplete() const {
+    return state_ == EPILOGUE;
+}
+
+int MultipartReader::Code() const {
+    return code_;
+}
+
+const std::vector<MultipartReader::Part>& MultipartReader::Parts() const {
+    return parts_;
+}
+
+std::string MultipartReader::GetField(const std::string& name) const {
+    for (const Part& part : parts_) {
+        if (part.filename.empty() && part.name == name) {
+            return part.value;
+        }
+    }
+    return "";
+}
+
+bool MultipartReader::Keep(size_t index, const std::string& path) {
+    if (!IsComplete() || index >= parts_.size() || parts_[index].path.empty()) {
+        errno = EINVAL;
+        return false;
+    }
+    // link does not replace an existing file, unlike rename
+    Part& part = parts_[index];
+    if (link(part.path.c_str(), path.c_str()) < 0) {
+        return false;
+    }
+    unlink(part.path.c_str());
+    part.path.clear();
+    return true;
+}
+
+bool MultipartReader::ParseBoundary(const std::string& contentType, std::string* boundary) {
+    // multipart/form-data; boundary=----WebKitFormBoundary7MA4YWxkTrZu0gW eg.
+    const char TYPE[] = "multipart/form-data";
+    if (strncasecmp(contentType.c_str(), TYPE, sizeof(TYPE) - 1) != 0) {
+        return false;
+    }
+    *boundary = GetParam_(contentType, "boundary");
+    return !boundary->empty() && boundary->size() <= 70;
+}
+
+size_t MultipartReader::Parse_(const char* data, size_t len) {
+    const char CRLF[] = "\r\n";
+    const char* pos = data;
+    const char* end = data + len;
+    while (pos < end && state_ != FAILED) {
+        switch (state_) {
+            case PREAMBLE:
+            case DATA: {
+                // everything before the delimiter is data, the bytes that may start it wait for the next slice
+                bool isFull = false;
+                const char* hit = FindDelimiter_(pos, end, &isFull);
+                if (state_ == DATA && hit > pos && !AppendPart_(pos, hit - pos)) {
+                    break;
+                }
+                pos = hit;
+                if (!isFull) {
+                    return pos - data;
+                }
+                pos += delimiter_.size();
+                ClosePart_();
+                state_ = BOUNDARY;
+                break;
+            }
+            case BOUNDARY:
+                // "--" closes the body, CRLF starts the next part, blanks may come before either
+                if (*pos == ' ' || *pos == '\t') {
+                    ++pos;
+                    break;
+                }
+                if (end - pos < 2) {
+                    return pos - data;
+                }
+                if (pos[0] == '-' && pos[1] == '-') {
+                    state_ = EPILOGUE;
+                } else if (pos[0] == '\r' && pos[1] == '\n') {
+                    if (parts_.size() >= MAX_PARTS) {
+                        Fail_(413);
+                        break;
+                    }
+                    parts_.push_back(Part());
+                    parts_.back().size = 0;
+                    headerBytes_ = 0;
+                    state_ = HEADER;
+                } else {
+                    Fail_(400);
+                    break;
+                }
+                pos += 2;
+                break;
+            case HEADER: {
+                const char* lineEnd = std::search(pos, end, CRLF, CRLF + 2);
+                if (lineEnd == end) {
+                    if (headerBytes_ + (end - pos) > MAX_HEADER) {
+                        Fail_(400);
+                    }
+                    return pos - data;
+                }
+                headerBytes_ += lineEnd - pos + 2;
+                if (headerBytes_ > MAX_HEADER || (lineEnd > pos && !ParseHeader_(pos, lineEnd - pos))) {
+                    Fail_(400);
+                    break;
+                }
+                if (lineEnd == pos && OpenPart_()) {
+                    // the headers end at an empty line
+                    state_ = DATA;
+                }
+                pos = lineEnd + 2;
+                break;
+            }
+            case EPILOGUE:
+                pos = end;
+                break;
+            default:
+                break;
+        }
+    }
+    return pos - data;
+}
+
+const char* MultipartReader::FindDelimiter_(const char* begin, const char* end, bool* isFull) const {
+    // memchr is vectorized in glibc, so the data is skipped many bytes at a time up to the next CR,
+    // a CR that does not start the delimiter costs one short compare
+    const char* delimiter = delimiter_.data();
+    size_t len = delimiter_.size();
+    const char* p = begin;
+    *isFull = false;
+    while (p < end && (p = static_cast<const char*>(memchr(p, '\r', end - p))) != nullptr) {
+        size_t avail = end - p;
+        if (avail >= len) {
+            if (memcmp(p, delimiter, len) == 0) {
+                *isFull = true;
+                return p;
+            }
+        } else if (memcmp(p, delimiter, avail) == 0) {
+            return p;
+        }
+        ++p;
+    }
+    return end;
+}
+
+bool MultipartReader::ParseHeader_(const char* line, size_t len) {
+    // Content-Disposition: form-data; name="file"; filename="a.txt" eg.
+    const char* colon = static_cast<const char*>(memchr(line, ':', len));
+    if (!colon) {
+        return false;
+    }
+    std::string key(line, colon);
+    std::string value(colon + 1, line + len);
+    value.erase(0, value.find_first_not_of(" \t"));
+    Part& part = parts_.back();
+    if (strcasecmp(key.c_str(), "Content-Disposition") == 0) {
+        if (strncasecmp(value.c_str(), "form-data", 9) != 0) {
+            return false;
+        }
+        part.name = GetParam_(value, "name");
+        part.filename = GetParam_(value, "filename");
+    } else if (strcasecmp(key.c_str(), "Content-Type") == 0) {
+        part.type = value;
+    }
+    return true;
+}
+
+bool MultipartReader::OpenPart_() {
+    Part& part = parts_.back();
+    if (part.name.empty()) {
+        // every part of a form names its field
+        Fail_(400);
+        return false;
+    }
+    if (part.filename.empty()) {
+        return true;
+    }
+    std::string path = tempDir_ + "/.upload-XXXXXX";
+    fd_ = mkstemp(&path[0]);
+    if (fd_ < 0) {
+        LOG_ERROR("Create Upload File in %s Error: %s", tempDir_.c_str(), strerror(errno));
+        Fail_(500);
+        return false;
+    }
+    part.path = path;
+    offset_ = 0;
+    return true;
+}
+
+bool MultipartReader::AppendPart_(const char* data, size_t len) {
+    Part& part = parts_.back();
+    part.size += len;
+    if (fd_ < 0) {
+        fieldBytes_ += len;
+        if (fieldBytes_ > MAX_FIELDS) {
+            Fail_(413);
+            return false;
+        }
+        part.value.append(data, len);
+        return true;
+    }
+    // the slice goes from the read buffer to the file without another copy
+    while (len > 0) {
+        ssize_t written = pwrite(fd_, data, len, offset_);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("Write Upload File %s Error: %s", part.path.c_str(), strerror(errno));
+            Fail_(500);
+            return false;
+        }
+        data += written;
+        len -= written;
+        offset_ += written;
+    }
+    return true;
+}
+
+void MultipartReader::ClosePart_() {
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+}
+
+void MultipartReader::Fail_(int code) {
+    ClosePart_();
+    state_ = FAILED;
+    code_ = code;
+}
+
+std::string MultipartReader::GetParam_(const std::string& value, const std::string& key) {
+    // the parameters follow the first ';', a quoted value may contain ';'
+    size_t pos = value.find(';');
+    while (pos != std::string::npos) {
+        pos = value.find_first_not_of(" \t", pos + 1);
+        if (pos == std::string::npos) {
+            break;
+        }
+        size_t eq = value.find('=', pos);
+        if (eq == std::string::npos) {
+            break;
+        }
+        std::string name = value.substr(pos, eq - pos);
+        name.erase(name.find_last_not_of(" \t") + 1);
+        std::string param;
+        size_t next;
+        if (eq + 1 < value.size() && value[eq + 1] == '"') {
+            size_t close = value.find('"', eq + 2);
+            if (close == std::string::npos) {
+                break;
+            }
+            param = value.substr(eq + 2, close - eq - 2);
+            next = value.find(';', close);
+        } else {
+            next = value.find(';', eq);
+            param = value.substr(eq + 1, next == std::string::npos ? std::string::npos : next - eq - 1);
+            param.erase(param.find_last_not_of(" \t") + 1);
+        }
+        if (strcasecmp(name.c_str(), key.c_str()) == 0) {
+            return param;
+        }
+        pos = next;
+    }
+    return "";
+}
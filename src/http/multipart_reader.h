@@ -0,0 +1,110 @@
+//
+// Created by pyq on 10/19/26.
+//
+#pragma once
+#ifndef SLIM_WEB_SERVER_MULTIPART_READER_H
+#define SLIM_WEB_SERVER_MULTIPART_READER_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <sys/types.h>
+#include "http_request.h"
+
+// Parses a multipart/form-data body as it arrives. Fields are kept in memory, the data of a file part is
+// written to a temporary file under tempDir straight from the slices of the read buffer, so the memory of
+// an upload does not depend on its size. The parser keeps at most a part header or the bytes that may
+// start a boundary between two slices.
+class MultipartReader : public HttpRequest::BodyReader {
+public:
+    // A part of the body.
+    struct Part {
+        std::string name;       // Name of the form field.
+        std::string filename;   // File name sent by the client, empty for a field.
+        std::string type;       // Content-Type of the part, empty if not sent.
+        std::string value;      // Value of a field.
+        std::string path;       // Temporary file holding the data of a file part, empty once kept.
+        size_t size;            // Bytes of the data.
+    };
+
+    // boundary is the boundary parameter of the Content-Type, temporary files are created under tempDir.
+    MultipartReader(const std::string& boundary, const std::string& tempDir);
+
+    // Removes the temporary files that were not kept.
+    ~MultipartReader() override;
+
+    bool Write(const char* data, size_t len) override;
+
+    // Returns true once the closing boundary was parsed.
+    bool IsComplete() const;
+
+    // Returns the status code of the error that stopped the parser, 0 if none.
+    int Code() const;
+
+    // Returns the parts parsed so far, the last one may be incomplete.
+    const std::vector<Part>& Parts() const;
+
+    // Returns the value of a field, empty if the body has no field of that name.
+    std::string GetField(const std::string& name) const;
+
+    // Moves the file of a complete file part to path, which must not exist and must be on the file system
+    // of tempDir. Returns false on an error, e.g. errno EEXIST.
+    bool Keep(size_t index, const std::string& path);
+
+    // Extracts the boundary from a multipart/form-data Content-Type, returns false if there is none.
+    static bool ParseBoundary(const std::string& contentType, std::string* boundary);
+
+    static const size_t MAX_FIELDS = 65536;     // Bytes of all field values together.
+    static const size_t MAX_PARTS = 64;         // Parts of a body.
+
+private:
+    // Enumerates the states of the parser.
+    enum STATE {
+        PREAMBLE,       // Before the first boundary, skipped.
+        BOUNDARY,       // After a delimiter, "--" ends the body and CRLF starts a part.
+        HEADER,         // Header lines of a part, up to an empty line.
+        DATA,           // Data of a part, up to the next delimiter.
+        EPILOGUE,       // After the closing boundary, skipped.
+        FAILED,         // Malformed body or an error, code_ tells why.
+    };
+
+    static const size_t MAX_HEADER = 8192;      // Bytes of the header lines of a part.
+
+    std::string delimiter_;     // CRLF "--" boundary, which ends the data of a part.
+    std::string tempDir_;       // Directory of the temporary files.
+    STATE state_;               // State of the parser.
+    int code_;                  // Status code of the error, 0 if none.
+    std::string carry_;         // Bytes of the previous slices not parsed yet.
+    size_t headerBytes_;        // Bytes of the header lines of the current part.
+    size_t fieldBytes_;         // Bytes of all field values.
+    std::vector<Part> parts_;   // Parts parsed so far.
+    int fd_;                    // Temporary file of the current file part, -1 if none.
+    off_t offset_;              // Bytes written to fd_.
+
+    // Runs the parser over data, returns the bytes consumed; the rest waits for more data.
+    size_t Parse_(const char* data, size_t len);
+
+    // Returns the first delimiter in [begin, end), or the first position at which only a part of it fits
+    // before end; end if neither. *isFull tells whether a whole delimiter was found.
+    const char* FindDelimiter_(const char* begin, const char* end, bool* isFull) const;
+
+    // Parses a header line of the current part, returns false if malformed.
+    bool ParseHeader_(const char* line, size_t len);
+
+    // Starts the data of the current part, opening a temporary file for a file part.
+    bool OpenPart_();
+
+    // Appends data to the current part.
+    bool AppendPart_(const char* data, size_t len);
+
+    // Ends the data of the current part.
+    void ClosePart_();
+
+    // Stops the parser with the status code of an error.
+    void Fail_(int code);
+
+    // Returns the value of a parameter of a header value, e.g. name in form-data; name="a".
+    static std::string GetParam_(const std::string& value, const std::string& key);
+};
+
+#endif //SLIM_WEB_SERVER_MULTIPART_READER_H
@@ -0,0 +1,37 @@
+//
+// Created by pyq on 10/19/26.
+//
+#include "request_trace.h"
+
+RequestTrace::RequestTrace() {
+    Reset();
+}
+
+void RequestTrace::Mark(PHASE phase) {
+    if (at_[phase] == 0) {
+        at_[phase] = NowNs();
+    }
+}
+
+uint64_t RequestTrace::At(PHASE phase) const {
+    return at_[phase];
+}
+
+uint64_t RequestTrace::Between(PHASE from, PHASE to) const {
+    if (at_[from] == 0 || at_[to] < at_[from]) {
+        return 0;
+    }
+    return at_[to] - at_[from];
+}
+
+void RequestTrace::Reset(PHASE from) {
+    for (int i = from; i < PHASE_NUM; ++i) {
+        at_[i] = 0;
+    }
+}
+
+uint64_t RequestTrace::NowNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
@@ -0,0 +1,48 @@
+//
+// Created by pyq on 10/19/26.
+//
+#pragma once
+#ifndef SLIM_WEB_SERVER_REQUEST_TRACE_H
+#define SLIM_WEB_SERVER_REQUEST_TRACE_H
+
+#include <cstdint>
+#include <time.h>
+
+// Monotonic timestamps of the phases a request goes through, from accept to its last byte written.
+// A phase keeps its first timestamp until Reset, so repeated events (e.g. several EPOLLOUT) do not move it.
+class RequestTrace {
+public:
+    // Enumerates the phases in the order they happen.
+    enum PHASE {
+        ACCEPT = 0,     // Connection accepted, only set for the first request of a connection.
+        READABLE,       // Read readiness dispatched by the epoll loop.
+        DEQUEUE,        // Read task taken by a worker thread.
+        PARSED,         // Request read and parsed.
+        HANDLED,        // Handler done and response built.
+        FIRST_BYTE,     // First byte of the response written.
+        LAST_BYTE,      // Last byte of the response written.
+        PHASE_NUM,
+    };
+
+    RequestTrace();
+
+    // Records the current time for phase unless it is already recorded.
+    void Mark(PHASE phase);
+
+    // Returns the timestamp of a phase in nanoseconds, 0 if not recorded.
+    uint64_t At(PHASE phase) const;
+
+    // Returns the nanoseconds from one phase to another, 0 if either is not recorded.
+    uint64_t Between(PHASE from, PHASE to) const;
+
+    // Clears the phase from and every later phase.
+    void Reset(PHASE from = ACCEPT);
+
+    // Returns the monotonic clock in nanoseconds, read through the vDSO without a system call.
+    static uint64_t NowNs();
+
+private:
+    uint64_t at_[PHASE_NUM];    // Timestamp of each phase, 0 if not recorded.
+};
+
+#endif //SLIM_WEB_SERVER_REQUEST_TRACE_H
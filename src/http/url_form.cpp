@@ -0,0 +1,160 @@
+//
+// Created by pyq on 10/19/26.
+//
+#include <cstring>
+#include "url_form.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+size_t UrlForm::Parse(char* data, size_t len) {
+    // username=john+doe&password=12345%21 eg. becomes the fields username: "john doe" and password: "12345!"
+    // r reads the raw bytes, w writes the decoded ones behind it, a raw '&' or the first raw '=' of a
+    // field separates, an escaped one is data
+    fields_.clear();
+    size_t r = 0, w = 0;
+    Field field = {data, 0, nullptr, 0};
+    while (r <= len) {
+        size_t run = SkipPlain_(data + r, len - r);
+        if (w != r) {
+            memmove(data + w, data + r, run);
+        }
+        r += run;
+        w += run;
+        char ch = r < len ? data[r] : '&';
+        if (ch == '&') {
+            // end of the field, empty ones (a=1&&b=2) are skipped
+            if (field.value) {
+                field.valueLen = data + w - field.value;
+            } else {
+                field.keyLen = data + w - field.key;
+                field.value = data + w;
+            }
+            if (field.keyLen > 0 || field.valueLen > 0) {
+                fields_.push_back(field);
+            }
+            field = {data + w, 0, nullptr, 0};
+        } else if (ch == '=' && !field.value) {
+            field.keyLen = data + w - field.key;
+            field.value = data + w;
+        } else if (ch == '%' && DecodeHex_(data + r, len - r, data + w)) {
+            r += 2;
+            ++w;
+        } else {
+            // '+' is a space, a '=' in a value and a '%' without two hex digits stay as they are
+            data[w++] = ch == '+' ? ' ' : ch;
+        }
+        ++r;
+    }
+    return w;
+}
+
+void UrlForm::Clear() {
+    fields_.clear();
+}
+
+bool UrlForm::Get(const char* key, size_t keyLen, const char** value, size_t* valueLen) const {
+    for (const Field& field : fields_) {
+        if (field.keyLen == keyLen && memcmp(field.key, key, keyLen) == 0) {
+            *value = field.value;
+            *valueLen = field.valueLen;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string UrlForm::Get(const std::string& key) const {
+    const char* value;
+    size_t valueLen;
+    if (Get(key.data(), key.size(), &value, &valueLen)) {
+        return std::string(value, valueLen);
+    }
+    return "";
+}
+
+size_t UrlForm::Size() const {
+    return fields_.size();
+}
+
+const UrlForm::Field& UrlForm::At(size_t index) const {
+    return fields_[index];
+}
+
+size_t UrlForm::DecodePath(char* data, size_t len) {
+    // most paths have no escape, memchr finds that out without touching the bytes one by one
+    char* escape = static_cast<char*>(memchr(data, '%', len));
+    if (!escape) {
+        return len;
+    }
+    size_t r = escape - data, w = r;
+    while (r < len) {
+        if (data[r] == '%' && DecodeHex_(data + r, len - r, data + w)) {
+            r += 3;
+        } else {
+            data[w] = data[r];
+            ++r;
+        }
+        ++w;
+    }
+    return w;
+}
+
+size_t UrlForm::SkipPlain_(const char* data, size_t len) {
+    size_t i = 0;
+#ifdef __SSE2__
+    // compare 16 bytes against each special byte at once, the first set bit of the mask is the first hit
+    const __m128i percent = _mm_set1_epi8('%');
+    const __m128i plus = _mm_set1_epi8('+');
+    const __m128i amp = _mm_set1_epi8('&');
+    const __m128i equal = _mm_set1_epi8('=');
+    for (; i + 16 <= len; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, percent), _mm_cmpeq_epi8(chunk, plus)),
+                                   _mm_or_si128(_mm_cmpeq_epi8(chunk, amp), _mm_cmpeq_epi8(chunk, equal)));
+        int mask = _mm_movemask_epi8(hit);
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+#endif
+    for (; i < len; ++i) {
+        char ch = data[i];
+        if (ch == '%' || ch == '+' || ch == '&' || ch == '=') {
+            break;
+        }
+    }
+    return i;
+}
+
+bool UrlForm::DecodeHex_(const char* data, size_t len, char* out) {
+    // %23 -> '#' eg.
+    static const signed char HEX[256] = {
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+         0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
+        -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    };
+    if (len < 3) {
+        return false;
+    }
+    int high = HEX[static_cast<unsigned char>(data[1])];
+    int low = HEX[static_cast<unsigned char>(data[2])];
+    if (high < 0 || low < 0) {
+        return false;
+    }
+    *out = static_cast<char>(high * 16 + low);
+    return true;
+}
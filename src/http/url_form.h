@@ -0,0 +1,58 @@
+//
+// Created by pyq on 10/19/26.
+//
+#pragma once
+#ifndef SLIM_WEB_SERVER_URL_FORM_H
+#define SLIM_WEB_SERVER_URL_FORM_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// Decodes application/x-www-form-urlencoded data, a POST body or a query string, in place: "+" becomes a
+// space and "%xx" its byte, the data only shrinks. The fields are views into the decoded data kept in a
+// flat array that is reused by the next Parse, so a request on a warm connection allocates nothing.
+// Runs of bytes that need no work are skipped 16 at a time with SSE2.
+class UrlForm {
+public:
+    // A field of the form, key and value point into the decoded data.
+    struct Field {
+        const char* key;        // Decoded key.
+        size_t keyLen;          // Length of the key.
+        const char* value;      // Decoded value, empty if the field has no '='.
+        size_t valueLen;        // Length of the value.
+    };
+
+    // Decodes len bytes of data in place and splits them at '&' and '=' into fields, replacing the fields
+    // of the previous call. data must outlive the fields. Returns the decoded length.
+    size_t Parse(char* data, size_t len);
+
+    // Drops the fields, keeping the array for the next Parse.
+    void Clear();
+
+    // Finds the first field named key and points value at its value, returns false if there is none.
+    bool Get(const char* key, size_t keyLen, const char** value, size_t* valueLen) const;
+
+    // Returns a copy of the value of the first field named key, empty if there is none.
+    std::string Get(const std::string& key) const;
+
+    // Returns the number of fields.
+    size_t Size() const;
+
+    // Returns the field at index, in the order of the data.
+    const Field& At(size_t index) const;
+
+    // Decodes the "%xx" escapes of a path in place, "+" is kept. Returns the decoded length.
+    static size_t DecodePath(char* data, size_t len);
+
+private:
+    std::vector<Field> fields_;     // Fields of the last Parse.
+
+    // Returns the length of the prefix of data without '%', '+', '&' or '='.
+    static size_t SkipPlain_(const char* data, size_t len);
+
+    // Decodes the escape "%xx" at data if both digits are hex into *out, returns false otherwise.
+    static bool DecodeHex_(const char* data, size_t len, char* out);
+};
+
+#endif //SLIM_WEB_SERVER_URL_FORM_H
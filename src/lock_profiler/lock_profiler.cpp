@@ -0,0 +1,184 @@
+//
+// Created by pyq on 10/19/26.
+//
+#include "lock_profiler.h"
+#include <time.h>
+#include <algorithm>
+#include "../log/log.h"
+#include "../metrics/metrics.h"
+
+LockProfiler* LockProfiler::Instance() {
+    static LockProfiler profiler;
+    return &profiler;
+}
+
+LockProfiler::LockProfiler() : isRunning_(false) {}
+
+LockProfiler::~LockProfiler() {
+    Stop();
+}
+
+LockStats* LockProfiler::Get(const char* name) {
+    std::lock_guard<std::mutex> locker(mutex_);
+    auto it = index_.find(name);
+    if (it != index_.end()) {
+        return it->second;
+    }
+    std::unique_ptr<LockStats> stats(new LockStats());
+    stats->name = name;
+    stats->acquireCount = 0;
+    stats->contendCount = 0;
+    stats->waitNs = 0;
+    stats->holdNs = 0;
+    stats->maxWaitNs = 0;
+    stats->maxHoldNs = 0;
+    LockStats* ret = stats.get();
+    index_[name] = ret;
+    stats_.push_back(std::move(stats));
+    return ret;
+}
+
+void LockProfiler::Start(int intervalMs) {
+    std::lock_guard<std::mutex> locker(mutex_);
+    if (isRunning_ || intervalMs <= 0) {
+        return;
+    }
+    isRunning_ = true;
+    dumpThread_ = std::thread([this, intervalMs] {
+        std::unique_lock<std::mutex> locker(mutex_);
+        while (isRunning_) {
+            cond_.wait_for(locker, std::chrono::milliseconds(intervalMs));
+            if (!isRunning_) {
+                break;
+            }
+            locker.unlock();
+            std::string dump = Dump();
+            LOG_INFO("Lock Profile:\n%s", dump.c_str());
+            locker.lock();
+        }
+    });
+}
+
+void LockProfiler::Stop() {
+    {
+        std::lock_guard<std::mutex> locker(mutex_);
+        isRunning_ = false;
+    }
+    cond_.notify_all();
+    if (dumpThread_.joinable()) {
+        dumpThread_.join();
+    }
+}
+
+std::string LockProfiler::Dump() {
+    std::vector<LockStats*> stats;
+    {
+        std::lock_guard<std::mutex> locker(mutex_);
+        for (auto& item : stats_) {
+            if (item->acquireCount.load(std::memory_order_relaxed) > 0) {
+                stats.push_back(item.get());
+            }
+        }
+    }
+    std::sort(stats.begin(), stats.end(), [](LockStats* a, LockStats* b) {
+        return a->waitNs.load(std::memory_order_relaxed) > b->waitNs.load(std::memory_order_relaxed);
+    });
+    std::string out;
+    char line[256];
+    for (LockStats* item : stats) {
+        uint64_t acquire = item->acquireCount.load(std::memory_order_relaxed);
+        uint64_t contend = item->contendCount.load(std::memory_order_relaxed);
+        snprintf(line, sizeof(line),
+                "%-16s acquire=%lu contended=%lu (%.2f%%) wait=%.3fms max_wait=%.3fms hold=%.3fms max_hold=%.3fms\n",
+                item->name.c_str(), (unsigned long)acquire, (unsigned long)contend,
+                acquire ? contend * 100.0 / acquire : 0.0,
+                item->waitNs.load(std::memory_order_relaxed) / 1e6, item->maxWaitNs.load(std::memory_order_relaxed) / 1e6,
+                item->holdNs.load(std::memory_order_relaxed) / 1e6, item->maxHoldNs.load(std::memory_order_relaxed) / 1e6);
+        out += line;
+    }
+    return out;
+}
+
+void LockProfiler::Collect(std::string& out) {
+    std::vector<LockStats*> stats;
+    {
+        LockProfiler* profiler = Instance();
+        std::lock_guard<std::mutex> locker(profiler->mutex_);
+        for (auto& item : profiler->stats_) {
+            // mutexes register as "unnamed" until SetName, skip the names never locked
+            if (item->acquireCount.load(std::memory_order_relaxed) > 0) {
+                stats.push_back(item.get());
+            }
+        }
+    }
+    struct Field {
+        const char* name;
+        const char* type;
+        const char* help;
+        std::atomic<uint64_t> LockStats::* member;
+        double scale;
+    };
+    const Field fields[] = {
+        {"slim_lock_acquire_total", "counter", "Acquisitions of a named lock.", &LockStats::acquireCount, 1},
+        {"slim_lock_contended_total", "counter", "Acquisitions that had to wait for another owner.", &LockStats::contendCount, 1},
+        {"slim_lock_wait_seconds_total", "counter", "Time spent waiting to acquire a lock.", &LockStats::waitNs, 1e9},
+        {"slim_lock_hold_seconds_total", "counter", "Time a lock was held.", &LockStats::holdNs, 1e9},
+        {"slim_lock_max_wait_seconds", "gauge", "Longest single wait for a lock.", &LockStats::maxWaitNs, 1e9},
+        {"slim_lock_max_hold_seconds", "gauge", "Longest single hold of a lock.", &LockStats::maxHoldNs, 1e9},
+    };
+    for (const Field& field : fields) {
+        Metrics::AppendHeader(out, field.name, field.type, field.help);
+        for (LockStats* item : stats) {
+            Metrics::AppendSample(out, field.name, "{lock=\"" + item->name + "\"}",
+                    (item->*field.member).load(std::memory_order_relaxed) / field.scale);
+        }
+    }
+}
+
+uint64_t LockProfiler::NowNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+ProfiledMutex::ProfiledMutex() : stats_(LockProfiler::Instance()->Get("unnamed")), lockedAt_(0) {}
+
+void ProfiledMutex::SetName(const char* name) {
+    stats_ = LockProfiler::Instance()->Get(name);
+}
+
+void ProfiledMutex::lock() {
+    if (mutex_.try_lock()) {
+        lockedAt_ = LockProfiler::NowNs();
+    } else {
+        uint64_t start = LockProfiler::NowNs();
+        mutex_.lock();
+        lockedAt_ = LockProfiler::NowNs();
+        uint64_t wait = lockedAt_ - start;
+        stats_->contendCount.fetch_add(1, std::memory_order_relaxed);
+        stats_->waitNs.fetch_add(wait, std::memory_order_relaxed);
+        UpdateMax_(stats_->maxWaitNs, wait);
+    }
+    stats_->acquireCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool ProfiledMutex::try_lock() {
+    if (!mutex_.try_lock()) {
+        return false;
+    }
+    lockedAt_ = LockProfiler::NowNs();
+    stats_->acquireCount.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void ProfiledMutex::unlock() {
+    uint64_t hold = LockProfiler::NowNs() - lockedAt_;
+    stats_->holdNs.fetch_add(hold, std::memory_order_relaxed);
+    UpdateMax_(stats_->maxHoldNs, hold);
+    mutex_.unlock();
+}
+
+void ProfiledMutex::UpdateMax_(std::atomic<uint64_t>& max, uint64_t value) {
+    uint64_t current = max.load(std::memory_order_relaxed);
+    while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
@@ -0,0 +1,109 @@
+//
+// Created by pyq on 10/19/26.
+//
+#pragma once
+#ifndef SLIM_WEB_SERVER_LOCK_PROFILER_H
+#define SLIM_WEB_SERVER_LOCK_PROFILER_H
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <unordered_map>
+#include <condition_variable>
+
+// Contention counters shared by every mutex with the same name.
+struct LockStats {
+    std::string name;                       // Name of the lock.
+    std::atomic<uint64_t> acquireCount;     // Successful lock calls.
+    std::atomic<uint64_t> contendCount;     // Lock calls that found the mutex held and had to wait.
+    std::atomic<uint64_t> waitNs;           // Total time spent waiting to acquire.
+    std::atomic<uint64_t> holdNs;           // Total time the mutex was held.
+    std::atomic<uint64_t> maxWaitNs;        // Longest single wait.
+    std::atomic<uint64_t> maxHoldNs;        // Longest single hold.
+};
+
+// Registry of the named lock statistics, exposed through the metrics endpoint and a periodic log dump.
+class LockProfiler {
+public:
+    // Singleton access method.
+    static LockProfiler* Instance();
+
+    // Returns the statistics of a lock name, creating them on first use.
+    LockStats* Get(const char* name);
+
+    // Starts a thread writing a summary to the log every intervalMs.
+    void Start(int intervalMs = 10000);
+
+    // Stops the dump thread.
+    void Stop();
+
+    // Returns a summary line per lock, sorted by total wait time.
+    std::string Dump();
+
+    // Appends the statistics of every lock to a metrics scrape.
+    static void Collect(std::string& out);
+
+    // Returns the monotonic clock in nanoseconds.
+    static uint64_t NowNs();
+
+private:
+    std::vector<std::unique_ptr<LockStats>> stats_;         // Statistics of every lock name, never freed.
+    std::unordered_map<std::string, LockStats*> index_;     // Name to statistics.
+    std::mutex mutex_;                                      // Mutex protecting the registry, never profiled.
+    bool isRunning_;                                        // Flag keeping the dump thread running.
+    std::condition_variable cond_;                          // Wakes up the dump thread when stopping.
+    std::thread dumpThread_;                                // Thread writing the periodic summary.
+
+    LockProfiler();
+
+    ~LockProfiler();
+
+    LockProfiler(const LockProfiler& other) = delete;
+    LockProfiler& operator=(const LockProfiler& other) = delete;
+};
+
+// Drop-in replacement of std::mutex recording acquire wait, hold time and contention.
+// An uncontended lock costs a try_lock and one clock read more than std::mutex.
+class ProfiledMutex {
+public:
+    ProfiledMutex();
+
+    // Sets the name the statistics are reported under.
+    void SetName(const char* name);
+
+    void lock();
+
+    bool try_lock();
+
+    void unlock();
+
+private:
+    std::mutex mutex_;          // Underlying mutex.
+    LockStats* stats_;          // Statistics of this lock name.
+    uint64_t lockedAt_;         // Time the current owner acquired the mutex.
+
+    ProfiledMutex(const ProfiledMutex& other) = delete;
+    ProfiledMutex& operator=(const ProfiledMutex& other) = delete;
+
+    // Raises max to value if value is larger.
+    static void UpdateMax_(std::atomic<uint64_t>& max, uint64_t value);
+};
+
+// The hot locks of the server are declared as SlimMutex and waited on with SlimCondition.
+// Built with SLIM_LOCK_PROFILE ("make LOCK_PROFILE=1") they are profiled,
+// otherwise they are exactly std::mutex and std::condition_variable and SLIM_LOCK_NAME does nothing.
+#ifdef SLIM_LOCK_PROFILE
+using SlimMutex = ProfiledMutex;
+using SlimCondition = std::condition_variable_any;
+#define SLIM_LOCK_NAME(mutex, name) (mutex).SetName(name)
+#else
+using SlimMutex = std::mutex;
+using SlimCondition = std::condition_variable;
+#define SLIM_LOCK_NAME(mutex, name) do {} while (0)
+#endif
+
+#endif //SLIM_WEB_SERVER_LOCK_PROFILER_H
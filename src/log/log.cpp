@@ -5,7 +5,9 @@
 #include "log.h"
 
 // Constructor: Initializes the log system defaults.
-Log::Log() : lineCount_(0), day_(0), isAsync_(false), fp_(nullptr),  blockDeque_(nullptr), writeThread_(nullptr) {}
+Log::Log() : lineCount_(0), day_(0), isAsync_(false), fp_(nullptr),  blockDeque_(nullptr), writeThread_(nullptr) {
+    SLIM_LOCK_NAME(mutex_, "log");
+}
 
 // Destructor: Ensures all resources are properly released and threads joined.
 Log::~Log() {
@@ -17,7 +19,7 @@ Log::~Log() {
         writeThread_->join();
     }
     if (fp_) {
-        std::lock_guard<std::mutex> locker(mutex_);
+        std::lock_guard<SlimMutex> locker(mutex_);
         Flush();
         fclose(fp_);
     }
@@ -53,7 +55,7 @@ void Log::Write(int level, const char* format, ...) {
 
     // One log file per day, and the maximum number of lines in a single log file is guaranteed to be MAX_LINES
     if (day_ != t.tm_mday || (lineCount_ && (lineCount_ % MAX_LINES == 0))) {
-        std::unique_lock<std::mutex> locker(mutex_);
+        std::unique_lock<SlimMutex> locker(mutex_);
         locker.unlock();
         char newFile[LOG_NAME_LEN];
         char tail[36] = {0};
@@ -72,7 +74,7 @@ void Log::Write(int level, const char* format, ...) {
         assert(fp_ != nullptr);
     }
     {
-        std::unique_lock<std::mutex> locker(mutex_);
+        std::unique_lock<SlimMutex> locker(mutex_);
         int n = snprintf(buffer_.BeginWrite(), 128, "%d-%02d-%02d %02d:%02d:%02d.%06ld ", t.tm_year + 1900, t.tm_mon + 1, t.tm_mday, t.tm_hour, t.tm_min, t.tm_sec, now.tv_usec);
         buffer_.AdvanceWritePointer(n);
         AppendLogLevelTitle_(level);
@@ -87,6 +89,9 @@ void Log::Write(int level, const char* format, ...) {
         if (isAsync_ && blockDeque_ && !blockDeque_->full()) {
             blockDeque_->push_back(buffer_.RetrieveAllAsString());
         } else {
+            if (isAsync_) {
+                Metrics::Instance()->Add(Metrics::LOG_QUEUE_FULL);
+            }
             fputs(buffer_.BeginRead(), fp_);
         }
         buffer_.RetrieveAll();
@@ -120,7 +125,7 @@ void Log::Init(int level, const char* path, const char* suffix, int capacity) {
     day_ = t.tm_mday;
 
     {
-        std::lock_guard<std::mutex> locker(mutex_);
+        std::lock_guard<SlimMutex> locker(mutex_);
         buffer_.RetrieveAll();
         if (fp_) {
             Flush();
@@ -137,16 +142,32 @@ void Log::Init(int level, const char* path, const char* suffix, int capacity) {
 
 // Returns the current log level.
 int Log::GetLevel() {
-    std::lock_guard<std::mutex> locker(mutex_);
+    std::lock_guard<SlimMutex> locker(mutex_);
     return level_;
 }
 
 // Sets the current log level.
 void Log::SetLevel(int level) {
-    std::lock_guard<std::mutex> locker(mutex_);
+    std::lock_guard<SlimMutex> locker(mutex_);
     level_ = level;
 }
 
+// Switches between synchronous and asynchronous writes.
+void Log::SetAsync(bool async) {
+    std::lock_guard<SlimMutex> locker(mutex_);
+    if (async && !blockDeque_) {
+        blockDeque_.reset(new BlockDeque<std::string>(ASYNC_QUEUE_SIZE));
+        writeThread_.reset(new std::thread(AsyncFlushLog));
+    }
+    // lines already queued are still written by the write thread
+    isAsync_ = async;
+}
+
+// Returns true if log lines are written asynchronously.
+bool Log::IsAsync() {
+    return isAsync_;
+}
+
 // Checks if the log file is open.
 bool Log::IsOpen() {
     return isOpen_;
@@ -162,7 +183,7 @@ void Log::AppendLogLevelTitle_(int level) {
 void Log::AsyncWrite_() {
     std::string str;
     while (blockDeque_->pop_front(str)) {
-        std::lock_guard<std::mutex> locker(mutex_);
+        std::lock_guard<SlimMutex> locker(mutex_);
         fputs(str.c_str(), fp_);
     }
 }
@@ -6,6 +6,7 @@
 #define SLIM_WEB_SERVER_LOG_H
 
 #include <mutex>
+#include <atomic>
 #include <string>
 #include <thread>
 #include <sys/time.h>
@@ -16,6 +17,8 @@
 #include <ctime>
 #include "../buffer/buffer.h"
 #include "../block_deque/block_deque.h"
+#include "../metrics/metrics.h"
+#include "../lock_profiler/lock_profiler.h"
 
 // A thread-safe logging class that supports both synchronous and asynchronous logging.
 class Log {
@@ -41,6 +44,13 @@ public:
     // Sets the current log level.
     void SetLevel(int level);
 
+    // Switches between synchronous and asynchronous writes at runtime,
+    // the queue and its write thread are created on first use.
+    void SetAsync(bool async);
+
+    // Returns true if log lines are written by the async write thread.
+    bool IsAsync();
+
     // Checks if the log file is open.
     bool IsOpen();
 
@@ -48,6 +58,7 @@ private:
     static const int LOG_PATH_LEN = 256;  // Maximum length of the log path.
     static const int LOG_NAME_LEN = 256;  // Maximum length of the log file name.
     static const int MAX_LINES = 50000;   // Maximum number of lines per log file.
+    static const int ASYNC_QUEUE_SIZE = 1024;   // Queue capacity when SetAsync turns on asynchronous writes.
 
     const char* path_;           // Directory path for log files.
     const char* suffix_;         // Suffix for log files.
@@ -56,12 +67,12 @@ private:
     int day_;                    // Current day (used for file rotation).
     int level_;                  // Current log level.
     bool isOpen_;                // Flag indicating if the log system is initialized and open.
-    bool isAsync_;               // Flag indicating if logging should be asynchronous.
+    std::atomic<bool> isAsync_;  // Flag indicating if logging should be asynchronous.
     FILE* fp_;                   // File pointer for the log file.
     Buffer buffer_;              // Buffer for storing log messages before writing to the file.
     std::unique_ptr<BlockDeque<std::string>> blockDeque_; // Queue for asynchronous logging.
     std::unique_ptr<std::thread> writeThread_;           // Thread handling asynchronous log writes.
-    std::mutex mutex_;           // Mutex for synchronizing access to the log.
+    SlimMutex mutex_;            // Mutex for synchronizing access to the log.
 
     // Constructor.
     Log();
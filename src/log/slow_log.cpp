@@ -0,0 +1,68 @@
+//
+// Created by pyq on 10/19/26.
+//
+#include "slow_log.h"
+
+SlowLog* SlowLog::Instance() {
+    static SlowLog slowLog;
+    return &slowLog;
+}
+
+SlowLog::SlowLog() : thresholdNs_(0), fp_(nullptr) {}
+
+SlowLog::~SlowLog() {
+    Close();
+}
+
+bool SlowLog::Init(const char* dir, int thresholdMs) {
+    std::lock_guard<std::mutex> locker(mutex_);
+    if (fp_) {
+        fclose(fp_);
+        fp_ = nullptr;
+    }
+    thresholdNs_ = 0;
+    if (thresholdMs <= 0) {
+        return true;
+    }
+    std::string fileName = std::string(dir) + "/slow.log";
+    fp_ = fopen(fileName.c_str(), "a");
+    if (fp_ == nullptr) {
+        mkdir(dir, 0777);
+        fp_ = fopen(fileName.c_str(), "a");
+    }
+    if (fp_ == nullptr) {
+        return false;
+    }
+    thresholdNs_ = (uint64_t)thresholdMs * 1000000;
+    return true;
+}
+
+bool SlowLog::IsSlow(uint64_t totalNs) const {
+    return thresholdNs_ > 0 && totalNs >= thresholdNs_;
+}
+
+void SlowLog::Write(uint64_t totalNs, const std::string& detail) {
+    struct timeval now = {0, 0};
+    gettimeofday(&now, nullptr);
+    time_t tSec = now.tv_sec;
+    struct tm t;
+    localtime_r(&tSec, &t);
+
+    std::lock_guard<std::mutex> locker(mutex_);
+    if (!fp_) {
+        return;
+    }
+    fprintf(fp_, "%d-%02d-%02d %02d:%02d:%02d.%06ld total=%.3fms %s\n",
+            t.tm_year + 1900, t.tm_mon + 1, t.tm_mday, t.tm_hour, t.tm_min, t.tm_sec, now.tv_usec,
+            totalNs / 1e6, detail.c_str());
+    fflush(fp_);
+}
+
+void SlowLog::Close() {
+    std::lock_guard<std::mutex> locker(mutex_);
+    thresholdNs_ = 0;
+    if (fp_) {
+        fclose(fp_);
+        fp_ = nullptr;
+    }
+}
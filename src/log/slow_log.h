@@ -0,0 +1,48 @@
+//
+// Created by pyq on 10/19/26.
+//
+#pragma once
+#ifndef SLIM_WEB_SERVER_SLOW_LOG_H
+#define SLIM_WEB_SERVER_SLOW_LOG_H
+
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <sys/time.h>
+#include <sys/stat.h>
+
+// Dedicated log of the requests slower than a threshold, one line per request with its phase breakdown.
+// Slow requests are rare, so lines are written synchronously and flushed at once.
+class SlowLog {
+public:
+    // Retrieves the singleton instance.
+    static SlowLog* Instance();
+
+    // Opens dir/slow.log, requests taking thresholdMs or more are logged (0 disables the log).
+    bool Init(const char* dir = "./log", int thresholdMs = 500);
+
+    // Returns true if a request taking totalNs should be logged.
+    bool IsSlow(uint64_t totalNs) const;
+
+    // Writes a line, detail holds the request and its phase breakdown.
+    void Write(uint64_t totalNs, const std::string& detail);
+
+    // Closes the file.
+    void Close();
+
+private:
+    std::atomic<uint64_t> thresholdNs_;     // Threshold in nanoseconds, 0 if disabled.
+    FILE* fp_;                  // File of the slow log.
+    std::mutex mutex_;          // Mutex serializing the writers.
+
+    SlowLog();
+
+    ~SlowLog();
+
+    SlowLog(const SlowLog& other) = delete;
+    SlowLog& operator=(const SlowLog& other) = delete;
+};
+
+#endif //SLIM_WEB_SERVER_SLOW_LOG_H
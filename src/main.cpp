@@ -4,6 +4,17 @@
 /* listenPort, ET mode, timeoutMs for close connection, socket graceful exit (Linger) */
 /* Mysql configuration (port, user name, password, database name) */
 /* size of sql connection pools, size of thread pools, enable log, log level, log asynchronous queue capacity (0 means no async) */
+/* capacity of the auth cache in front of the database (0 means disabled), user store backend */
+/* Mysql topology (nullptr means a single localhost:port node), e.g. "127.0.0.1:3306,127.0.0.1:3307;127.0.0.1:3316" */
+/* shards are separated by ';', the first node of a shard is the primary and the others are read replicas */
+/* path of the Prometheus metrics endpoint (nullptr means disabled), slow request log threshold in ms (0 means disabled) */
+/* path of the admin unix socket (nullptr means disabled), e.g. echo stats | socat - UNIX-CONNECT:./slim-admin.sock */
+/* largest request body in bytes, larger ones are answered with 413 */
+/* directory of the files uploaded to POST /upload as multipart/form-data (nullptr means disabled) */
+
+/*User store backend*/
+/* 0: MySql user table*/
+/* 1: Embedded in-memory table with append-only log and snapshots in ./data (no MySql needed)*/
 
 /*ET mode*/
 /* 0: Both listening and connection events are LT*/
@@ -21,6 +32,7 @@ int main() {
     WebServer server (
         1316, 3, 60000, false,
         3306, "root", "12345678", "slimwebserver",
-        12, 6, true, 0, 1024);
+        12, 6, true, 0, 1024,
+        10000, 0, nullptr, "/metrics", 500, "./slim-admin.sock", 1 << 20, nullptr);
     server.Start();
 }
\ No newline at end of file
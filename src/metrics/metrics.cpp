@@ -0,0 +1,253 @@
+//
+// Created by pyq on 10/19/26.
+//
+#include "metrics.h"
+#include <cstring>
+
+namespace {
+
+// histograms sharing a name are one metric told apart by label, they must be adjacent
+struct HistogramInfo {
+    const char* name;
+    const char* label;
+    const char* help;
+};
+
+const HistogramInfo HISTOGRAM_INFO[Metrics::HISTOGRAM_NUM] = {
+    {"slim_http_phase_seconds", "phase=\"read\"", "Time spent in each phase of a request."},
+    {"slim_http_phase_seconds", "phase=\"queue\"", ""},
+    {"slim_http_phase_seconds", "phase=\"parse\"", ""},
+    {"slim_http_phase_seconds", "phase=\"handle\"", ""},
+    {"slim_http_phase_seconds", "phase=\"first_write\"", ""},
+    {"slim_http_phase_seconds", "phase=\"write\"", ""},
+    {"slim_http_request_seconds", "", "Time from accept or read readiness to the last byte of the response."},
+    {"slim_thread_pool_wait_seconds", "", "Time a task waited in the thread pool queue."},
+    {"slim_event_loop_seconds", "phase=\"wait\"", "Time the event loop spent in epoll_wait (blocking included) and dispatching its events."},
+    {"slim_event_loop_seconds", "phase=\"dispatch\"", ""},
+    {"slim_timer_tick_seconds", "", "Time spent expiring connection timers and computing the next timeout."},
+};
+
+}
+
+Metrics* Metrics::Instance() {
+    static Metrics metrics;
+    return &metrics;
+}
+
+Metrics::Metrics() : isOpen_(false), cacheTime_(1000) {
+    for (int i = 0; i < GAUGE_NUM; ++i) {
+        gauges_[i] = 0;
+    }
+}
+
+void Metrics::Init(const char* path, int cacheMs) {
+    if (!path || path[0] != '/') {
+        isOpen_ = false;
+        return;
+    }
+    path_ = path;
+    cacheTime_ = std::chrono::milliseconds(cacheMs);
+    isOpen_ = true;
+}
+
+bool Metrics::IsOpen() const {
+    return isOpen_;
+}
+
+const std::string& Metrics::Path() const {
+    return path_;
+}
+
+Metrics::Slot* Metrics::LocalSlot_() {
+    static thread_local Slot* slot = nullptr;
+    if (!slot) {
+        std::unique_ptr<Slot> newSlot(new Slot());
+        for (int i = 0; i < COUNTER_NUM; ++i) {
+            newSlot->counters[i] = 0;
+        }
+        for (int i = 0; i <= STATUS_NUM; ++i) {
+            newSlot->statuses[i] = 0;
+        }
+        for (int i = 0; i < HISTOGRAM_NUM; ++i) {
+            for (int j = 0; j < HISTOGRAM_BUCKETS; ++j) {
+                newSlot->buckets[i][j] = 0;
+            }
+            newSlot->sums[i] = 0;
+        }
+        slot = newSlot.get();
+        std::lock_guard<std::mutex> locker(mutex_);
+        slots_.push_back(std::move(newSlot));
+    }
+    return slot;
+}
+
+void Metrics::Add(COUNTER id, uint64_t count) {
+    // only the owner thread writes its slot, a relaxed load and store is enough
+    // and avoids the locked instruction of fetch_add
+    std::atomic<uint64_t>& counter = LocalSlot_()->counters[id];
+    counter.store(counter.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+}
+
+void Metrics::AddRequest(int code) {
+    // one counter per code, so a flood of 413 and a storm of 500 stay apart
+    int index = (code >= STATUS_MIN && code < STATUS_MIN + STATUS_NUM) ? code - STATUS_MIN : STATUS_NUM;
+    std::atomic<uint64_t>& counter = LocalSlot_()->statuses[index];
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void Metrics::Record(HISTOGRAM id, uint64_t us) {
+    RecordNs(id, us * 1000);
+}
+
+void Metrics::RecordNs(HISTOGRAM id, uint64_t ns) {
+    Slot* slot = LocalSlot_();
+    std::atomic<uint64_t>& bucket = slot->buckets[id][BucketIndex_(ns / 1000)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic<uint64_t>& sum = slot->sums[id];
+    sum.store(sum.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+}
+
+void Metrics::Set(GAUGE id, int64_t value) {
+    gauges_[id].store(value, std::memory_order_relaxed);
+}
+
+void Metrics::AddCollector(const CollectCallBack& collector) {
+    std::lock_guard<std::mutex> locker(mutex_);
+    collectors_.push_back(collector);
+}
+
+std::string Metrics::Scrape() {
+    // concurrent scrapes within cacheMs share one rendering
+    std::lock_guard<std::mutex> locker(cacheMutex_);
+    Clock::time_point now = Clock::now();
+    if (cache_.empty() || now - cachedAt_ >= cacheTime_) {
+        cache_ = Render_();
+        cachedAt_ = now;
+    }
+    return cache_;
+}
+
+void Metrics::AppendHeader(std::string& out, const char* name, const char* type, const char* help) {
+    out += "# HELP ";
+    out += name;
+    out += " ";
+    out += help;
+    out += "\n# TYPE ";
+    out += name;
+    out += " ";
+    out += type;
+    out += "\n";
+}
+
+void Metrics::AppendSample(std::string& out, const char* name, const std::string& labels, double value) {
+    char num[32];
+    snprintf(num, sizeof(num), "%.9g", value);
+    out += name;
+    out += labels;
+    out += " ";
+    out += num;
+    out += "\n";
+}
+
+std::string Metrics::Render_() {
+    uint64_t counters[COUNTER_NUM] = {0};
+    uint64_t statuses[STATUS_NUM + 1] = {0};
+    std::vector<uint64_t> buckets(HISTOGRAM_NUM * HISTOGRAM_BUCKETS, 0);
+    uint64_t sums[HISTOGRAM_NUM] = {0};
+    std::vector<CollectCallBack> collectors;
+    {
+        std::lock_guard<std::mutex> locker(mutex_);
+        for (auto& slot : slots_) {
+            for (int i = 0; i < COUNTER_NUM; ++i) {
+                counters[i] += slot->counters[i].load(std::memory_order_relaxed);
+            }
+            for (int i = 0; i <= STATUS_NUM; ++i) {
+                statuses[i] += slot->statuses[i].load(std::memory_order_relaxed);
+            }
+            for (int i = 0; i < HISTOGRAM_NUM; ++i) {
+                for (int j = 0; j < HISTOGRAM_BUCKETS; ++j) {
+                    buckets[i * HISTOGRAM_BUCKETS + j] += slot->buckets[i][j].load(std::memory_order_relaxed);
+                }
+                sums[i] += slot->sums[i].load(std::memory_order_relaxed);
+            }
+        }
+        collectors = collectors_;
+    }
+
+    std::string out;
+    out.reserve(16384);
+    AppendHeader(out, "slim_http_requests_total", "counter", "HTTP responses by status code.");
+    // a code appears once the server has answered with it and stays from then on
+    for (int i = 0; i <= STATUS_NUM; ++i) {
+        if (statuses[i] > 0) {
+            std::string code = i < STATUS_NUM ? std::to_string(STATUS_MIN + i) : "other";
+            AppendSample(out, "slim_http_requests_total", "{code=\"" + code + "\"}", statuses[i]);
+        }
+    }
+    AppendHeader(out, "slim_http_received_bytes_total", "counter", "Bytes read from clients.");
+    AppendSample(out, "slim_http_received_bytes_total", "", counters[BYTES_IN]);
+    AppendHeader(out, "slim_http_sent_bytes_total", "counter", "Bytes written to clients.");
+    AppendSample(out, "slim_http_sent_bytes_total", "", counters[BYTES_OUT]);
+    AppendHeader(out, "slim_thread_pool_tasks_total", "counter", "Tasks run by the thread pool.");
+    AppendSample(out, "slim_thread_pool_tasks_total", "", counters[POOL_TASKS]);
+    AppendHeader(out, "slim_timer_expired_total", "counter", "Connections closed by the timer.");
+    AppendSample(out, "slim_timer_expired_total", "", counters[TIMER_EXPIRED]);
+    AppendHeader(out, "slim_log_queue_full_total", "counter", "Log lines written synchronously because the async queue was full.");
+    AppendSample(out, "slim_log_queue_full_total", "", counters[LOG_QUEUE_FULL]);
+
+    AppendHeader(out, "slim_http_connections", "gauge", "Open client connections.");
+    AppendSample(out, "slim_http_connections", "", gauges_[CONNECTIONS].load(std::memory_order_relaxed));
+    AppendHeader(out, "slim_thread_pool_queue_depth", "gauge", "Tasks waiting in the thread pool queue.");
+    AppendSample(out, "slim_thread_pool_queue_depth", "", gauges_[POOL_QUEUE_DEPTH].load(std::memory_order_relaxed));
+    AppendHeader(out, "slim_timer_connections", "gauge", "Connections tracked by the timer.");
+    AppendSample(out, "slim_timer_connections", "", gauges_[TIMER_COUNT].load(std::memory_order_relaxed));
+
+    for (int i = 0; i < HISTOGRAM_NUM; ++i) {
+        const char* name = HISTOGRAM_INFO[i].name;
+        std::string bucketName = std::string(name) + "_bucket";
+        std::string label = HISTOGRAM_INFO[i].label;
+        std::string prefix = label.empty() ? "{" : "{" + label + ",";
+        std::string labels = label.empty() ? "" : "{" + label + "}";
+        if (i == 0 || strcmp(name, HISTOGRAM_INFO[i - 1].name) != 0) {
+            AppendHeader(out, name, "histogram", HISTOGRAM_INFO[i].help);
+        }
+        uint64_t count = 0;
+        char le[48];
+        // the last bucket also holds the values above its bound, it is only reported as +Inf
+        for (int j = 0; j < HISTOGRAM_BUCKETS - 1; ++j) {
+            count += buckets[i * HISTOGRAM_BUCKETS + j];
+            snprintf(le, sizeof(le), "le=\"%.9g\"}", BucketUpper_(j) / 1e6);
+            AppendSample(out, bucketName.c_str(), prefix + le, count);
+        }
+        count += buckets[i * HISTOGRAM_BUCKETS + HISTOGRAM_BUCKETS - 1];
+        AppendSample(out, bucketName.c_str(), prefix + "le=\"+Inf\"}", count);
+        AppendSample(out, (std::string(name) + "_sum").c_str(), labels, sums[i] / 1e9);
+        AppendSample(out, (std::string(name) + "_count").c_str(), labels, count);
+    }
+
+    for (auto& collector : collectors) {
+        collector(out);
+    }
+    return out;
+}
+
+int Metrics::BucketIndex_(uint64_t us) {
+    if (us < SUB_BUCKETS) {
+        return us;
+    }
+    int power = 63 - __builtin_clzll(us);
+    if (power >= MAX_POWER) {
+        return HISTOGRAM_BUCKETS - 1;
+    }
+    int sub = (us >> (power - 2)) & (SUB_BUCKETS - 1);
+    return (power - 1) * SUB_BUCKETS + sub;
+}
+
+uint64_t Metrics::BucketUpper_(int index) {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    int power = index / SUB_BUCKETS + 1;
+    int sub = index % SUB_BUCKETS;
+    return ((uint64_t)(SUB_BUCKETS + sub + 1) << (power - 2)) - 1;
+}
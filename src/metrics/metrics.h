@@ -0,0 +1,151 @@
+//
+// Created by pyq on 10/19/26.
+//
+#pragma once
+#ifndef SLIM_WEB_SERVER_METRICS_H
+#define SLIM_WEB_SERVER_METRICS_H
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <functional>
+
+// Process wide metrics rendered in the Prometheus text format.
+// Counters and histograms are recorded into a slot owned by the calling thread without locks or
+// atomic read-modify-write, a scrape sums the slots of every thread. Gauges are plain atomics.
+class Metrics {
+public:
+    // Enumerates the counters.
+    enum COUNTER {
+        BYTES_IN = 0,       // Bytes read from clients.
+        BYTES_OUT,          // Bytes written to clients.
+        POOL_TASKS,         // Tasks run by the thread pool.
+        TIMER_EXPIRED,      // Connections closed by the timer.
+        LOG_QUEUE_FULL,     // Log lines written synchronously because the async queue was full.
+        COUNTER_NUM,
+    };
+
+    // Enumerates the latency histograms, values are recorded in microseconds.
+    enum HISTOGRAM {
+        PHASE_READ = 0,     // Accept to read readiness, first request of a connection only.
+        PHASE_QUEUE,        // Read readiness to a worker taking the read task.
+        PHASE_PARSE,        // Reading and parsing the request.
+        PHASE_HANDLE,       // Handling the request and building the response.
+        PHASE_FIRST_WRITE,  // Response built to its first byte written.
+        PHASE_WRITE,        // First to last byte of the response written.
+        REQUEST_TIME,       // Accept (or read readiness) to the last byte written.
+        POOL_WAIT,          // Time a task waited in the thread pool queue.
+        LOOP_WAIT,          // Time the event loop spent in epoll_wait, blocking included.
+        LOOP_DISPATCH,      // Time the event loop spent dispatching the events of one epoll_wait.
+        TIMER_TICK,         // Time the event loop spent expiring timers and computing the next timeout.
+        HISTOGRAM_NUM,
+    };
+
+    // Enumerates the gauges.
+    enum GAUGE {
+        CONNECTIONS = 0,    // Open client connections.
+        POOL_QUEUE_DEPTH,   // Tasks waiting in the thread pool queue.
+        TIMER_COUNT,        // Connections tracked by the timer.
+        GAUGE_NUM,
+    };
+
+    // Log-linear buckets: values below 4us get a bucket each,
+    // every following power of two is split into SUB_BUCKETS linear buckets, up to 2^MAX_POWER us.
+    static const int SUB_BUCKETS = 4;
+    static const int MAX_POWER = 24;
+    static const int HISTOGRAM_BUCKETS = (MAX_POWER - 1) * SUB_BUCKETS;
+
+    // Appends extra samples to a scrape.
+    using CollectCallBack = std::function<void(std::string&)>;
+
+    // Singleton access method.
+    static Metrics* Instance();
+
+    // Enables the endpoint at path (e.g. "/metrics"), a scrape reuses the rendered reply for cacheMs.
+    void Init(const char* path, int cacheMs = 1000);
+
+    // Returns true if the endpoint is enabled.
+    bool IsOpen() const;
+
+    // Returns the path of the endpoint.
+    const std::string& Path() const;
+
+    // Adds count to a counter of the calling thread.
+    void Add(COUNTER id, uint64_t count = 1);
+
+    // Counts a response with the given status code, a code outside 100-599 is counted as "other".
+    void AddRequest(int code);
+
+    // Records a value in microseconds into a histogram of the calling thread.
+    void Record(HISTOGRAM id, uint64_t us);
+
+    // Records a value in nanoseconds, the bucket is chosen in microseconds but the sum keeps the nanoseconds,
+    // so the mean of sub-microsecond values (e.g. a timer tick) is not lost.
+    void RecordNs(HISTOGRAM id, uint64_t ns);
+
+    // Sets a gauge.
+    void Set(GAUGE id, int64_t value);
+
+    // Registers a callback appending samples of other modules to every scrape.
+    void AddCollector(const CollectCallBack& collector);
+
+    // Returns the scrape reply, rendered at most once every cacheMs.
+    std::string Scrape();
+
+    // Appends the HELP and TYPE lines of a metric.
+    static void AppendHeader(std::string& out, const char* name, const char* type, const char* help);
+
+    // Appends a sample, labels is either empty or of the form {a="b"}.
+    static void AppendSample(std::string& out, const char* name, const std::string& labels, double value);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static const int STATUS_MIN = 100;          // Smallest status code counted by itself.
+    static const int STATUS_NUM = 500;          // Status codes counted by themselves, 100 to 599.
+
+    // Per thread storage, only written by its owner and read by scrapes.
+    // Slots are allocated separately and are a few KB each, so two threads rarely share a cache line.
+    struct Slot {
+        std::atomic<uint64_t> counters[COUNTER_NUM];
+        std::atomic<uint64_t> statuses[STATUS_NUM + 1];    // Responses by code - STATUS_MIN, the last one out of range.
+        std::atomic<uint64_t> buckets[HISTOGRAM_NUM][HISTOGRAM_BUCKETS];
+        std::atomic<uint64_t> sums[HISTOGRAM_NUM];     // Sums in nanoseconds.
+    };
+
+    bool isOpen_;                               // Flag indicating if the endpoint is enabled.
+    std::string path_;                          // Path of the endpoint.
+    std::chrono::milliseconds cacheTime_;       // How long a rendered reply is reused.
+    std::atomic<int64_t> gauges_[GAUGE_NUM];    // Current gauge values.
+    std::vector<std::unique_ptr<Slot>> slots_;  // Slots of every thread that recorded, never freed.
+    std::vector<CollectCallBack> collectors_;   // Callbacks of other modules.
+    std::mutex mutex_;                          // Mutex protecting slots_ and collectors_.
+    std::mutex cacheMutex_;                     // Mutex protecting the cached reply.
+    std::string cache_;                         // Last rendered reply.
+    Clock::time_point cachedAt_;                // Time the cached reply was rendered.
+
+    Metrics();
+
+    ~Metrics() = default;
+
+    Metrics(const Metrics& other) = delete;
+    Metrics& operator=(const Metrics& other) = delete;
+
+    // Returns the slot of the calling thread, registering it on first use.
+    Slot* LocalSlot_();
+
+    // Renders every metric.
+    std::string Render_();
+
+    // Returns the bucket of a value.
+    static int BucketIndex_(uint64_t us);
+
+    // Returns the inclusive upper bound of a bucket in microseconds.
+    static uint64_t BucketUpper_(int index);
+};
+
+#endif //SLIM_WEB_SERVER_METRICS_H
@@ -0,0 +1,32 @@
+//
+// Created by pyq on 10/19/26.
+//
+#pragma once
+#ifndef SLIM_WEB_SERVER_PROBE_H
+#define SLIM_WEB_SERVER_PROBE_H
+
+// USDT (user statically defined tracing) probes of the provider "slim".
+// A probe compiles to a single nop plus an ELF note, so it costs nothing until bpftrace or perf attaches to it.
+// Probes are built when <sys/sdt.h> (systemtap-sdt-dev) is available, "make USDT=0" defines SLIM_NO_USDT
+// and compiles them out entirely. Arguments are only evaluated when the probes are built.
+
+#if !defined(SLIM_NO_USDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#define SLIM_HAS_USDT 1
+#endif
+#endif
+
+#ifdef SLIM_HAS_USDT
+#include <sys/sdt.h>
+#define SLIM_PROBE(name) DTRACE_PROBE(slim, name)
+#define SLIM_PROBE1(name, a1) DTRACE_PROBE1(slim, name, a1)
+#define SLIM_PROBE2(name, a1, a2) DTRACE_PROBE2(slim, name, a1, a2)
+#define SLIM_PROBE3(name, a1, a2, a3) DTRACE_PROBE3(slim, name, a1, a2, a3)
+#else
+#define SLIM_PROBE(name) do {} while (0)
+#define SLIM_PROBE1(name, a1) do {} while (0)
+#define SLIM_PROBE2(name, a1, a2) do {} while (0)
+#define SLIM_PROBE3(name, a1, a2, a3) do {} while (0)
+#endif
+
+#endif //SLIM_WEB_SERVER_PROBE_H
@@ -0,0 +1,192 @@
+//
+// Created by pyq on 10/19/26.
+//
+#include "cpu_profiler.h"
+#include <dlfcn.h>
+#include <unistd.h>
+#include <cxxabi.h>
+#include <sys/uio.h>
+#include <sys/time.h>
+#include <cstring>
+#include <cstdlib>
+#include <cassert>
+#include <algorithm>
+#include <thread>
+#include <unordered_map>
+#include "../log/log.h"
+
+CpuProfiler* CpuProfiler::Instance() {
+    static CpuProfiler profiler;
+    return &profiler;
+}
+
+CpuProfiler::CpuProfiler() : isRunning_(false), next_(0) {}
+
+int CpuProfiler::Profile(int seconds, int hz, std::string* folded) {
+    assert(folded && hz > 0);
+    std::unique_lock<std::mutex> locker(mutex_, std::try_to_lock);
+    if (!locker.owns_lock()) {
+        return BUSY;
+    }
+    // SIGPROF fires per hz of CPU time of the whole process, 
+    // so a busy server on n cores produces up to n * hz samples per second
+    size_t capacity = std::min(MAX_SAMPLES, (size_t)seconds * hz * std::max(1u, std::thread::hardware_concurrency()));
+    samples_.assign(capacity, Sample());
+    next_ = 0;
+
+    // SA_RESTART keeps the sockets and the database client from seeing EINTR,
+    // epoll_wait still returns early with EINTR, which the event loop tolerates
+    struct sigaction action, oldAction;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = &CpuProfiler::OnSignal_;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, &oldAction) < 0) {
+        LOG_ERROR("CpuProfiler sigaction Error: %s", strerror(errno));
+        samples_.clear();
+        samples_.shrink_to_fit();
+        return TIMER_ERROR;
+    }
+    isRunning_ = true;
+
+    // tv_usec must stay below a second, 1Hz is tv_sec 1
+    itimerval timer;
+    long intervalUs = 1000000L / hz;
+    timer.it_interval.tv_sec = intervalUs / 1000000;
+    timer.it_interval.tv_usec = intervalUs % 1000000;
+    timer.it_value = timer.it_interval;
+    if (setitimer(ITIMER_PROF, &timer, nullptr) < 0) {
+        LOG_ERROR("CpuProfiler setitimer Error: %s", strerror(errno));
+        isRunning_ = false;
+        sigaction(SIGPROF, &oldAction, nullptr);
+        samples_.clear();
+        samples_.shrink_to_fit();
+        return TIMER_ERROR;
+    }
+    LOG_INFO("CpuProfiler Start: %ds at %dHz", seconds, hz);
+
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+
+    memset(&timer, 0, sizeof(timer));
+    setitimer(ITIMER_PROF, &timer, nullptr);
+    isRunning_ = false;
+    // a handler may still be running on another thread, it checked isRunning_ before we cleared it
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    sigaction(SIGPROF, &oldAction, nullptr);
+
+    // count identical stacks, then symbolize every distinct pc once
+    size_t count = std::min(next_.load(), capacity);
+    std::map<std::vector<uintptr_t>, uint64_t> stacks;
+    for (size_t i = 0; i < count; ++i) {
+        const Sample& sample = samples_[i];
+        if (sample.depth > 0) {
+            stacks[std::vector<uintptr_t>(sample.pcs, sample.pcs + sample.depth)]++;
+        }
+    }
+    std::unordered_map<uintptr_t, std::string> symbols;
+    folded->clear();
+    for (auto& stack : stacks) {
+        std::string line;
+        // folded stacks go from the root to the leaf
+        for (auto it = stack.first.rbegin(); it != stack.first.rend(); ++it) {
+            // return addresses point after the call, step back into it, except for the interrupted pc
+            uintptr_t pc = (it == stack.first.rend() - 1) ? *it : *it - 1;
+            auto symbol = symbols.find(pc);
+            if (symbol == symbols.end()) {
+                symbol = symbols.emplace(pc, Symbolize_(pc)).first;
+            }
+            if (!line.empty()) {
+                line += ";";
+            }
+            line += symbol->second;
+        }
+        *folded += line + " " + std::to_string(stack.second) + "\n";
+    }
+    LOG_INFO("CpuProfiler Done: %zu samples, %zu dropped, %zu stacks", count, next_.load() - count, stacks.size());
+    samples_.clear();
+    samples_.shrink_to_fit();
+    return OK;
+}
+
+void CpuProfiler::OnSignal_(int sig, siginfo_t* info, void* context) {
+    CpuProfiler* profiler = Instance();
+    if (!profiler->isRunning_.load(std::memory_order_acquire)) {
+        return;
+    }
+    size_t index = profiler->next_.fetch_add(1, std::memory_order_relaxed);
+    if (index >= profiler->samples_.size()) {
+        return;
+    }
+    int savedErrno = errno;
+    Sample& sample = profiler->samples_[index];
+    sample.depth = Unwind_(static_cast<const ucontext_t*>(context), sample.pcs, MAX_DEPTH);
+    errno = savedErrno;
+}
+
+int CpuProfiler::Unwind_(const ucontext_t* context, uintptr_t* pcs, int maxDepth) {
+    uintptr_t pc, fp, sp;
+#if defined(__x86_64__)
+    pc = context->uc_mcontext.gregs[REG_RIP];
+    fp = context->uc_mcontext.gregs[REG_RBP];
+    sp = context->uc_mcontext.gregs[REG_RSP];
+#elif defined(__aarch64__)
+    pc = context->uc_mcontext.pc;
+    fp = context->uc_mcontext.regs[29];
+    sp = context->uc_mcontext.sp;
+#else
+    // no frame pointer walk on this architecture, keep the leaf only
+    (void)context;
+    return 0;
+#endif
+    int depth = 0;
+    pcs[depth++] = pc;
+    // the frame record is {previous fp, return address} on both x86_64 and aarch64,
+    // frames must live above the interrupted sp and move up the stack
+    while (depth < maxDepth && fp >= sp && fp % sizeof(uintptr_t) == 0) {
+        uintptr_t frame[2];
+        if (!SafeRead_(fp, frame, sizeof(frame)) || frame[1] == 0) {
+            break;
+        }
+        pcs[depth++] = frame[1];
+        if (frame[0] <= fp || frame[0] - fp > (1 << 20)) {
+            break;
+        }
+        fp = frame[0];
+    }
+    return depth;
+}
+
+bool CpuProfiler::SafeRead_(uintptr_t addr, void* out, size_t len) {
+    // a garbage frame pointer would crash a plain load, the kernel returns EFAULT instead
+    iovec local = {out, len};
+    iovec remote = {reinterpret_cast<void*>(addr), len};
+    return process_vm_readv(getpid(), &local, 1, &remote, 1, 0) == (ssize_t)len;
+}
+
+std::string CpuProfiler::Symbolize_(uintptr_t pc) {
+    Dl_info info;
+    memset(&info, 0, sizeof(info));
+    bool found = dladdr(reinterpret_cast<void*>(pc), &info) != 0;
+    if (found && info.dli_sname) {
+        int status = 0;
+        char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+        std::string name = (status == 0 && demangled) ? demangled : info.dli_sname;
+        free(demangled);
+        // ';' separates the frames of a folded stack
+        for (char& ch : name) {
+            if (ch == ';') {
+                ch = ':';
+            }
+        }
+        return name;
+    }
+    char buf[256];
+    if (found && info.dli_fname) {
+        const char* base = strrchr(info.dli_fname, '/');
+        snprintf(buf, sizeof(buf), "[%s+0x%lx]", base ? base + 1 : info.dli_fname,
+                 (unsigned long)(pc - reinterpret_cast<uintptr_t>(info.dli_fbase)));
+    } else {
+        snprintf(buf, sizeof(buf), "[0x%lx]", (unsigned long)pc);
+    }
+    return buf;
+}
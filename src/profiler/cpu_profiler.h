@@ -0,0 +1,73 @@
+//
+// Created by pyq on 10/19/26.
+//
+#pragma once
+#ifndef SLIM_WEB_SERVER_CPU_PROFILER_H
+#define SLIM_WEB_SERVER_CPU_PROFILER_H
+
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <signal.h>
+#include <ucontext.h>
+
+// In-process sampling CPU profiler.
+// ITIMER_PROF sends SIGPROF every 1/hz second of CPU time consumed by the process, the handler walks
+// the frame pointer chain of the interrupted thread and stores the return addresses in a preallocated buffer.
+// Stacks are only reliable in a build keeping frame pointers ("make FRAME_POINTER=1").
+class CpuProfiler {
+public:
+    // Enumerates the results of a profile.
+    enum RESULT {
+        OK = 0,
+        BUSY,           // Another profile is running.
+        TIMER_ERROR,    // The signal handler or the timer could not be installed.
+    };
+
+    // Singleton access method.
+    static CpuProfiler* Instance();
+
+    // Samples the process for seconds at hz and writes the stacks in the folded format
+    // ("main;WebServer::Start;Epoller::Wait 42" per line) used by flamegraph.pl. 
+    // Blocks the caller for the whole duration, returns a RESULT.
+    int Profile(int seconds, int hz, std::string* folded);
+
+private:
+    static const int MAX_DEPTH = 32;            // Frames kept per sample.
+    static const size_t MAX_SAMPLES = 65536;    // Upper bound of the sample buffer.
+
+    // One stack, pcs[0] is the interrupted instruction.
+    struct Sample {
+        int depth;
+        uintptr_t pcs[MAX_DEPTH];
+    };
+
+    std::mutex mutex_;                  // Mutex serializing the profiles.
+    std::vector<Sample> samples_;       // Preallocated buffer filled by the signal handler.
+    std::atomic<bool> isRunning_;       // Flag telling the handler to record.
+    std::atomic<size_t> next_;          // Next free sample, may run past the buffer.
+
+    CpuProfiler();
+
+    ~CpuProfiler() = default;
+
+    CpuProfiler(const CpuProfiler& other) = delete;
+    CpuProfiler& operator=(const CpuProfiler& other) = delete;
+
+    // SIGPROF handler, async-signal-safe.
+    static void OnSignal_(int sig, siginfo_t* info, void* context);
+
+    // Walks the frame pointer chain from a signal context, returns the number of pcs written.
+    static int Unwind_(const ucontext_t* context, uintptr_t* pcs, int maxDepth);
+
+    // Reads memory that may be unmapped without faulting, returns false if it is not readable.
+    static bool SafeRead_(uintptr_t addr, void* out, size_t len);
+
+    // Returns the demangled function name of a pc, or module+offset if there is no symbol.
+    static std::string Symbolize_(uintptr_t pc);
+};
+
+#endif //SLIM_WEB_SERVER_CPU_PROFILER_H
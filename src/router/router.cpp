@@ -0,0 +1,201 @@
+//
+// Created by pyq on 10/19/26.
+//
+#include <cstring>
+#include <algorithm>
+#include "router.h"
+
+Router::Params::Params() : size_(0) {}
+
+std::string Router::Params::Get(const std::string& name) const {
+    for (int i = 0; i < size_; ++i) {
+        if (*names_[i] == name) {
+            return std::string(values_[i], lens_[i]);
+        }
+    }
+    return "";
+}
+
+int Router::Params::Size() const {
+    return size_;
+}
+
+Router* Router::Instance() {
+    static Router instance;
+    return &instance;
+}
+
+Router::Router() : size_(0) {
+    NewNode_();
+}
+
+Router::METHOD Router::ParseMethod(const std::string& method) {
+    static const char* NAMES[] = {"GET", "POST", "HEAD", "PUT", "DELETE", "PATCH", "OPTIONS", "*"};
+    for (int i = 0; i < METHOD_NUM; ++i) {
+        if (method == NAMES[i]) {
+            return static_cast<METHOD>(i);
+        }
+    }
+    return METHOD_NUM;
+}
+
+int Router::NewNode_() {
+    Node node;
+    node.param = -1;
+    std::fill(node.exact, node.exact + METHOD_NUM, nullptr);
+    std::fill(node.prefix, node.prefix + METHOD_NUM, nullptr);
+    node.hasPrefix = false;
+    nodes_.push_back(std::move(node));
+    return nodes_.size() - 1;
+}
+
+bool Router::Add(const std::string& method, const std::string& pattern, std::shared_ptr<Handler> handler) {
+    METHOD id = ParseMethod(method);
+    if (id == METHOD_NUM || !handler || pattern.empty() || pattern[0] != '/') {
+        return false;
+    }
+    // "/" is the root, "/users/:id" has the segments "users" and ":id"
+    int cur = 0;
+    int params = 0;
+    bool isPrefix = false;
+    size_t pos = 1;
+    while (pos <= pattern.size() && !(pos == pattern.size() && cur == 0)) {
+        size_t end = pattern.find('/', pos);
+        if (end == std::string::npos) {
+            end = pattern.size();
+        }
+        std::string segment = pattern.substr(pos, end - pos);
+        pos = end + 1;
+        if (segment == "*") {
+            // only as the last segment
+            if (end != pattern.size()) {
+                return false;
+            }
+            isPrefix = true;
+            break;
+        }
+        if (!segment.empty() && segment[0] == ':') {
+            std::string name = segment.substr(1);
+            if (name.empty() || ++params > Params::MAX_PARAMS) {
+                return false;
+            }
+            if (nodes_[cur].param < 0) {
+                int child = NewNode_();
+                nodes_[cur].param = child;
+                nodes_[cur].paramName = name;
+            } else if (nodes_[cur].paramName != name) {
+                return false;
+            }
+            cur = nodes_[cur].param;
+            continue;
+        }
+        int child = FindChild_(nodes_[cur], segment.data(), segment.size());
+        if (child < 0) {
+            child = NewNode_();
+            auto& children = nodes_[cur].children;
+            auto it = std::lower_bound(children.begin(), children.end(), segment,
+                                       [](const std::pair<std::string, int>& a, const std::string& b) { return a.first < b; });
+            children.insert(it, std::make_pair(segment, child));
+        }
+        cur = child;
+    }
+
+    Handler** slot = isPrefix ? &nodes_[cur].prefix[id] : &nodes_[cur].exact[id];
+    if (*slot) {
+        return false;
+    }
+    *slot = handler.get();
+    nodes_[cur].hasPrefix = nodes_[cur].hasPrefix || isPrefix;
+    if (std::find(handlers_.begin(), handlers_.end(), handler) == handlers_.end()) {
+        handlers_.push_back(handler);
+    }
+    ++size_;
+    return true;
+}
+
+int Router::FindChild_(const Node& node, const char* segment, size_t len) const {
+    // binary search over the children sorted by std::string order, i.e. by bytes then by length
+    size_t lo = 0, hi = node.children.size();
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        int cmp = node.children[mid].first.compare(0, std::string::npos, segment, len);
+        if (cmp == 0) {
+            return node.children[mid].second;
+        }
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return -1;
+}
+
+Router::Handler* Router::Select_(Handler* const* handlers, METHOD method) {
+    if (method != METHOD_NUM && handlers[method]) {
+        return handlers[method];
+    }
+    return handlers[ANY];
+}
+
+Router::Handler* Router::Find(const std::string& method, const std::string& path, Params* params) const {
+    params->size_ = 0;
+    if (size_ == 0 || path.empty() || path[0] != '/') {
+        return nullptr;
+    }
+    METHOD id = ParseMethod(method);
+    const char* data = path.data();
+    size_t len = path.size();
+
+    // the deepest prefix route seen so far and the parameters it had
+    Handler* fallback = nullptr;
+    int fallbackParams = 0;
+    int cur = 0;
+    size_t pos = 1;
+    while (true) {
+        const Node& node = nodes_[cur];
+        if (node.hasPrefix) {
+            Handler* handler = Select_(node.prefix, id);
+            if (handler) {
+                fallback = handler;
+                fallbackParams = params->size_;
+            }
+        }
+        if (pos > len || (pos == len && cur == 0)) {
+            // the whole path is consumed
+            Handler* handler = Select_(node.exact, id);
+            if (handler) {
+                return handler;
+            }
+            break;
+        }
+        const char* end = static_cast<const char*>(memchr(data + pos, '/', len - pos));
+        size_t segLen = (end ? end - data : len) - pos;
+        int child = FindChild_(node, data + pos, segLen);
+        if (child < 0 && node.param >= 0 && segLen > 0 && params->size_ < Params::MAX_PARAMS) {
+            params->names_[params->size_] = &node.paramName;
+            params->values_[params->size_] = data + pos;
+            params->lens_[params->size_] = segLen;
+            params->size_++;
+            child = node.param;
+        }
+        if (child < 0) {
+            break;
+        }
+        cur = child;
+        pos += segLen + 1;
+    }
+    params->size_ = fallbackParams;
+    return fallback;
+}
+
+void Router::Clear() {
+    nodes_.clear();
+    handlers_.clear();
+    size_ = 0;
+    NewNode_();
+}
+
+int Router::Size() const {
+    return size_;
+}
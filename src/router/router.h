@@ -0,0 +1,128 @@
+//
+// Created by pyq on 10/19/26.
+//
+#pragma once
+#ifndef SLIM_WEB_SERVER_ROUTER_H
+#define SLIM_WEB_SERVER_ROUTER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <netinet/in.h>
+
+class HttpRequest;
+class HttpResponse;
+
+// Maps the method and path of a request to a handler object.
+// A pattern is exact ("/login"), has parameters ("/users/:id" matches any value of that segment) or is a
+// prefix ("/static/*" matches /static and every path below it). Routes are added at startup into a trie of
+// path segments; a lookup walks the path once, compares each segment against the sorted children of one
+// node and allocates nothing. A static segment wins over a parameter without backtracking, and the longest
+// prefix route is the fallback when no exact route matches. Requests without a route are served from srcDir.
+class Router {
+public:
+    // Enumerates the methods a route can be added for, ANY matches every method without its own route.
+    enum METHOD {
+        GET = 0,
+        POST,
+        HEAD,
+        PUT,
+        DELETE,
+        PATCH,
+        OPTIONS,
+        ANY,
+        METHOD_NUM,
+    };
+
+    // Values of the :name segments of the matched route, views into the request path.
+    class Params {
+    public:
+        Params();
+
+        // Returns the value of a parameter, empty if the route has no parameter of that name.
+        std::string Get(const std::string& name) const;
+
+        // Returns the number of parameters.
+        int Size() const;
+
+        static const int MAX_PARAMS = 8;    // Most parameters of one route.
+
+    private:
+        friend class Router;
+
+        int size_;                          // Number of parameters.
+        const std::string* names_[MAX_PARAMS];  // Names, owned by the router.
+        const char* values_[MAX_PARAMS];    // Values, pointers into the request path.
+        size_t lens_[MAX_PARAMS];           // Lengths of the values.
+    };
+
+    // Request handed to a handler.
+    struct Context {
+        HttpRequest& request;       // Parsed request.
+        const sockaddr_in& addr;    // Client address.
+        Params params;              // Parameters of the matched route.
+    };
+
+    // Base of the request handlers. One object serves every request of its routes, from any worker thread.
+    class Handler {
+    public:
+        virtual ~Handler() = default;
+
+        // Called once the headers are parsed, before the body arrives. The handler may hand the body to a
+        // HttpRequest::BodyReader here instead of having it collected in memory. Returning false skips the
+        // body: Handle is called at once, and a connection with a body left unread closes after the response.
+        virtual bool OnHeaders(Context& context) { return true; }
+
+        // Produces the response once the body is read, the response is already initialized to serve the
+        // request path from srcDir.
+        virtual void Handle(Context& context, HttpResponse& response) = 0;
+    };
+
+    static Router* Instance();
+
+    // Adds a route, method is e.g. "GET" or "*" for any method. A handler may serve several routes.
+    // Returns false on a malformed pattern, an unknown method, a route added twice, or two parameter names
+    // at the same position. Routes are added at startup, before the first lookup.
+    bool Add(const std::string& method, const std::string& pattern, std::shared_ptr<Handler> handler);
+
+    // Returns the handler of a request and fills its parameters, nullptr if no route matches.
+    Handler* Find(const std::string& method, const std::string& path, Params* params) const;
+
+    // Drops every route.
+    void Clear();
+
+    // Returns the number of routes.
+    int Size() const;
+
+    // Maps a method name to METHOD, METHOD_NUM if unknown; "*" is ANY.
+    static METHOD ParseMethod(const std::string& method);
+
+private:
+    // A node of the trie, the path of the node is the segments from the root.
+    struct Node {
+        std::vector<std::pair<std::string, int>> children;  // Static segments and their nodes, sorted.
+        int param;                          // Node of the :name child, -1 if none.
+        std::string paramName;              // Name of the :name child.
+        Handler* exact[METHOD_NUM];         // Handlers of the routes ending here.
+        Handler* prefix[METHOD_NUM];        // Handlers of the "/*" routes ending here.
+        bool hasPrefix;                     // Any prefix handler is set.
+    };
+
+    std::vector<Node> nodes_;                       // Trie, the root is nodes_[0] with the path "/".
+    std::vector<std::shared_ptr<Handler>> handlers_;    // Owns the handlers.
+    int size_;                                      // Number of routes.
+
+    Router();
+
+    // Returns the static child of a node matching a segment, -1 if none.
+    int FindChild_(const Node& node, const char* segment, size_t len) const;
+
+    // Returns the handler of a method, falling back to the ANY handler.
+    static Handler* Select_(Handler* const* handlers, METHOD method);
+
+    // Appends an empty node and returns its index.
+    int NewNode_();
+};
+
+#endif //SLIM_WEB_SERVER_ROUTER_H
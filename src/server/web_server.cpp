@@ -7,8 +7,10 @@ WebServer::WebServer(
         int port, int trigMode, int timeoutMs, bool optLinger,
         int sqlPort, const char* sqlUser, const char* sqlPwd,
         const char* dbName, int sqlConnPoolNum, int threadNum,
-        bool enableLog, int logLevel, int logQueSize) :
-        port_(port), openLinger_(optLinger), timeoutMs_(timeoutMs), isClose_(false),   
+        bool enableLog, int logLevel, int logQueSize,
+        int authCacheSize, int userStore, const char* sqlTopology, const char* metricsPath,
+        int slowLogMs, const char* adminSocket, size_t maxBodySize, const char* uploadDir) :
+        port_(port), openLinger_(optLinger), timeoutMs_(timeoutMs), isClose_(false), userStore_(userStore),
         timer_(new Timer()), threadPool_(new ThreadPool(threadNum)), epoller_(new Epoller()) {
     // getcwd returns the program's startup directory
     srcDir_ = getcwd(nullptr, 256);    
@@ -20,12 +22,48 @@ WebServer::WebServer(
         Log::Instance()->Init(logLevel, "./log", ".log", logQueSize);
     }
 
+    // init slow request log, requests slower than slowLogMs are written to ./log/slow.log
+    if (!SlowLog::Instance()->Init("./log", slowLogMs)) {
+        LOG_WARN("Open Slow Log Error!");
+    }
+
     // init http connect static varible
     HttpConn::userCount = 0;
     HttpConn::srcDir = srcDir_;
+    HttpRequest::maxBodySize = maxBodySize;
+
+    // init sql connect pools, only the mysql backend needs them
+    // without a topology there is a single shard on localhost:sqlPort
+    // every pool keeps sqlConnPoolNum connections and may grow to twice as many under load
+    if (userStore_ == UserStore::MYSQL_BACKEND) {
+        std::string topology = sqlTopology ? sqlTopology : "localhost:" + std::to_string(sqlPort);
+        if (!SqlTopology::Instance()->Init(topology.c_str(), sqlUser, sqlPwd, dbName, sqlConnPoolNum, sqlConnPoolNum * 2)) {
+            isClose_ = true;
+        }
+    }
+
+    // init user store backend
+    if (!UserStore::Init(userStore_, "./data")) {
+        isClose_ = true;
+    }
 
-    // init sql connect pool
-    SqlConnPool::Instance()->Init("localhost", sqlPort, sqlUser, sqlPwd, dbName, sqlConnPoolNum);
+    // init auth cache in front of the database
+    AuthCache::Instance()->Init(authCacheSize);
+
+    // init metrics endpoint, nullptr disables it
+    Metrics::Instance()->Init(metricsPath);
+    if (userStore_ == UserStore::MYSQL_BACKEND) {
+        Metrics::Instance()->AddCollector(&WebServer::CollectSqlMetrics_);
+    }
+    Metrics::Instance()->AddCollector(&WebServer::CollectBreakerMetrics_);
+
+    // init routes, requests without a route are served from srcDir
+    InitRoutes_(metricsPath, uploadDir);
+#ifdef SLIM_LOCK_PROFILE
+    // lock contention is also written to the log every 10s
+    Metrics::Instance()->AddCollector(&LockProfiler::Collect);
+    LockProfiler::Instance()->Start(10000);
+#endif
 
     // init epoll event mode
     InitEventMode_(trigMode);
@@ -35,6 +73,11 @@ WebServer::WebServer(
         isClose_ = true;
     }
 
+    // init admin console, nullptr disables it
+    if (!isClose_ && adminSocket) {
+        InitAdmin_(adminSocket);
+    }
+
     if (enableLog) {
         if (isClose_) { 
             LOG_ERROR("========== Slime-Web-Server Init Error! =========="); 
@@ -48,15 +91,25 @@ WebServer::WebServer(
             LOG_INFO("LogSys Level: %d", logLevel);
             LOG_INFO("SrcDir: %s", HttpConn::srcDir);
             LOG_INFO("SqlConnPool Capacity: %d, ThreadPool Capacity: %d", sqlConnPoolNum, threadNum);
+            LOG_INFO("AuthCache Capacity: %d, UserStore: %s", authCacheSize, UserStore::Instance()->Name());
+            LOG_INFO("Metrics: %s, Slow Log Threshold: %dms", Metrics::Instance()->IsOpen() ? Metrics::Instance()->Path().c_str() : "off", slowLogMs);
+            LOG_INFO("Max Body Size: %zu, Upload Dir: %s", maxBodySize, uploadDir ? uploadDir : "off");
         }
     }
 }
     
 WebServer::~WebServer() {
+    // the admin commands use the thread pool and the sql pools, stop them first
+    if (admin_) {
+        admin_->Stop();
+    }
     close(listenFd_);
     isClose_ = true;
     free(srcDir_);
-    SqlConnPool::Instance()->ClosePool();
+    UserStore::Close();
+    if (userStore_ == UserStore::MYSQL_BACKEND) {
+        SqlTopology::Instance()->Close();
+    }
 }
 
 void WebServer::Start() {
@@ -66,17 +119,23 @@ void WebServer::Start() {
     if (!isClose_) {
         LOG_INFO("========== Server Start ==========");
     }
+    Metrics* metrics = Metrics::Instance();
     while (!isClose_) {
         if (timeoutMs_ > 0) {
             // clear inactive connections 
             // and return the expiration time 
             // of the next earliest expiring connection
+            uint64_t tickStart = RequestTrace::NowNs();
             timeMs = timer_->GetNextTick();
+            metrics->RecordNs(Metrics::TIMER_TICK, RequestTrace::NowNs() - tickStart);
         }
         // epoll fd listen events of the http connection fd (listn/connect fd)
         // if no event occurs, it will block for up to timeMs.
         // if the time exceeds, the http connection will be closed.
+        uint64_t waitStart = RequestTrace::NowNs();
         int eventCnt = epoller_->Wait(timeMs);
+        uint64_t dispatchStart = RequestTrace::NowNs();
+        metrics->RecordNs(Metrics::LOOP_WAIT, dispatchStart - waitStart);
         // handle events listened by epoll 
         for (int i = 0; i < eventCnt; ++i) {
             int fd = epoller_->GetEventFd(i);
@@ -100,6 +159,9 @@ void WebServer::Start() {
                 LOG_ERROR("Unexpected Event!");
             }
         }
+        if (eventCnt > 0) {
+            metrics->RecordNs(Metrics::LOOP_DISPATCH, RequestTrace::NowNs() - dispatchStart);
+        }
     }
 }
 
@@ -242,6 +304,7 @@ void WebServer::DealListen_() {
             LOG_WARN("Clients is Full!");
             return;
         }
+        SLIM_PROBE2(accept, fd, (int)HttpConn::userCount);
         AddClient_(fd, addr);
     } while (listenEvent_ & EPOLLET);
 }
@@ -249,6 +312,8 @@ void WebServer::DealListen_() {
 // add a new read task to the server's thread pool
 void WebServer::DealRead_(HttpConn* client) {
     assert(client);
+    client->Trace().Mark(RequestTrace::READABLE);
+    SLIM_PROBE1(dispatch_read, client->GetFd());
     ExtentTime_(client);
     threadPool_->AddTask(std::bind(&WebServer::OnRead_, this, client));
 }
@@ -256,6 +321,7 @@ void WebServer::DealRead_(HttpConn* client) {
 // add a new write task to the server's thread pool
 void WebServer::DealWrite_(HttpConn* client) {
     assert(client);
+    SLIM_PROBE1(dispatch_write, client->GetFd());
     ExtentTime_(client);
     threadPool_->AddTask(std::bind(&WebServer::OnWrite_, this, client));
 }
@@ -290,6 +356,7 @@ void WebServer::CloseConn_(HttpConn* client) {
 
 void WebServer::OnRead_(HttpConn* client) {
     assert(client);
+    client->Trace().Mark(RequestTrace::DEQUEUE);
     int ret = -1, readErrno = 0;
     ret = client->Read(&readErrno);
     // error
@@ -310,12 +377,11 @@ void WebServer::OnWrite_(HttpConn* client) {
             OnProcess_(client);
             return;
         }
-    } else if (ret < 0) {
-        // unable to write more data, but should try again later
-        if (writeErrno == EAGAIN) {
-            epoller_->ModFd(client->GetFd(), connEvent_ | EPOLLOUT);
-            return;
-        }
+    } else if (ret > 0 || writeErrno == EAGAIN) {
+        // the socket buffer is full or the LT write loop stopped early, 
+        // continue when the socket is writable again
+        epoller_->ModFd(client->GetFd(), connEvent_ | EPOLLOUT);
+        return;
     }
     CloseConn_(client);
 }
@@ -331,4 +397,249 @@ void WebServer::OnProcess_(HttpConn* client) {
         // so we listen for readable events
         epoller_->ModFd(client->GetFd(), connEvent_ | EPOLLIN);
     }
+}
+
+void WebServer::InitRoutes_(const char* metricsPath, const char* uploadDir) {
+    Router* router = Router::Instance();
+    router->Clear();
+    bool ok = router->Add("*", "/", std::make_shared<PageHandler>("/index.html"));
+    // /login eg. serves /login.html
+    for (const char* page : {"/index", "/register", "/login", "/welcome", "/video", "/picture"}) {
+        ok = router->Add("*", page, std::make_shared<PageHandler>(std::string(page) + ".html")) && ok;
+    }
+    // the forms post to /login and /register
+    auto login = std::make_shared<AuthHandler>(true, "/login.html");
+    auto signUp = std::make_shared<AuthHandler>(false, "/register.html");
+    ok = router->Add("POST", "/login", login) && router->Add("POST", "/login.html", login) && ok;
+    ok = router->Add("POST", "/register", signUp) && router->Add("POST", "/register.html", signUp) && ok;
+    if (Metrics::Instance()->IsOpen()) {
+        ok = router->Add("GET", metricsPath, std::make_shared<MetricsHandler>()) && ok;
+    }
+    ok = router->Add("GET", "/debug/profile", std::make_shared<ProfileHandler>()) && ok;
+    // uploaded files and their temporary files live in uploadDir, nullptr disables uploads
+    if (uploadDir) {
+        mkdir(uploadDir, 0755);
+        ok = router->Add("POST", "/upload", std::make_shared<UploadHandler>(uploadDir)) && ok;
+    }
+    if (!ok) {
+        LOG_ERROR("Add Route Error!");
+    }
+}
+
+void WebServer::InitAdmin_(const char* adminSocket) {
+    admin_.reset(new AdminServer());
+    admin_->AddCommand("stats", "stats", [this](const std::vector<std::string>& args, std::string& out) {
+        char line[256];
+        snprintf(line, sizeof(line), "connections %d\nthreads %zu\nqueue %zu\ntimeout %d\nloglevel %d\nlogasync %s\ndraining %s\n",
+                 (int)HttpConn::userCount, threadPool_->Size(), threadPool_->QueueSize(), (int)timeoutMs_,
+                 Log::Instance()->GetLevel(), Log::Instance()->IsAsync() ? "on" : "off", HttpConn::isDraining ? "on" : "off");
+        out += line;
+        if (userStore_ == UserStore::MYSQL_BACKEND) {
+            SqlTopology::Instance()->ForEachPool([&out](const std::string& name, SqlConnPool* pool) {
+                SqlConnPool::Stats stats = pool->GetStats();
+                char line[256];
+                snprintf(line, sizeof(line), "sqlpool %s min %d max %d in_use %d free %d\n",
+                         name.c_str(), stats.minConn, stats.maxConn, stats.useCount, stats.freeCount);
+                out += line;
+            });
+        }
+        return true;
+    });
+    admin_->AddCommand("metrics", "metrics", [](const std::vector<std::string>& args, std::string& out) {
+        out += Metrics::Instance()->Scrape();
+        return true;
+    });
+    admin_->AddCommand("threads", "threads <num>", [this](const std::vector<std::string>& args, std::string& out) {
+        int num = args.size() == 1 ? atoi(args[0].c_str()) : 0;
+        if (num <= 0 || num > 1024) {
+            out = "usage: threads <1-1024>";
+            return false;
+        }
+        threadPool_->Resize(num);
+        LOG_INFO("ThreadPool Resized to %d", num);
+        return true;
+    });
+    admin_->AddCommand("loglevel", "loglevel <0-3>", [](const std::vector<std::string>& args, std::string& out) {
+        if (args.size() != 1 || args[0].size() != 1 || args[0][0] < '0' || args[0][0] > '3') {
+            out = "usage: loglevel <0-3>";
+            return false;
+        }
+        Log::Instance()->SetLevel(args[0][0] - '0');
+        return true;
+    });
+    admin_->AddCommand("logasync", "logasync on|off", [](const std::vector<std::string>& args, std::string& out) {
+        if (args.size() != 1 || (args[0] != "on" && args[0] != "off")) {
+            out = "usage: logasync on|off";
+            return false;
+        }
+        Log::Instance()->SetAsync(args[0] == "on");
+        return true;
+    });
+    admin_->AddCommand("timeout", "timeout <ms>", [this](const std::vector<std::string>& args, std::string& out) {
+        int ms = args.size() == 1 ? atoi(args[0].c_str()) : 0;
+        // switching the timer on or off at runtime would leave connections without a timer node
+        if (ms <= 0 || timeoutMs_ <= 0) {
+            out = timeoutMs_ <= 0 ? "timeout is disabled at startup" : "usage: timeout <ms>";
+            return false;
+        }
+        // applies to new connections and to existing ones on their next event
+        timeoutMs_ = ms;
+        LOG_INFO("Connection Timeout Set to %dms", ms);
+        return true;
+    });
+    admin_->AddCommand("sqlpool", "sqlpool <min> [max]", [this](const std::vector<std::string>& args, std::string& out) {
+        int minConn = args.size() >= 1 ? atoi(args[0].c_str()) : 0;
+        int maxConn = args.size() == 2 ? atoi(args[1].c_str()) : 0;
+        if (userStore_ != UserStore::MYSQL_BACKEND) {
+            out = "no sql pool with this user store";
+            return false;
+        }
+        if (args.empty() || args.size() > 2 || minConn <= 0 || (args.size() == 2 && maxConn < minConn)) {
+            out = "usage: sqlpool <min> [max]";
+            return false;
+        }
+        SqlTopology::Instance()->ForEachPool([minConn, maxConn](const std::string& name, SqlConnPool* pool) {
+            pool->Resize(minConn, maxConn);
+        });
+        LOG_INFO("SqlConnPool Resized to %d-%d", minConn, maxConn ? maxConn : minConn);
+        return true;
+    });
+    admin_->AddCommand("capture", "capture [start <file> [sampleEvery] [maxMB] | stop]",
+                       [](const std::vector<std::string>& args, std::string& out) {
+        TrafficCapture* capture = TrafficCapture::Instance();
+        if (args.empty()) {
+            TrafficCapture::Stats stats = capture->GetStats();
+            char line[512];
+            snprintf(line, sizeof(line), "capture %s\nfile %s\nsample 1/%d\nrecords %llu\nbytes %llu\nmax_bytes %llu\ndropped %llu\n",
+                     stats.isOpen ? (stats.isFull ? "full" : "on") : "off", stats.path.c_str(), stats.sampleEvery,
+                     (unsigned long long)stats.records, (unsigned long long)stats.bytes,
+                     (unsigned long long)stats.maxBytes, (unsigned long long)stats.dropped);
+            out += line;
+            return true;
+        }
+        if (args[0] == "stop" && args.size() == 1) {
+            capture->Close();
+            LOG_INFO("Traffic Capture Stopped");
+            return true;
+        }
+        int sampleEvery = args.size() >= 3 ? atoi(args[2].c_str()) : 1;
+        long maxMb = args.size() >= 4 ? atol(args[3].c_str()) : 0;
+        if (args[0] != "start" || args.size() < 2 || args.size() > 4 || sampleEvery <= 0 || maxMb < 0) {
+            out = "usage: capture [start <file> [sampleEvery] [maxMB] | stop]";
+            return false;
+        }
+        if (!capture->Open(args[1].c_str(), sampleEvery, (uint64_t)maxMb << 20)) {
+            out = "can not open " + args[1];
+            return false;
+        }
+        LOG_INFO("Traffic Capture to %s, Sample 1/%d, Max %ldMB", args[1].c_str(), sampleEvery, maxMb);
+        return true;
+    });
+    admin_->AddCommand("drain", "drain", [this](const std::vector<std::string>& args, std::string& out) {
+        return Drain_(out);
+    });
+    admin_->AddCommand("undrain", "undrain", [this](const std::vector<std::string>& args, std::string& out) {
+        return Undrain_(out);
+    });
+    if (!admin_->Start(adminSocket)) {
+        LOG_WARN("Open Admin Socket Error!");
+        admin_.reset();
+    }
+}
+
+// epoll_ctl is thread safe, the admin thread changes the interest list of the main loop directly
+bool WebServer::Drain_(std::string& out) {
+    if (HttpConn::isDraining.exchange(true)) {
+        out = "already draining";
+        return false;
+    }
+    epoller_->DelFd(listenFd_);
+    LOG_INFO("Server Draining, %d Connections Left", (int)HttpConn::userCount);
+    return true;
+}
+
+bool WebServer::Undrain_(std::string& out) {
+    if (!HttpConn::isDraining.exchange(false)) {
+        out = "not draining";
+        return false;
+    }
+    epoller_->AddFd(listenFd_, listenEvent_ | EPOLLIN);
+    LOG_INFO("Server Accepting Again");
+    return true;
+}
+
+void WebServer::CollectSqlMetrics_(std::string& out) {
+    std::vector<std::pair<std::string, SqlConnPool::Stats>> pools;
+    SqlTopology::Instance()->ForEachPool([&pools](const std::string& name, SqlConnPool* pool) {
+        pools.emplace_back(name, pool->GetStats());
+    });
+
+    Metrics::AppendHeader(out, "slim_sql_pool_connections", "gauge", "Connections of a sql pool by state.");
+    for (auto& pool : pools) {
+        Metrics::AppendSample(out, "slim_sql_pool_connections", "{pool=\"" + pool.first + "\",state=\"in_use\"}", pool.second.useCount);
+        Metrics::AppendSample(out, "slim_sql_pool_connections", "{pool=\"" + pool.first + "\",state=\"free\"}", pool.second.freeCount);
+    }
+    Metrics::AppendHeader(out, "slim_sql_pool_max_connections", "gauge", "Maximum connections of a sql pool.");
+    for (auto& pool : pools) {
+        Metrics::AppendSample(out, "slim_sql_pool_max_connections", "{pool=\"" + pool.first + "\"}", pool.second.maxConn);
+    }
+    Metrics::AppendHeader(out, "slim_sql_pool_acquire_total", "counter", "Connections handed out by a sql pool.");
+    for (auto& pool : pools) {
+        Metrics::AppendSample(out, "slim_sql_pool_acquire_total", "{pool=\"" + pool.first + "\"}", pool.second.acquireCount);
+    }
+    Metrics::AppendHeader(out, "slim_sql_pool_timeout_total", "counter", "Connection requests of a sql pool that timed out.");
+    for (auto& pool : pools) {
+        Metrics::AppendSample(out, "slim_sql_pool_timeout_total", "{pool=\"" + pool.first + "\"}", pool.second.timeoutCount);
+    }
+    Metrics::AppendHeader(out, "slim_sql_pool_reconnect_total", "counter", "Connections of a sql pool replaced after a failure.");
+    for (auto& pool : pools) {
+        Metrics::AppendSample(out, "slim_sql_pool_reconnect_total", "{pool=\"" + pool.first + "\"}", pool.second.reconnectCount);
+    }
+
+    // wait bucket i counts waits below 2^i us, the last one also holds the longer waits
+    Metrics::AppendHeader(out, "slim_sql_pool_wait_seconds", "histogram", "Time spent waiting for a sql connection.");
+    for (auto& pool : pools) {
+        std::string label = "{pool=\"" + pool.first + "\",le=\"";
+        uint64_t count = 0;
+        char le[32];
+        for (int i = 0; i < SqlConnPool::WAIT_BUCKETS - 1; ++i) {
+            count += pool.second.waitHist[i];
+            snprintf(le, sizeof(le), "%.9g", ((1ULL << i) - 1) / 1e6);
+            Metrics::AppendSample(out, "slim_sql_pool_wait_seconds_bucket", label + le + "\"}", count);
+        }
+        count += pool.second.waitHist[SqlConnPool::WAIT_BUCKETS - 1];
+        Metrics::AppendSample(out, "slim_sql_pool_wait_seconds_bucket", label + "+Inf\"}", count);
+        Metrics::AppendSample(out, "slim_sql_pool_wait_seconds_sum", "{pool=\"" + pool.first + "\"}", pool.second.waitSumUs / 1e6);
+        Metrics::AppendSample(out, "slim_sql_pool_wait_seconds_count", "{pool=\"" + pool.first + "\"}", count);
+    }
+
+    // utilization bucket i counts samples of i*10% busy, the full pool is folded into le="1"
+    Metrics::AppendHeader(out, "slim_sql_pool_utilization", "histogram", "Share of busy connections sampled on every acquire.");
+    for (auto& pool : pools) {
+        std::string label = "{pool=\"" + pool.first + "\",le=\"";
+        uint64_t count = 0;
+        char le[32];
+        for (int i = 0; i < SqlConnPool::UTIL_BUCKETS - 2; ++i) {
+            count += pool.second.utilHist[i];
+            snprintf(le, sizeof(le), "%.9g", (i + 1) / 10.0);
+            Metrics::AppendSample(out, "slim_sql_pool_utilization_bucket", label + le + "\"}", count);
+        }
+        count += pool.second.utilHist[SqlConnPool::UTIL_BUCKETS - 2] + pool.second.utilHist[SqlConnPool::UTIL_BUCKETS - 1];
+        Metrics::AppendSample(out, "slim_sql_pool_utilization_bucket", label + "1\"}", count);
+        Metrics::AppendSample(out, "slim_sql_pool_utilization_bucket", label + "+Inf\"}", count);
+        Metrics::AppendSample(out, "slim_sql_pool_utilization_sum", "{pool=\"" + pool.first + "\"}", pool.second.utilSumPermille / 1e3);
+        Metrics::AppendSample(out, "slim_sql_pool_utilization_count", "{pool=\"" + pool.first + "\"}", count);
+    }
+}
+
+void WebServer::CollectBreakerMetrics_(std::string& out) {
+    CircuitBreaker::Stats stats = UserStore::Breaker()->GetStats();
+    Metrics::AppendHeader(out, "slim_user_store_breaker_state", "gauge", "State of the user store circuit breaker (0 closed, 1 open, 2 half open).");
+    Metrics::AppendSample(out, "slim_user_store_breaker_state", "", stats.state);
+    Metrics::AppendHeader(out, "slim_user_store_calls_total", "counter", "User store calls by result as seen by the circuit breaker.");
+    Metrics::AppendSample(out, "slim_user_store_calls_total", "{result=\"success\"}", stats.successCount);
+    Metrics::AppendSample(out, "slim_user_store_calls_total", "{result=\"failure\"}", stats.failureCount);
+    Metrics::AppendSample(out, "slim_user_store_calls_total", "{result=\"rejected\"}", stats.rejectCount);
+    Metrics::AppendHeader(out, "slim_user_store_breaker_trips_total", "counter", "Times the user store circuit breaker opened.");
+    Metrics::AppendSample(out, "slim_user_store_breaker_trips_total", "", stats.tripCount);
 }
\ No newline at end of file
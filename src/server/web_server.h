@@ -6,6 +6,7 @@
 #define SLIM_WEB_SERVER_WEB_SERVER_H
 
 #include <fcntl.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <errno.h>
 #include <cassert>
@@ -18,8 +19,16 @@
 #include "../timer/timer.h"
 #include "../sql_connect/sql_connect.h"
 #include "../sql_connect/sql_connect_raii.h"
+#include "../sql_connect/sql_topology.h"
+#include "../user_store/user_store.h"
 #include "../thread_pool/thread_pool.h"
 #include "../http/http_connect.h"
+#include "../http/http_handlers.h"
+#include "../router/router.h"
+#include "../metrics/metrics.h"
+#include "../probe/probe.h"
+#include "../lock_profiler/lock_profiler.h"
+#include "../admin/admin_server.h"
 
 // WebServer integrates logging, database connection pooling, thread pooling, and HTTP processing
 // to create a high-performance, epoll-based (Reactor) web server.
@@ -29,7 +38,11 @@ public:
         int port, int trigMode, int timeoutMs, bool optLinger,
         int sqlPort, const char* sqlUser, const char* sqlPwd,
         const char* dbName, int sqlConnPoolNum, int threadNum,
-        bool enableLog, int logLevel, int logQueSize);
+        bool enableLog, int logLevel, int logQueSize,
+        int authCacheSize = 10000, int userStore = UserStore::MYSQL_BACKEND,
+        const char* sqlTopology = nullptr, const char* metricsPath = "/metrics",
+        int slowLogMs = 500, const char* adminSocket = nullptr, size_t maxBodySize = 1 << 20,
+        const char* uploadDir = nullptr);
     
     ~WebServer();
 
@@ -39,8 +52,9 @@ public:
 private:
     int port_;                    // Port number on which the server will listen for incoming connections
     bool openLinger_;             // Flag to specify if the SO_LINGER option is enabled for sockets
-    int timeoutMs_;               // Timeout in milliseconds for client connections; used for connection timing out
+    std::atomic<int> timeoutMs_;  // Timeout in milliseconds for client connections; used for connection timing out, changed by the admin socket
     bool isClose_;                // Flag to indicate if the server should shut down
+    int userStore_;               // Backend of the user accounts (UserStore::BACKEND)
     int listenFd_;                // File descriptor for the listening socket
     char* srcDir_;                // Directory path that holds the server's resource files
     uint32_t listenEvent_;        // Event types configured for the listening socket (e.g., EPOLLIN, EPOLLET)
@@ -50,6 +64,7 @@ private:
     std::unique_ptr<Timer> timer_;              // Pointer to the Timer object, used for managing connection timeouts
     std::unique_ptr<ThreadPool> threadPool_;    // Pointer to the ThreadPool object, used for managing worker threads
     std::unique_ptr<Epoller> epoller_;          // Pointer to the Epoller object, used for handling epoll-based event notification
+    std::unique_ptr<AdminServer> admin_;        // Pointer to the admin console on a unix socket, nullptr if disabled
     
     std::unordered_map<int, HttpConn> users_;   // Map of file descriptors to HTTP connection handlers
     static const int MAX_FD = 65536;            // Maximum number of file descriptors that the server can handle
@@ -90,8 +105,26 @@ private:
     // Main processing function for handling HTTP requests and responses
     void OnProcess_(HttpConn* client);
 
+    // Registers the routes of the built-in pages, login and register, the metrics, the profiler and the upload endpoints
+    void InitRoutes_(const char* metricsPath, const char* uploadDir);
+
+    // Registers the commands of the admin console
+    void InitAdmin_(const char* adminSocket);
+
+    // Stops accepting new connections, keep-alive connections are closed after their next response
+    bool Drain_(std::string& out);
+
+    // Accepts new connections again after Drain_
+    bool Undrain_(std::string& out);
+
     // Sets a file descriptor to non-blocking mode
     static int SetFdNonBlock(int fd);
+
+    // Appends the state of every sql connection pool to a metrics scrape
+    static void CollectSqlMetrics_(std::string& out);
+
+    // Appends the state of the user store circuit breaker to a metrics scrape
+    static void CollectBreakerMetrics_(std::string& out);
 };
 
 #endif //SLIM_WEB_SERVER_WEB_SERVER_H
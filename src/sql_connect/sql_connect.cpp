@@ -4,7 +4,19 @@
 
 #include "sql_connect.h"
 
-SqlConnPool::SqlConnPool() : useCount_(0), freeCount_(0) {}
+// "?" placeholders are sent through the binary protocol, 
+// so user input never becomes a part of the SQL text.
+const char* SqlConnPool::STMT_SQL[STMT_COUNT] = {
+    "SELECT password FROM user WHERE username=? LIMIT 1",
+    "SELECT username FROM user WHERE username=? LIMIT 1",
+    "INSERT INTO user(username, password) VALUES(?, ?)",
+};
+
+SqlConnPool::SqlConnPool() : port_(0), MIN_CONN_(0), MAX_CONN_(0), timeoutMs_(-1),
+    useCount_(0), freeCount_(0), pendingCount_(0), isClose_(false),
+    acquireCount_(0), timeoutCount_(0), reconnectCount_(0), waitSumUs_(0), waitHist_{0}, utilHist_{0}, utilSumPermille_(0) {
+    SLIM_LOCK_NAME(mutex_, "sql_pool");
+}
 
 SqlConnPool::~SqlConnPool() {
     ClosePool();
@@ -15,63 +27,435 @@ SqlConnPool* SqlConnPool::Instance() {
     return &instance;
 }
 
-void SqlConnPool::Init(const char* host, int port, const char* user, const char* pwd, const char* dbName, int connSize) {
+void SqlConnPool::Init(const char* host, int port, const char* user, const char* pwd, const char* dbName, 
+                       int connSize, int maxConnSize, int timeoutMs) {
     assert(connSize > 0);
+    host_ = host;
+    port_ = port;
+    user_ = user;
+    pwd_ = pwd;
+    dbName_ = dbName;
+    MIN_CONN_ = connSize;
+    MAX_CONN_ = std::max(connSize, maxConnSize);
+    timeoutMs_ = timeoutMs;
+    isClose_ = false;
+
+    // mysql_library_init is not thread-safe, 
+    // so it must be called before connecting in parallel
+    mysql_library_init(0, nullptr, nullptr);
+    std::vector<std::thread> workers;
     for (int i = 0; i < connSize; ++i) {
-        MYSQL* sql = nullptr;
-        sql = mysql_init(sql);
-        if (!sql) {
-            LOG_ERROR("MySql init error!");
-            assert(sql);
+        // the connect handshakes are network bound, 
+        // open them in parallel to shorten the startup
+        workers.emplace_back([this] {
+            mysql_thread_init();
+            MYSQL* sql = Connect_();
+            mysql_thread_end();
+            if (sql) {
+                std::lock_guard<SlimMutex> locker(mutex_);
+                connQue_.push_back(sql);
+                idleSince_[sql] = Clock::now();
+                freeCount_++;
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    if (freeCount_ < MIN_CONN_) {
+        // the health check thread keeps trying to open the missing connections
+        LOG_ERROR("MySql init error! Only %d of %d connections opened", freeCount_, MIN_CONN_);
+    }
+    if (!healthThread_.joinable()) {
+        healthThread_ = std::thread(&SqlConnPool::HealthCheck_, this);
+    }
+}
+
+MYSQL* SqlConnPool::GetConn() {
+    return GetConn(timeoutMs_);
+}
+
+MYSQL* SqlConnPool::GetConn(int timeoutMs) {
+    Clock::time_point start = Clock::now();
+    Clock::time_point deadline = start + std::chrono::milliseconds(timeoutMs);
+    std::unique_lock<SlimMutex> locker(mutex_);
+    while (!isClose_) {
+        if (!connQue_.empty()) {
+            MYSQL* sqlConn = connQue_.front();
+            connQue_.pop_front();
+            idleSince_.erase(sqlConn);
+            freeCount_--;
+            Acquire_(start);
+            return sqlConn;
+        }
+        // grow the pool up to MAX_CONN_, but do not hammer a database that just refused a connection
+        if (useCount_ + freeCount_ + pendingCount_ < MAX_CONN_ && 
+            Clock::now() - connectFailAt_ > std::chrono::seconds(1)) {
+            // the connect must not outlast the caller's deadline, the client library only takes whole seconds
+            unsigned int connectTimeout = CONNECT_TIMEOUT;
+            if (timeoutMs >= 0) {
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+                if (left <= 0) {
+                    break;
+                }
+                if (left < CONNECT_TIMEOUT * 1000) {
+                    connectTimeout = (left + 999) / 1000;
+                }
+            }
+            pendingCount_++;
+            locker.unlock();
+            MYSQL* sqlConn = Connect_(connectTimeout);
+            locker.lock();
+            pendingCount_--;
+            if (sqlConn) {
+                Acquire_(start);
+                return sqlConn;
+            }
+            connectFailAt_ = Clock::now();
+            continue;
         }
-        sql = mysql_real_connect(sql, host, user, pwd, dbName, port, nullptr, 0);
-        if (!sql) {
-            LOG_ERROR("MySql init error!");
-            assert(sql);
+        if (timeoutMs < 0) {
+            cond_.wait(locker);
+        } else if (cond_.wait_until(locker, deadline) == std::cv_status::timeout && connQue_.empty()) {
+            break;
         }
-        connQue_.push(sql);
-        freeCount_++;
     }
-    MAX_CONN_ = connSize;
-    sem_init(&sem_, 0, MAX_CONN_);
+    timeoutCount_++;
+    SLIM_PROBE2(sql_conn_timeout, this, timeoutMs);
+    locker.unlock();
+    LOG_WARN("SqlConnPool GetConn Timeout!");
+    return nullptr;
+}
 
+void SqlConnPool::FreeConn(MYSQL* sqlConn) {
+    assert(sqlConn);
+    {
+        std::lock_guard<SlimMutex> locker(mutex_);
+        useCount_--;
+        // the pool may have been shrunk by Resize while this connection was in use
+        if (!isClose_ && useCount_ + freeCount_ + pendingCount_ < MAX_CONN_) {
+            // LIFO keeps the hot connections hot 
+            // and lets the cold ones age out at the back of the queue
+            connQue_.push_front(sqlConn);
+            idleSince_[sqlConn] = Clock::now();
+            freeCount_++;
+            sqlConn = nullptr;
+        }
+    }
+    if (sqlConn) {
+        Disconnect_(sqlConn);
+        return;
+    }
+    cond_.notify_one();
 }
 
-MYSQL* SqlConnPool::GetConn() {
-    sem_wait(&sem_);
-    std::lock_guard<std::mutex> locker(mutex_);
-    if (connQue_.empty()) {
+void SqlConnPool::Resize(int connSize, int maxConnSize) {
+    assert(connSize > 0);
+    std::vector<MYSQL*> closing;
+    {
+        std::lock_guard<SlimMutex> locker(mutex_);
+        MIN_CONN_ = connSize;
+        MAX_CONN_ = std::max(connSize, maxConnSize);
+        // the coldest connections are at the back
+        while (!connQue_.empty() && useCount_ + freeCount_ + pendingCount_ > MAX_CONN_) {
+            MYSQL* sqlConn = connQue_.back();
+            connQue_.pop_back();
+            idleSince_.erase(sqlConn);
+            freeCount_--;
+            closing.push_back(sqlConn);
+        }
+    }
+    for (MYSQL* sqlConn : closing) {
+        Disconnect_(sqlConn);
+    }
+    LOG_INFO("SqlConnPool Resized: min %d, max %d, closed %zu", connSize, std::max(connSize, maxConnSize), closing.size());
+    // the health check refills up to the new minimum, waiters may grow up to the new maximum
+    healthCond_.notify_one();
+    cond_.notify_all();
+}
+
+MYSQL_STMT* SqlConnPool::GetStmt(MYSQL* sqlConn, STMT_ID id) {
+    assert(sqlConn && id >= 0 && id < STMT_COUNT);
+    std::vector<MYSQL_STMT*>* stmts = nullptr;
+    {
+        std::lock_guard<SlimMutex> locker(mutex_);
+        auto it = stmtCache_.find(sqlConn);
+        if (it == stmtCache_.end()) {
+            return nullptr;
+        }
+        stmts = &it->second;
+    }
+    // a connection is owned by only one thread until FreeConn, 
+    // so its statements can be modified without holding mutex_
+    if (!(*stmts)[id]) {
+        (*stmts)[id] = PrepareStmt_(sqlConn, id);
+    }
+    return (*stmts)[id];
+}
+
+MYSQL_STMT* SqlConnPool::ExecuteStmt(MYSQL* sqlConn, STMT_ID id, MYSQL_BIND* params) {
+    assert(sqlConn && params);
+    for (int retry = 0; retry < 2; ++retry) {
+        MYSQL_STMT* stmt = GetStmt(sqlConn, id);
+        if (stmt && !mysql_stmt_bind_param(stmt, params) && !mysql_stmt_execute(stmt)) {
+            return stmt;
+        }
+        unsigned int err = stmt ? mysql_stmt_errno(stmt) : mysql_errno(sqlConn);
+        LOG_ERROR("SQL Stmt[%d] Error: %s", id, stmt ? mysql_stmt_error(stmt) : mysql_error(sqlConn));
+        // statements do not survive a reconnect, 
+        // re-prepare them on a fresh session and try once more
+        if (retry > 0 || (err != CR_SERVER_GONE_ERROR && err != CR_SERVER_LOST) || !Reconnect(sqlConn)) {
+            break;
+        }
+    }
+    return nullptr;
+}
+
+bool SqlConnPool::Reconnect(MYSQL* sqlConn) {
+    assert(sqlConn);
+    ResetStmts_(sqlConn);
+    {
+        std::lock_guard<SlimMutex> locker(mutex_);
+        reconnectCount_++;
+    }
+    if (mysql_ping(sqlConn)) {
+        LOG_ERROR("MySql reconnect error: %s", mysql_error(sqlConn));
+        return false;
+    }
+    return true;
+}
+
+MYSQL* SqlConnPool::Connect_(unsigned int connectTimeout) {
+    MYSQL* sql = mysql_init(nullptr);
+    if (!sql) {
+        LOG_ERROR("MySql init error!");
         return nullptr;
     }
-    MYSQL* sqlConn = connQue_.front();
-    connQue_.pop();
-    freeCount_--;
-    useCount_++;
-    return sqlConn;
+    // let mysql_ping transparently reconnect a dropped connection
+    bool reconnect = true;
+    mysql_options(sql, MYSQL_OPT_RECONNECT, &reconnect);
+    mysql_options(sql, MYSQL_OPT_CONNECT_TIMEOUT, &connectTimeout);
+    // the client library only takes whole seconds, so a query may overrun 
+    // the request deadline by less than a second before it is abandoned
+    if (timeoutMs_ > 0) {
+        unsigned int queryTimeout = (timeoutMs_ + 999) / 1000;
+        mysql_options(sql, MYSQL_OPT_READ_TIMEOUT, &queryTimeout);
+        mysql_options(sql, MYSQL_OPT_WRITE_TIMEOUT, &queryTimeout);
+    }
+    if (!mysql_real_connect(sql, host_.c_str(), user_.c_str(), pwd_.c_str(), dbName_.c_str(), port_, nullptr, 0)) {
+        LOG_ERROR("MySql connect error: %s", mysql_error(sql));
+        mysql_close(sql);
+        return nullptr;
+    }
+    // prepare the statements once per connection, 
+    // the server then only has to parse them once
+    std::vector<MYSQL_STMT*> stmts(STMT_COUNT, nullptr);
+    for (int id = 0; id < STMT_COUNT; ++id) {
+        stmts[id] = PrepareStmt_(sql, static_cast<STMT_ID>(id));
+    }
+    std::lock_guard<SlimMutex> locker(mutex_);
+    stmtCache_[sql] = std::move(stmts);
+    return sql;
 }
 
-void SqlConnPool::FreeConn(MYSQL* sqlConn) {
+void SqlConnPool::Disconnect_(MYSQL* sqlConn) {
     assert(sqlConn);
-    std::lock_guard<std::mutex> locker(mutex_);
-    connQue_.push(sqlConn);
-    freeCount_++;
-    useCount_--;
-    sem_post(&sem_);
+    ResetStmts_(sqlConn);
+    {
+        std::lock_guard<SlimMutex> locker(mutex_);
+        stmtCache_.erase(sqlConn);
+    }
+    mysql_close(sqlConn);
+}
+
+void SqlConnPool::Acquire_(Clock::time_point start) {
+    useCount_++;
+    acquireCount_++;
+    uint64_t waitUs = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+    waitSumUs_ += waitUs;
+    int bucket = 0;
+    while (bucket < WAIT_BUCKETS - 1 && (1ULL << bucket) <= waitUs) {
+        bucket++;
+    }
+    waitHist_[bucket]++;
+    SLIM_PROBE3(sql_conn_wait, this, waitUs, useCount_);
+    // a pool shrunk by Resize may have more connections in use than MAX_CONN_, it counts as full
+    int maxConn = std::max(MAX_CONN_, 1);
+    utilHist_[std::min(UTIL_BUCKETS - 1, useCount_ * 10 / maxConn)]++;
+    utilSumPermille_ += std::min(1000, useCount_ * 1000 / maxConn);
+}
+
+void SqlConnPool::HealthCheck_() {
+    mysql_thread_init();
+    std::unique_lock<SlimMutex> locker(mutex_);
+    while (!isClose_) {
+        healthCond_.wait_for(locker, std::chrono::milliseconds(HEALTH_CHECK_MS));
+        if (isClose_) {
+            break;
+        }
+        // take the connections idle for a whole interval out of the queue, 
+        // the ones idle too long above MIN_CONN_ are closed, others are pinged
+        Clock::time_point now = Clock::now();
+        std::vector<std::pair<MYSQL*, Clock::time_point>> idle;
+        std::vector<MYSQL*> expired;
+        int total = useCount_ + freeCount_ + pendingCount_;
+        for (auto it = connQue_.begin(); it != connQue_.end();) {
+            Clock::time_point since = idleSince_[*it];
+            if (now - since >= std::chrono::milliseconds(IDLE_TIMEOUT_MS) && total > MIN_CONN_) {
+                expired.push_back(*it);
+                total--;
+            } else if (now - since >= std::chrono::milliseconds(HEALTH_CHECK_MS)) {
+                idle.emplace_back(*it, since);
+            } else {
+                ++it;
+                continue;
+            }
+            idleSince_.erase(*it);
+            it = connQue_.erase(it);
+            freeCount_--;
+        }
+        int checking = idle.size() + expired.size();
+        pendingCount_ += checking;
+        locker.unlock();
+
+        for (MYSQL* sqlConn : expired) {
+            Disconnect_(sqlConn);
+        }
+        int reconnects = 0;
+        std::vector<std::pair<MYSQL*, Clock::time_point>> alive;
+        for (auto& item : idle) {
+            unsigned long threadId = mysql_thread_id(item.first);
+            if (mysql_ping(item.first) == 0) {
+                if (mysql_thread_id(item.first) != threadId) {
+                    // ping reconnected the session, the old statements are gone
+                    ResetStmts_(item.first);
+                    reconnects++;
+                }
+                alive.push_back(item);
+            } else {
+                LOG_WARN("MySql ping error: %s", mysql_error(item.first));
+                Disconnect_(item.first);
+                reconnects++;
+            }
+        }
+
+        locker.lock();
+        pendingCount_ -= checking;
+        reconnectCount_ += reconnects;
+        std::vector<MYSQL*> surplus;
+        for (auto& item : alive) {
+            // Resize may have lowered MAX_CONN_ during the ping
+            if (useCount_ + freeCount_ + pendingCount_ >= MAX_CONN_) {
+                surplus.push_back(item.first);
+                continue;
+            }
+            connQue_.push_back(item.first);
+            idleSince_[item.first] = item.second;
+            freeCount_++;
+        }
+        // refill the pool up to MIN_CONN_
+        int missing = std::max(0, MIN_CONN_ - (useCount_ + freeCount_ + pendingCount_));
+        pendingCount_ += missing;
+        locker.unlock();
+        for (MYSQL* sqlConn : surplus) {
+            Disconnect_(sqlConn);
+        }
+        std::vector<MYSQL*> opened;
+        for (int i = 0; i < missing; ++i) {
+            MYSQL* sqlConn = Connect_();
+            if (!sqlConn) {
+                break;
+            }
+            opened.push_back(sqlConn);
+        }
+        locker.lock();
+        pendingCount_ -= missing;
+        for (MYSQL* sqlConn : opened) {
+            connQue_.push_back(sqlConn);
+            idleSince_[sqlConn] = Clock::now();
+            freeCount_++;
+        }
+        if (!alive.empty() || !opened.empty()) {
+            cond_.notify_all();
+        }
+    }
+    locker.unlock();
+    mysql_thread_end();
+}
+
+MYSQL_STMT* SqlConnPool::PrepareStmt_(MYSQL* sqlConn, STMT_ID id) {
+    MYSQL_STMT* stmt = mysql_stmt_init(sqlConn);
+    if (!stmt) {
+        LOG_ERROR("MySql stmt init error: %s", mysql_error(sqlConn));
+        return nullptr;
+    }
+    if (mysql_stmt_prepare(stmt, STMT_SQL[id], strlen(STMT_SQL[id]))) {
+        LOG_ERROR("MySql stmt prepare error: %s", mysql_stmt_error(stmt));
+        mysql_stmt_close(stmt);
+        return nullptr;
+    }
+    return stmt;
+}
+
+void SqlConnPool::ResetStmts_(MYSQL* sqlConn) {
+    std::vector<MYSQL_STMT*>* stmts = nullptr;
+    {
+        std::lock_guard<SlimMutex> locker(mutex_);
+        auto it = stmtCache_.find(sqlConn);
+        if (it == stmtCache_.end()) {
+            return;
+        }
+        stmts = &it->second;
+    }
+    for (auto& stmt : *stmts) {
+        if (stmt) {
+            mysql_stmt_close(stmt);
+            stmt = nullptr;
+        }
+    }
 }
 
 int SqlConnPool::GetFreeConnCount() {
-    std::lock_guard<std::mutex> locker(mutex_);
+    std::lock_guard<SlimMutex> locker(mutex_);
     return freeCount_;
 }
 
+SqlConnPool::Stats SqlConnPool::GetStats() {
+    std::lock_guard<SlimMutex> locker(mutex_);
+    Stats stats;
+    stats.minConn = MIN_CONN_;
+    stats.maxConn = MAX_CONN_;
+    stats.useCount = useCount_;
+    stats.freeCount = freeCount_;
+    stats.acquireCount = acquireCount_;
+    stats.timeoutCount = timeoutCount_;
+    stats.reconnectCount = reconnectCount_;
+    stats.waitSumUs = waitSumUs_;
+    std::copy(waitHist_, waitHist_ + WAIT_BUCKETS, stats.waitHist);
+    std::copy(utilHist_, utilHist_ + UTIL_BUCKETS, stats.utilHist);
+    stats.utilSumPermille = utilSumPermille_;
+    return stats;
+}
+
 void SqlConnPool::ClosePool() {
-    std::lock_guard<std::mutex> locker(mutex_);
-    while (!connQue_.empty()) {
-        auto sqlConn = connQue_.front();
-        connQue_.pop();
-        mysql_close(sqlConn);
-    }
-    useCount_ = 0;
-    freeCount_ = 0;
-    mysql_library_end();
-}
\ No newline at end of file
+    {
+        std::lock_guard<SlimMutex> locker(mutex_);
+        isClose_ = true;
+    }
+    healthCond_.notify_all();
+    cond_.notify_all();
+    if (healthThread_.joinable()) {
+        healthThread_.join();
+    }
+    std::deque<MYSQL*> conns;
+    {
+        std::lock_guard<SlimMutex> locker(mutex_);
+        conns.swap(connQue_);
+        idleSince_.clear();
+        freeCount_ = 0;
+    }
+    // connections still in use are closed by FreeConn
+    for (MYSQL* sqlConn : conns) {
+        Disconnect_(sqlConn);
+    }
+}
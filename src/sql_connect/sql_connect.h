@@ -6,55 +6,159 @@
 #define SLIM_WEB_SERVER_SQL_CONNECT_H
 
 #include <string>
-#include <queue>
+#include <deque>
+#include <vector>
+#include <unordered_map>
 #include <mutex>
 #include <thread>
-#include <semaphore.h>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include <condition_variable>
 #include <mysql/mysql.h>
+#include <mysql/errmsg.h>
 #include "../log/log.h"
+#include "../probe/probe.h"
+#include "../lock_profiler/lock_profiler.h"
 
 // SQL connection pool class for managing MySQL connections.
+// The pool keeps between minConn and maxConn connections,
+// pings idle connections in a background thread and replaces the dead ones.
 class SqlConnPool {
 public:
-    // Singleton instance access method.
+    // Enumerates the prepared statements cached for every pooled connection.
+    enum STMT_ID {
+        LOGIN_SELECT = 0,
+        REGISTER_SELECT,
+        USER_INSERT,
+        STMT_COUNT,
+    };
+
+    static const int WAIT_BUCKETS = 24;     // Wait time histogram buckets, bucket i counts waits below 2^i us.
+    static const int UTIL_BUCKETS = 11;     // Utilization histogram buckets, bucket i counts samples of i*10% busy.
+
+    // Snapshot of the pool state and its histograms.
+    struct Stats {
+        int minConn;                        // Minimum number of connections.
+        int maxConn;                        // Maximum number of connections.
+        int useCount;                       // Connections currently in use.
+        int freeCount;                      // Connections currently idle in the pool.
+        uint64_t acquireCount;              // Successful GetConn calls.
+        uint64_t timeoutCount;              // GetConn calls that timed out.
+        uint64_t reconnectCount;            // Connections replaced or reconnected after a failure.
+        uint64_t waitSumUs;                 // Sum of the GetConn wait time in microseconds.
+        uint64_t waitHist[WAIT_BUCKETS];    // Log2 histogram of the GetConn wait time.
+        uint64_t utilHist[UTIL_BUCKETS];    // Histogram of the utilization sampled on each GetConn.
+        uint64_t utilSumPermille;           // Sum of the sampled utilization in 1/1000.
+    };
+
+    // Default pool access method, the primary of shard 0 when a SqlTopology is used.
     static SqlConnPool* Instance();
 
-    // Initializes the connection pool with database parameters and the maximum number of connections.
-    void Init(const char* host, int port, 
-              const char* user, const char* pwd, 
-              const char* dbName, int connSize = 10);
-    
-    // Retrieves a connection from the pool, blocking if none are available.
+    // Additional pools (replicas, other shards) are created by SqlTopology.
+    SqlConnPool();
+
+    // Destructor cleans up connections.
+    ~SqlConnPool();
+
+    // Initializes the connection pool with database parameters, the minimum and maximum number of connections
+    // (maxConnSize 0 means a fixed size pool) and the default GetConn timeout, also used as the query timeout.
+    void Init(const char* host, int port,
+              const char* user, const char* pwd,
+              const char* dbName, int connSize = 10,
+              int maxConnSize = 0, int timeoutMs = 3000);
+
+    // Retrieves a connection from the pool, waiting up to the default timeout. Returns nullptr on timeout.
     MYSQL* GetConn();
 
+    // Retrieves a connection from the pool, waiting up to timeoutMs (-1 means forever). Returns nullptr on timeout.
+    MYSQL* GetConn(int timeoutMs);
+
     // Returns a connection to the pool.
     void FreeConn(MYSQL* sqlConn);
 
+    // Returns the cached prepared statement of a connection, preparing it on first use.
+    MYSQL_STMT* GetStmt(MYSQL* sqlConn, STMT_ID id);
+
+    // Binds params to a cached statement and executes it, re-preparing once after a reconnect.
+    MYSQL_STMT* ExecuteStmt(MYSQL* sqlConn, STMT_ID id, MYSQL_BIND* params);
+
+    // Pings the server (reconnecting if needed) and drops the stale statements of a connection.
+    bool Reconnect(MYSQL* sqlConn);
+
+    // Changes the minimum and maximum number of connections at runtime (maxConnSize 0 means a fixed size pool).
+    // Free connections above the maximum are closed at once, busy ones when they are returned.
+    void Resize(int connSize, int maxConnSize = 0);
+
     // Returns the number of free connections currently available in the pool.
     int GetFreeConnCount();
 
-    // Closes all connections and destroys the pool.
+    // Returns a snapshot of the pool state and histograms.
+    Stats GetStats();
+
+    // Closes all connections of the pool, mysql_library_end is left to the owner of the last pool.
     void ClosePool();
 
 private:
+    using Clock = std::chrono::steady_clock;
+
+    static const int HEALTH_CHECK_MS = 5000;    // Interval of the health check thread.
+    static const int IDLE_TIMEOUT_MS = 60000;   // Connections above minConn idle longer than this are closed.
+    static const unsigned int CONNECT_TIMEOUT = 3;  // Longest connect in seconds.
+
+    std::string host_;              // Database host.
+    int port_;                      // Database port.
+    std::string user_;              // Database user.
+    std::string pwd_;               // Database password.
+    std::string dbName_;            // Database name.
+    int MIN_CONN_;                  // Minimum number of connections kept open.
     int MAX_CONN_;                  // Maximum number of connections allowed in the pool.
+    int timeoutMs_;                 // Default GetConn timeout in milliseconds, rounded up to seconds for queries.
     int useCount_;                  // Current count of connections in use.
     int freeCount_;                 // Current count of free connections available.
-    std::queue<MYSQL*> connQue_;    // Queue storing available connections.
-    std::mutex mutex_;              // Mutex for synchronizing access to the connection queue.
-    sem_t sem_;                     // Semaphore for managing available connections.
+    int pendingCount_;              // Connections being opened or health checked outside the lock.
+    bool isClose_;                  // Flag to stop the health check thread.
+    Clock::time_point connectFailAt_;   // Time of the last failed connect, GetConn does not retry within a second.
+    std::deque<MYSQL*> connQue_;    // Free connections, the most recently used one at the front.
+    SlimMutex mutex_;               // Mutex for synchronizing access to the connection queue.
+    SlimCondition cond_;            // Signaled when a connection is returned to the pool.
+    SlimCondition healthCond_;      // Wakes up the health check thread when closing.
+    std::thread healthThread_;      // Thread pinging idle connections and keeping minConn alive.
+    std::unordered_map<MYSQL*, std::vector<MYSQL_STMT*>> stmtCache_;  // Prepared statements of each connection.
+    std::unordered_map<MYSQL*, Clock::time_point> idleSince_;          // Time each free connection was returned.
+    static const char* STMT_SQL[STMT_COUNT];                          // SQL text of each cached statement.
 
-    // Private constructor for singleton pattern.
-    SqlConnPool();  
-
-    // Destructor cleans up connections.
-    ~SqlConnPool();
+    uint64_t acquireCount_;             // Successful GetConn calls.
+    uint64_t timeoutCount_;             // GetConn calls that timed out.
+    uint64_t reconnectCount_;           // Connections replaced or reconnected after a failure.
+    uint64_t waitSumUs_;                // Sum of the GetConn wait time in microseconds.
+    uint64_t waitHist_[WAIT_BUCKETS];   // Log2 histogram of the GetConn wait time.
+    uint64_t utilHist_[UTIL_BUCKETS];   // Histogram of the utilization sampled on each GetConn.
+    uint64_t utilSumPermille_;          // Sum of the sampled utilization in 1/1000.
 
     // Deleted copy constructor.
     SqlConnPool(const SqlConnPool& other) = delete;
 
     // Deleted assignment operator.
     SqlConnPool& operator=(const SqlConnPool& other) = delete;
+
+    // Opens a new connection and prepares its statements within connectTimeout seconds, returns nullptr on failure.
+    MYSQL* Connect_(unsigned int connectTimeout = CONNECT_TIMEOUT);
+
+    // Closes a connection and its statements.
+    void Disconnect_(MYSQL* sqlConn);
+
+    // Hands a connection to the caller and records the wait time. Requires mutex_.
+    void Acquire_(Clock::time_point start);
+
+    // Pings idle connections, replaces the dead ones and shrinks or refills the pool.
+    void HealthCheck_();
+
+    // Prepares the statement id on the given connection, returns nullptr on failure.
+    static MYSQL_STMT* PrepareStmt_(MYSQL* sqlConn, STMT_ID id);
+
+    // Closes every cached statement of a connection, they will be re-prepared lazily.
+    void ResetStmts_(MYSQL* sqlConn);
 };
 
 #endif //SLIM_WEB_SERVER_SQL_CONNECT_H
@@ -10,7 +10,7 @@
 // RAII wrapper class for automatic MySQL connection management.
 class SqlConnRAII {
 public:
-    // Constructor acquires a connection from the pool and stores it.
+    // Constructor acquires a connection from the pool and stores it, *sqlCoon is nullptr if GetConn timed out.
     SqlConnRAII(MYSQL** sqlCoon, SqlConnPool* connPool) {
         assert(connPool);
         *sqlCoon = connPool->GetConn();
@@ -18,6 +18,14 @@ public:
         connPool_ = connPool;
     }
 
+    // Constructor acquires a connection waiting at most timeoutMs, *sqlCoon is nullptr on timeout.
+    SqlConnRAII(MYSQL** sqlCoon, SqlConnPool* connPool, int timeoutMs) {
+        assert(connPool);
+        *sqlCoon = connPool->GetConn(timeoutMs);
+        sqlCoon_ = *sqlCoon;
+        connPool_ = connPool;
+    }
+
     // Destructor releases the connection back to the pool.
     ~SqlConnRAII() {
         if (sqlCoon_ && connPool_) {
@@ -0,0 +1,142 @@
+//
+// Created by pyq on 10/19/26.
+//
+#include "sql_topology.h"
+
+SqlTopology* SqlTopology::Instance() {
+    static SqlTopology instance;
+    return &instance;
+}
+
+bool SqlTopology::Init(const char* topology, const char* user, const char* pwd, const char* dbName,
+                       int connSize, int maxConnSize) {
+    assert(topology && shards_.empty());
+    std::string config(topology);
+    size_t shardStart = 0;
+    while (shardStart <= config.size()) {
+        size_t shardEnd = config.find(';', shardStart);
+        if (shardEnd == std::string::npos) {
+            shardEnd = config.size();
+        }
+        Shard shard = {nullptr, {}, std::unique_ptr<std::atomic<size_t>>(new std::atomic<size_t>(0))};
+        size_t nodeStart = shardStart;
+        while (nodeStart < shardEnd) {
+            size_t nodeEnd = config.find(',', nodeStart);
+            if (nodeEnd == std::string::npos || nodeEnd > shardEnd) {
+                nodeEnd = shardEnd;
+            }
+            // host:port, the port defaults to 3306
+            std::string node = config.substr(nodeStart, nodeEnd - nodeStart);
+            std::string host = node;
+            int port = 3306;
+            size_t colon = node.rfind(':');
+            if (colon != std::string::npos) {
+                host = node.substr(0, colon);
+                port = atoi(node.c_str() + colon + 1);
+            }
+            if (host.empty() || port <= 0) {
+                LOG_ERROR("SqlTopology Node %s Error!", node.c_str());
+                return false;
+            }
+            // the first primary is the default pool for code that is not shard aware
+            SqlConnPool* pool = SqlConnPool::Instance();
+            if (!nodes_.empty()) {
+                pools_.emplace_back(new SqlConnPool());
+                pool = pools_.back().get();
+            }
+            pool->Init(host.c_str(), port, user, pwd, dbName, connSize, maxConnSize);
+            bool isPrimary = !shard.primary;
+            if (isPrimary) {
+                shard.primary = pool;
+            } else {
+                shard.replicas.push_back(pool);
+            }
+            char name[64];
+            if (isPrimary) {
+                snprintf(name, sizeof(name), "shard%d-primary", (int)shards_.size());
+            } else {
+                snprintf(name, sizeof(name), "shard%d-replica%d", (int)shards_.size(), (int)shard.replicas.size() - 1);
+            }
+            nodes_.emplace_back(name, pool);
+            LOG_INFO("SqlTopology Node %s: %s:%d", name, host.c_str(), port);
+            nodeStart = nodeEnd + 1;
+        }
+        if (!shard.primary) {
+            LOG_ERROR("SqlTopology Shard %d Has No Node!", (int)shards_.size());
+            return false;
+        }
+        shards_.push_back(std::move(shard));
+        shardStart = shardEnd + 1;
+    }
+    return true;
+}
+
+size_t SqlTopology::ShardCount() const {
+    return shards_.size();
+}
+
+size_t SqlTopology::GetShard(const std::string& name) const {
+    assert(!shards_.empty());
+    return Hash_(name) % shards_.size();
+}
+
+SqlConnPool* SqlTopology::GetPrimary(size_t shard) {
+    assert(shard < shards_.size());
+    return shards_[shard].primary;
+}
+
+SqlConnPool* SqlTopology::GetReader(size_t shard, const std::string& name) {
+    assert(shard < shards_.size());
+    Shard& s = shards_[shard];
+    if (s.replicas.empty() || IsRecentWrite_(name)) {
+        return s.primary;
+    }
+    return s.replicas[(*s.next)++ % s.replicas.size()];
+}
+
+void SqlTopology::OnWrite(const std::string& name) {
+    bool hasReplica = false;
+    for (const Shard& shard : shards_) {
+        hasReplica = hasReplica || !shard.replicas.empty();
+    }
+    if (!hasReplica) {
+        return;
+    }
+    auto expires = std::chrono::steady_clock::now() + std::chrono::milliseconds(RYW_MS);
+    std::lock_guard<std::mutex> locker(mutex_);
+    recentWrites_[name] = expires;
+    writeOrder_.emplace_back(expires, name);
+}
+
+void SqlTopology::ForEachPool(const std::function<void(const std::string&, SqlConnPool*)>& func) {
+    for (auto& node : nodes_) {
+        func(node.first, node.second);
+    }
+}
+
+void SqlTopology::Close() {
+    for (auto& node : nodes_) {
+        node.second->ClosePool();
+    }
+    mysql_library_end();
+}
+
+bool SqlTopology::IsRecentWrite_(const std::string& name) {
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> locker(mutex_);
+    // drop the expired writes in time order, 
+    // a name written again keeps the later expiry in recentWrites_
+    while (!writeOrder_.empty() && writeOrder_.front().first <= now) {
+        auto it = recentWrites_.find(writeOrder_.front().second);
+        if (it != recentWrites_.end() && it->second <= now) {
+            recentWrites_.erase(it);
+        }
+        writeOrder_.pop_front();
+    }
+    return recentWrites_.count(name) > 0;
+}
+
+uint64_t SqlTopology::Hash_(const std::string& name) {
+    // unlike std::hash its value is fixed across builds, so every server maps a user to the same shard
+    return Hash::Fnv1a64(name.data(), name.size());
+}
@@ -0,0 +1,88 @@
+//
+// Created by pyq on 10/19/26.
+//
+#pragma once
+#ifndef SLIM_WEB_SERVER_SQL_TOPOLOGY_H
+#define SLIM_WEB_SERVER_SQL_TOPOLOGY_H
+
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include "sql_connect.h"
+#include "../hash/hash.h"
+
+// Database topology of the user table: the table is sharded by a hash of the user name, 
+// and every shard has one primary pool and optional read-replica pools.
+class SqlTopology {
+public:
+    // Singleton instance access method.
+    static SqlTopology* Instance();
+
+    // Parses the topology and initializes a pool for every node.
+    // Shards are separated by ';' and the nodes of a shard by ',', the first node of a shard is its primary,
+    // e.g. "localhost:3306" or "127.0.0.1:3306,127.0.0.1:3307;127.0.0.1:3316,127.0.0.1:3317".
+    bool Init(const char* topology, const char* user, const char* pwd, const char* dbName,
+              int connSize, int maxConnSize = 0);
+
+    // Returns the number of shards.
+    size_t ShardCount() const;
+
+    // Returns the shard of a user name.
+    size_t GetShard(const std::string& name) const;
+
+    // Returns the primary pool of a shard, used by writes.
+    SqlConnPool* GetPrimary(size_t shard);
+
+    // Returns a replica pool of a shard (round robin), or the primary 
+    // if the shard has no replica or the user name has been written recently (read-your-writes).
+    SqlConnPool* GetReader(size_t shard, const std::string& name);
+
+    // Records a write of the user name, its reads go to the primary for the next RYW_MS.
+    void OnWrite(const std::string& name);
+
+    // Calls func with the name and pool of every node.
+    void ForEachPool(const std::function<void(const std::string&, SqlConnPool*)>& func);
+
+    // Closes every pool.
+    void Close();
+
+private:
+    static const int RYW_MS = 5000;     // Read-your-writes window, should exceed the replication lag.
+
+    // A shard of the user table.
+    struct Shard {
+        SqlConnPool* primary;                               // Primary pool.
+        std::vector<SqlConnPool*> replicas;                 // Read-replica pools.
+        std::unique_ptr<std::atomic<size_t>> next;          // Round robin counter of the replicas.
+    };
+
+    std::vector<Shard> shards_;                             // Shards, indexed by GetShard.
+    std::vector<std::unique_ptr<SqlConnPool>> pools_;       // Pools owned by the topology (all but SqlConnPool::Instance).
+    std::vector<std::pair<std::string, SqlConnPool*>> nodes_;   // Node name and pool of every node.
+    std::mutex mutex_;                                      // Protects the recent writes.
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point> recentWrites_;  // Expiry of recent writes.
+    std::deque<std::pair<std::chrono::steady_clock::time_point, std::string>> writeOrder_;  // Recent writes in time order.
+
+    SqlTopology() = default;
+
+    ~SqlTopology() = default;
+
+    SqlTopology(const SqlTopology& other) = delete;
+
+    SqlTopology& operator=(const SqlTopology& other) = delete;
+
+    // Returns true if the user name has been written within RYW_MS.
+    bool IsRecentWrite_(const std::string& name);
+
+    // Stable hash of the user name, the shard of a user must never change between runs.
+    static uint64_t Hash_(const std::string& name);
+};
+
+#endif //SLIM_WEB_SERVER_SQL_TOPOLOGY_H
@@ -6,40 +6,81 @@
 ThreadPool::ThreadPool(size_t threadNum) : pool_(std::make_shared<Pool>()) {
     assert(threadNum > 0);
     pool_->isClosed = false;
-    for (size_t i = 0; i < threadNum; ++i) {
-        workers.emplace_back([pool = pool_] {
-            std::unique_lock<std::mutex> locker(pool->mutex_);
-            while (true) {
-                if (!pool->tasks.empty()) {
-                    auto task = std::move(pool->tasks.front());
-                    pool->tasks.pop();
-                    locker.unlock();
-                    task();
-                    locker.lock();
-                } else if (pool->isClosed) {
-                    break;
-                } else {
-                    pool->cv.wait(locker);
-                }
-            }
-        });
-    }
+    pool_->threadNum = 0;
+    pool_->retireNum = 0;
+    SLIM_LOCK_NAME(pool_->mutex_, "thread_pool");
+    Resize(threadNum);
 }
 
 ThreadPool::~ThreadPool() {
     Close();
 }
 
-void ThreadPool::Close() {
-    {
-        std::lock_guard<std::mutex> locker(pool_->mutex_);
-        pool_->isClosed = true;
-    }
-    pool_->cv.notify_all();
-    for (std::thread& worker : workers) {
-        if (worker.joinable()) {
-            worker.join();
+void ThreadPool::Work_(std::shared_ptr<Pool> pool) {
+    std::unique_lock<SlimMutex> locker(pool->mutex_);
+    while (true) {
+        if (pool->retireNum > 0) {
+            pool->retireNum--;
+            break;
+        } else if (!pool->tasks.empty()) {
+            Task task = std::move(pool->tasks.front());
+            pool->tasks.pop();
+            Metrics::Instance()->Set(Metrics::POOL_QUEUE_DEPTH, pool->tasks.size());
+            locker.unlock();
+            Metrics::Instance()->Record(Metrics::POOL_WAIT, std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - task.addedAt).count());
+            Metrics::Instance()->Add(Metrics::POOL_TASKS);
+            task.func();
+            locker.lock();
+        } else if (pool->isClosed) {
+            break;
+        } else {
+            pool->cv.wait(locker);
         }
     }
-    workers.clear();
+    pool->threadNum--;
+    pool->exitCv.notify_all();
+}
+
+void ThreadPool::Resize(size_t threadNum) {
+    assert(threadNum > 0);
+    std::lock_guard<SlimMutex> locker(pool_->mutex_);
+    if (pool_->isClosed) {
+        return;
+    }
+    size_t alive = pool_->threadNum - pool_->retireNum;
+    if (threadNum < alive) {
+        // idle workers exit at once, busy ones after their current task
+        pool_->retireNum += alive - threadNum;
+        pool_->cv.notify_all();
+        return;
+    }
+    // take back pending retirements before starting new threads
+    size_t add = threadNum - alive;
+    size_t keep = std::min(add, pool_->retireNum);
+    pool_->retireNum -= keep;
+    add -= keep;
+    for (size_t i = 0; i < add; ++i) {
+        std::thread(&ThreadPool::Work_, pool_).detach();
+        pool_->threadNum++;
+    }
+}
+
+size_t ThreadPool::Size() {
+    std::lock_guard<SlimMutex> locker(pool_->mutex_);
+    return pool_->threadNum - pool_->retireNum;
+}
+
+size_t ThreadPool::QueueSize() {
+    std::lock_guard<SlimMutex> locker(pool_->mutex_);
+    return pool_->tasks.size();
+}
+
+void ThreadPool::Close() {
+    std::unique_lock<SlimMutex> locker(pool_->mutex_);
+    pool_->isClosed = true;
+    pool_->cv.notify_all();
+    // workers drain the queue before exiting
+    std::shared_ptr<Pool> pool = pool_;
+    pool_->exitCv.wait(locker, [pool] { return pool->threadNum == 0; });
 }
\ No newline at end of file
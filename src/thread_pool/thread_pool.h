@@ -13,6 +13,9 @@
 #include <cassert>
 #include <vector>
 #include <atomic>
+#include <chrono>
+#include "../metrics/metrics.h"
+#include "../lock_profiler/lock_profiler.h"
 
 // A class that manages a pool of worker threads that can execute tasks concurrently.
 class ThreadPool {
@@ -27,24 +30,46 @@ public:
     template<class T>
     void AddTask(T&& task){
         {
-            std::lock_guard<std::mutex> locker(pool_->mutex_);
-            pool_->tasks.emplace(std::forward<T>(task));
+            std::lock_guard<SlimMutex> locker(pool_->mutex_);
+            pool_->tasks.emplace(Task{std::forward<T>(task), std::chrono::steady_clock::now()});
+            Metrics::Instance()->Set(Metrics::POOL_QUEUE_DEPTH, pool_->tasks.size());
         }
         pool_->cv.notify_one();
     }
 
-    // Closes the thread pool and joins all threads.
+    // Grows or shrinks the pool to threadNum workers without blocking, 
+    // a retired worker exits once it finishes its current task.
+    void Resize(size_t threadNum);
+
+    // Returns the number of workers, not counting the ones asked to retire.
+    size_t Size();
+
+    // Returns the number of tasks waiting in the queue.
+    size_t QueueSize();
+
+    // Closes the thread pool and waits for all threads to exit.
     void Close();
 private:
+    // A queued task and the time it was added, to measure the queue wait.
+    struct Task {
+        std::function<void()> func;
+        std::chrono::steady_clock::time_point addedAt;
+    };
+
      // Nested class that holds the queue of tasks and synchronization primitives.
     struct Pool {
-        std::mutex mutex_;                          // Mutex to protect access to the task queue.
-        std::condition_variable cv;                 // Condition variable for task synchronization.
-        std::queue<std::function<void()>> tasks;    // Queue of tasks.
+        SlimMutex mutex_;                           // Mutex to protect access to the task queue.
+        SlimCondition cv;                           // Condition variable for task synchronization.
+        SlimCondition exitCv;                       // Signaled when a worker exits.
+        std::queue<Task> tasks;                     // Queue of tasks.
         bool isClosed;                              // Flag to indicate if the pool is shutting down.
+        size_t threadNum;                           // Running workers, including the ones asked to retire.
+        size_t retireNum;                           // Workers asked to exit by Resize.
     };
     std::shared_ptr<Pool> pool_;         // Shared pointer to the pool to ensure it lives as long as any thread needs it.
-    std::vector<std::thread> workers;    // Vector of worker threads.
+
+    // Body of a worker thread, workers are detached and hold their own reference to the pool.
+    static void Work_(std::shared_ptr<Pool> pool);
 };
 
 #endif //SLIM_WEB_SERVER_THREAD_POOL_H
\ No newline at end of file
@@ -68,9 +68,12 @@ void Timer::Tick() {
         if (std::chrono::duration_cast<Milliseconds>(node.expires - HighResolutionClock::now()).count() > 0) {
             break;
         }
+        SLIM_PROBE1(timer_expire, node.id);
         node.cb();
         Pop();
+        Metrics::Instance()->Add(Metrics::TIMER_EXPIRED);
     }
+    Metrics::Instance()->Set(Metrics::TIMER_COUNT, heap_.size());
 }
 
 int Timer::GetNextTick() {
@@ -15,6 +15,8 @@
 #include <arpa/inet.h>
 #include <time.h>
 #include "../log/log.h"
+#include "../metrics/metrics.h"
+#include "../probe/probe.h"
 
 using TimeoutCallBack = std::function<void()>;
 using HighResolutionClock = std::chrono::high_resolution_clock;
@@ -0,0 +1,130 @@
+//
+// Created by pyq on 10/19/26.
+//
+#include "transport.h"
+#include <algorithm>
+
+SocketTransport::SocketTransport() : fd_(-1) {}
+
+void SocketTransport::Reset(int fd) {
+    fd_ = fd;
+}
+
+ssize_t SocketTransport::Readv(const iovec* iov, int iovCnt) {
+    return readv(fd_, iov, iovCnt);
+}
+
+ssize_t SocketTransport::Writev(const iovec* iov, int iovCnt) {
+    return writev(fd_, iov, iovCnt);
+}
+
+void SocketTransport::Close() {
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+}
+
+MemoryTransport::MemoryTransport() :
+        inputPos_(0), isShutdown_(false), written_(0), maxRead_(0), maxWrite_(0),
+        capacity_(0), isDiscard_(false), isClosed_(false) {}
+
+void MemoryTransport::Feed(const char* data, size_t len) {
+    // drop the consumed prefix once everything fed so far has been read
+    if (inputPos_ == input_.size()) {
+        input_.clear();
+        inputPos_ = 0;
+    }
+    input_.append(data, len);
+}
+
+void MemoryTransport::Feed(const std::string& data) {
+    Feed(data.data(), data.size());
+}
+
+void MemoryTransport::Shutdown() {
+    isShutdown_ = true;
+}
+
+void MemoryTransport::SetChunk(size_t maxRead, size_t maxWrite) {
+    maxRead_ = maxRead;
+    maxWrite_ = maxWrite;
+}
+
+void MemoryTransport::SetCapacity(size_t capacity) {
+    capacity_ = capacity;
+}
+
+void MemoryTransport::SetDiscard(bool discard) {
+    isDiscard_ = discard;
+}
+
+std::string MemoryTransport::TakeOutput() {
+    std::string output;
+    output.swap(output_);
+    return output;
+}
+
+uint64_t MemoryTransport::WrittenBytes() const {
+    return written_;
+}
+
+bool MemoryTransport::IsClosed() const {
+    return isClosed_;
+}
+
+ssize_t MemoryTransport::Readv(const iovec* iov, int iovCnt) {
+    if (isClosed_) {
+        errno = EBADF;
+        return -1;
+    }
+    size_t available = input_.size() - inputPos_;
+    if (available == 0) {
+        if (isShutdown_) {
+            return 0;
+        }
+        errno = EAGAIN;
+        return -1;
+    }
+    size_t limit = maxRead_ ? std::min(available, maxRead_) : available;
+    size_t total = 0;
+    for (int i = 0; i < iovCnt && total < limit; ++i) {
+        size_t len = std::min(iov[i].iov_len, limit - total);
+        input_.copy((char*)iov[i].iov_base, len, inputPos_ + total);
+        total += len;
+    }
+    inputPos_ += total;
+    return total;
+}
+
+ssize_t MemoryTransport::Writev(const iovec* iov, int iovCnt) {
+    if (isClosed_) {
+        errno = EPIPE;
+        return -1;
+    }
+    size_t limit = SIZE_MAX;
+    if (capacity_) {
+        if (output_.size() >= capacity_) {
+            errno = EAGAIN;
+            return -1;
+        }
+        limit = capacity_ - output_.size();
+    }
+    if (maxWrite_) {
+        limit = std::min(limit, maxWrite_);
+    }
+    size_t total = 0;
+    for (int i = 0; i < iovCnt && total < limit; ++i) {
+        size_t len = std::min(iov[i].iov_len, limit - total);
+        if (!isDiscard_) {
+            output_.append((const char*)iov[i].iov_base, len);
+        }
+        total += len;
+    }
+    written_ += total;
+    return total;
+}
+
+void MemoryTransport::Close() {
+    isClosed_ = true;
+}
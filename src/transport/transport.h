@@ -0,0 +1,101 @@
+//
+// Created by pyq on 10/19/26.
+//
+#pragma once
+#ifndef SLIM_WEB_SERVER_TRANSPORT_H
+#define SLIM_WEB_SERVER_TRANSPORT_H
+
+#include <string>
+#include <cerrno>
+#include <cstdint>
+#include <unistd.h>
+#include <sys/uio.h>
+
+// Byte stream under an HttpConn. Reads and writes follow readv(2) and writev(2):
+// they return -1 and set errno, EAGAIN meaning nothing can be transferred right now.
+class Transport {
+public:
+    virtual ~Transport() = default;
+
+    // Scatter read into iov, returns the bytes read, 0 at the end of the stream or -1 on error.
+    virtual ssize_t Readv(const iovec* iov, int iovCnt) = 0;
+
+    // Gather write from iov, returns the bytes written or -1 on error.
+    virtual ssize_t Writev(const iovec* iov, int iovCnt) = 0;
+
+    // Closes the stream.
+    virtual void Close() = 0;
+};
+
+// Transport over a non blocking socket.
+class SocketTransport : public Transport {
+public:
+    SocketTransport();
+
+    // Uses fd, which is closed by Close.
+    void Reset(int fd);
+
+    ssize_t Readv(const iovec* iov, int iovCnt) override;
+
+    ssize_t Writev(const iovec* iov, int iovCnt) override;
+
+    void Close() override;
+
+private:
+    int fd_;    // Socket, -1 once closed.
+};
+
+// In-memory pipe for driving an HttpConn without the kernel, e.g. in benchmarks.
+// The peer feeds requests and takes the responses, reads and writes can be cut into small pieces
+// to exercise partial reads and short writes. Not thread safe, one thread drives both ends.
+class MemoryTransport : public Transport {
+public:
+    MemoryTransport();
+
+    // Queues bytes for the server to read.
+    void Feed(const char* data, size_t len);
+
+    // Queues a string for the server to read.
+    void Feed(const std::string& data);
+
+    // Marks the end of the input, reads return 0 once it is consumed.
+    void Shutdown();
+
+    // Limits every read and write to maxRead and maxWrite bytes, 0 means no limit.
+    void SetChunk(size_t maxRead, size_t maxWrite);
+
+    // Writes fail with EAGAIN while capacity bytes of output are not taken, 0 means no limit.
+    void SetCapacity(size_t capacity);
+
+    // Counts the written bytes without keeping them.
+    void SetDiscard(bool discard);
+
+    // Returns and clears the bytes written by the server.
+    std::string TakeOutput();
+
+    // Returns the bytes written by the server since construction.
+    uint64_t WrittenBytes() const;
+
+    // Returns true after Close.
+    bool IsClosed() const;
+
+    ssize_t Readv(const iovec* iov, int iovCnt) override;
+
+    ssize_t Writev(const iovec* iov, int iovCnt) override;
+
+    void Close() override;
+
+private:
+    std::string input_;     // Bytes fed by the peer.
+    size_t inputPos_;       // Bytes of input_ already read.
+    bool isShutdown_;       // No more input will be fed.
+    std::string output_;    // Bytes written and not yet taken.
+    uint64_t written_;      // Bytes written since construction.
+    size_t maxRead_;        // Largest read, 0 means no limit.
+    size_t maxWrite_;       // Largest write, 0 means no limit.
+    size_t capacity_;       // Output kept before writes fail, 0 means no limit.
+    bool isDiscard_;        // Written bytes are only counted.
+    bool isClosed_;         // Close was called.
+};
+
+#endif //SLIM_WEB_SERVER_TRANSPORT_H
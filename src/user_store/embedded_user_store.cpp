@@ -0,0 +1,302 @@
+//
+// Created by pyq on 10/19/26.
+//
+#include "embedded_user_store.h"
+
+EmbeddedUserStore::EmbeddedUserStore(const std::string& dataDir, int snapshotIntervalMs) :
+    dataDir_(dataDir), logPath_(dataDir + "/users.log"), snapPath_(dataDir + "/users.snap"),
+    snapshotIntervalMs_(snapshotIntervalMs), logFd_(-1), logRecords_(0), logDirty_(false), isClose_(false),
+    slots_(INIT_SLOTS), size_(0) {
+    assert(snapshotIntervalMs > 0);
+    // anyone can register, a fixed hash would let names be chosen to pile up in one probe run
+    std::random_device rd;
+    seed_ = (static_cast<uint64_t>(rd()) << 32) | rd();
+}
+
+EmbeddedUserStore::~EmbeddedUserStore() {
+    {
+        std::lock_guard<std::mutex> locker(syncMutex_);
+        isClose_ = true;
+    }
+    syncCond_.notify_all();
+    if (syncThread_.joinable()) {
+        syncThread_.join();
+    }
+    if (logFd_ >= 0) {
+        if (logRecords_ > 0) {
+            Snapshot();
+        }
+        fdatasync(logFd_);
+        close(logFd_);
+    }
+}
+
+bool EmbeddedUserStore::Open() {
+    mkdir(dataDir_.c_str(), 0755);
+    if (Load_(snapPath_, true) < 0) {
+        return false;
+    }
+    off_t logEnd = Load_(logPath_, false);
+    if (logEnd < 0) {
+        return false;
+    }
+    logFd_ = open(logPath_.c_str(), O_WRONLY | O_CREAT, 0644);
+    if (logFd_ < 0) {
+        LOG_ERROR("Open UserStore Log %s Error!", logPath_.c_str());
+        return false;
+    }
+    // drop a torn record left by a crash in the middle of a write
+    if (ftruncate(logFd_, logEnd) < 0 || lseek(logFd_, logEnd, SEEK_SET) < 0) {
+        LOG_ERROR("Truncate UserStore Log %s Error!", logPath_.c_str());
+        return false;
+    }
+    LOG_INFO("Embedded UserStore Loaded %d Users, %d Log Records", (int)size_, (int)logRecords_);
+    syncThread_ = std::thread(&EmbeddedUserStore::SyncLoop_, this);
+    return true;
+}
+
+int EmbeddedUserStore::Login(const std::string& name, const std::string& pwd, const Deadline& deadline) {
+    std::shared_lock<std::shared_timed_mutex> locker(mutex_);
+    const Slot& slot = slots_[Find_(name, Hash_(name))];
+    if (slot.hash == 0) {
+        return NOT_FOUND;
+    }
+    return slot.pwd == pwd ? OK : WRONG_PASSWORD;
+}
+
+int EmbeddedUserStore::Register(const std::string& name, const std::string& pwd, const Deadline& deadline) {
+    std::string record;
+    EncodeRecord_(record, name, pwd);
+    std::unique_lock<std::shared_timed_mutex> locker(mutex_);
+    if (slots_[Find_(name, Hash_(name))].hash != 0) {
+        return ALREADY_EXISTS;
+    }
+    // log first, a user is visible only once its record is written
+    off_t offset = lseek(logFd_, 0, SEEK_CUR);
+    if (!WriteAll_(logFd_, record.data(), record.size())) {
+        LOG_ERROR("Write UserStore Log Error: %s", strerror(errno));
+        // cut a partial record, otherwise replay would stop at it and lose the records behind
+        if (ftruncate(logFd_, offset) < 0 || lseek(logFd_, offset, SEEK_SET) < 0) {
+            LOG_ERROR("Truncate UserStore Log %s Error!", logPath_.c_str());
+        }
+        return STORE_ERROR;
+    }
+    Insert_(name, pwd);
+    logRecords_++;
+    logDirty_ = true;
+    return OK;
+}
+
+const char* EmbeddedUserStore::Name() const {
+    return "embedded";
+}
+
+bool EmbeddedUserStore::Snapshot() {
+    std::string tmpPath = snapPath_ + ".tmp";
+    int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        LOG_ERROR("Open UserStore Snapshot %s Error!", tmpPath.c_str());
+        return false;
+    }
+    // registrations need the exclusive lock, 
+    // so the shared lock freezes the table and the log while logins go on
+    std::shared_lock<std::shared_timed_mutex> locker(mutex_);
+    std::string buff;
+    bool ok = true;
+    for (const Slot& slot : slots_) {
+        if (slot.hash == 0) {
+            continue;
+        }
+        EncodeRecord_(buff, slot.name, slot.pwd);
+        if (buff.size() >= 65536) {
+            ok = ok && WriteAll_(fd, buff.data(), buff.size());
+            buff.clear();
+        }
+    }
+    ok = ok && WriteAll_(fd, buff.data(), buff.size()) && fsync(fd) == 0;
+    close(fd);
+    // rename is atomic, a crash leaves either the old or the new snapshot, 
+    // and replaying a log already contained in the snapshot only finds existing users
+    if (!ok || rename(tmpPath.c_str(), snapPath_.c_str()) < 0) {
+        LOG_ERROR("Write UserStore Snapshot %s Error!", snapPath_.c_str());
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    // the rename lives in the directory, until it is synced a crash may bring back the old snapshot,
+    // so the log keeps the records behind it
+    if (!SyncDir_()) {
+        LOG_ERROR("Sync UserStore Dir %s Error: %s", dataDir_.c_str(), strerror(errno));
+        return false;
+    }
+    if (ftruncate(logFd_, 0) < 0 || lseek(logFd_, 0, SEEK_SET) < 0) {
+        LOG_ERROR("Truncate UserStore Log %s Error!", logPath_.c_str());
+        return false;
+    }
+    LOG_INFO("UserStore Snapshot: %d Users", (int)size_);
+    logRecords_ = 0;
+    return true;
+}
+
+size_t EmbeddedUserStore::Size() {
+    std::shared_lock<std::shared_timed_mutex> locker(mutex_);
+    return size_;
+}
+
+size_t EmbeddedUserStore::Find_(const std::string& name, uint64_t hash) const {
+    // slots_.size() is a power of 2, so the mask replaces the modulo
+    size_t mask = slots_.size() - 1;
+    size_t i = hash & mask;
+    while (slots_[i].hash != 0 && (slots_[i].hash != hash || slots_[i].name != name)) {
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+bool EmbeddedUserStore::Insert_(const std::string& name, const std::string& pwd) {
+    uint64_t hash = Hash_(name);
+    size_t i = Find_(name, hash);
+    if (slots_[i].hash != 0) {
+        return false;
+    }
+    slots_[i] = {hash, name, pwd};
+    // keep the load factor below 0.7 so probe sequences stay short
+    if (++size_ * 10 > slots_.size() * 7) {
+        Grow_();
+    }
+    return true;
+}
+
+void EmbeddedUserStore::Grow_() {
+    std::vector<Slot> old(slots_.size() * 2);
+    old.swap(slots_);
+    size_t mask = slots_.size() - 1;
+    for (Slot& slot : old) {
+        if (slot.hash == 0) {
+            continue;
+        }
+        size_t i = slot.hash & mask;
+        while (slots_[i].hash != 0) {
+            i = (i + 1) & mask;
+        }
+        slots_[i] = std::move(slot);
+    }
+}
+
+off_t EmbeddedUserStore::Load_(const std::string& path, bool isSnapshot) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        // nothing has been written yet
+        return errno == ENOENT ? 0 : -1;
+    }
+    std::string data;
+    char buff[65536];
+    ssize_t len;
+    while ((len = read(fd, buff, sizeof(buff))) > 0) {
+        data.append(buff, len);
+    }
+    close(fd);
+    if (len < 0) {
+        LOG_ERROR("Read UserStore File %s Error!", path.c_str());
+        return -1;
+    }
+    size_t pos = 0;
+    while (data.size() - pos >= 12) {
+        uint32_t nameLen, pwdLen, checksum;
+        memcpy(&nameLen, data.data() + pos, 4);
+        memcpy(&pwdLen, data.data() + pos + 4, 4);
+        size_t bodyLen = 8 + static_cast<size_t>(nameLen) + pwdLen;
+        if (data.size() - pos < bodyLen + 4) {
+            break;
+        }
+        memcpy(&checksum, data.data() + pos + bodyLen, 4);
+        if (checksum != Checksum_(data.data() + pos, bodyLen)) {
+            break;
+        }
+        Insert_(data.substr(pos + 8, nameLen), data.substr(pos + 8 + nameLen, pwdLen));
+        if (!isSnapshot) {
+            logRecords_++;
+        }
+        pos += bodyLen + 4;
+    }
+    if (pos != data.size()) {
+        LOG_WARN("UserStore File %s Has %d Invalid Tail Bytes", path.c_str(), (int)(data.size() - pos));
+    }
+    return pos;
+}
+
+void EmbeddedUserStore::SyncLoop_() {
+    auto lastSnapshot = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> locker(syncMutex_);
+    while (!isClose_) {
+        syncCond_.wait_for(locker, std::chrono::milliseconds(SYNC_MS));
+        if (isClose_) {
+            break;
+        }
+        locker.unlock();
+        bool dirty, snapshotDue;
+        {
+            std::unique_lock<std::shared_timed_mutex> tableLocker(mutex_);
+            dirty = logDirty_;
+            logDirty_ = false;
+            snapshotDue = logRecords_ >= SNAPSHOT_RECORDS || (logRecords_ > 0 &&
+                std::chrono::steady_clock::now() - lastSnapshot >= std::chrono::milliseconds(snapshotIntervalMs_));
+        }
+        // a registration is durable at most SYNC_MS after it is acknowledged
+        if (dirty) {
+            fdatasync(logFd_);
+        }
+        if (snapshotDue && Snapshot()) {
+            lastSnapshot = std::chrono::steady_clock::now();
+        }
+        locker.lock();
+    }
+}
+
+bool EmbeddedUserStore::SyncDir_() {
+    int fd = open(dataDir_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = fsync(fd) == 0;
+    int savedErrno = errno;
+    close(fd);
+    errno = savedErrno;
+    return ok;
+}
+
+uint64_t EmbeddedUserStore::Hash_(const std::string& name) const {
+    // the table is rebuilt from the records on Open, so the seed never reaches the disk; 0 marks an empty slot
+    uint64_t h = Hash::Mix64(Hash::Fnv1a64(name.data(), name.size(), seed_));
+    return h == 0 ? 1 : h;
+}
+
+void EmbeddedUserStore::EncodeRecord_(std::string& out, const std::string& name, const std::string& pwd) {
+    size_t start = out.size();
+    uint32_t nameLen = name.size(), pwdLen = pwd.size();
+    out.append(reinterpret_cast<const char*>(&nameLen), 4);
+    out.append(reinterpret_cast<const char*>(&pwdLen), 4);
+    out.append(name);
+    out.append(pwd);
+    uint32_t checksum = Checksum_(out.data() + start, out.size() - start);
+    out.append(reinterpret_cast<const char*>(&checksum), 4);
+}
+
+uint32_t EmbeddedUserStore::Checksum_(const char* data, size_t len) {
+    // FNV-1a 32, enough to detect a torn record
+    return Hash::Fnv1a32(data, len);
+}
+
+bool EmbeddedUserStore::WriteAll_(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        len -= n;
+    }
+    return true;
+}
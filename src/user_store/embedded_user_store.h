@@ -0,0 +1,109 @@
+//
+// Created by pyq on 10/19/26.
+//
+#pragma once
+#ifndef SLIM_WEB_SERVER_EMBEDDED_USER_STORE_H
+#define SLIM_WEB_SERVER_EMBEDDED_USER_STORE_H
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <cstdint>
+#include <random>
+#include <shared_mutex>
+#include <condition_variable>
+#include "user_store.h"
+#include "../log/log.h"
+#include "../hash/hash.h"
+
+// UserStore kept in an open-addressing hash table in memory. 
+// Every registration is appended to a log file, the background thread
+// fdatasyncs the log every second and periodically rewrites the whole table as a snapshot.
+class EmbeddedUserStore : public UserStore {
+public:
+    explicit EmbeddedUserStore(const std::string& dataDir, int snapshotIntervalMs = 60000);
+
+    // Stops the background thread, syncs the log and takes a final snapshot.
+    ~EmbeddedUserStore() override;
+
+    // Loads the snapshot, replays the log and opens it for appending.
+    bool Open();
+
+    // Looks up the user and compares the password, never waits long enough to need the deadline.
+    int Login(const std::string& name, const std::string& pwd, const Deadline& deadline) override;
+
+    // Inserts the user into the table and appends it to the log.
+    int Register(const std::string& name, const std::string& pwd, const Deadline& deadline) override;
+
+    const char* Name() const override;
+
+    // Writes the table to a new snapshot and truncates the log.
+    bool Snapshot();
+
+    // Returns the number of users.
+    size_t Size();
+
+private:
+    // A slot of the hash table.
+    struct Slot {
+        uint64_t hash;          // Hash of the user name, 0 marks an empty slot.
+        std::string name;       // User name.
+        std::string pwd;        // Password.
+    };
+
+    static const size_t INIT_SLOTS = 1024;          // Initial number of slots, always a power of 2.
+    static const size_t SNAPSHOT_RECORDS = 100000;  // Log records that trigger a snapshot before the interval.
+    static const int SYNC_MS = 1000;                // Interval of the log fdatasync.
+
+    std::string dataDir_;                   // Directory of the log and snapshot files.
+    std::string logPath_;                   // Path of the append-only log.
+    std::string snapPath_;                  // Path of the snapshot.
+    int snapshotIntervalMs_;                // Interval of the periodic snapshot.
+    int logFd_;                             // File descriptor of the log.
+    size_t logRecords_;                     // Records appended to the log since the last snapshot.
+    bool logDirty_;                         // True if the log has been written since the last fdatasync.
+    bool isClose_;                          // Flag to stop the background thread.
+    std::vector<Slot> slots_;               // Open-addressing table with linear probing.
+    size_t size_;                           // Number of users in the table.
+    uint64_t seed_;                         // Random seed of the hash, per process.
+    std::shared_timed_mutex mutex_;         // Logins share the table, registrations and snapshots are exclusive.
+    std::mutex syncMutex_;                  // Protects the background thread state.
+    std::condition_variable syncCond_;      // Wakes up the background thread when closing.
+    std::thread syncThread_;                // Thread syncing the log and taking snapshots.
+
+    // Returns the index of the user name's slot, or of the empty slot where it would be inserted.
+    size_t Find_(const std::string& name, uint64_t hash) const;
+
+    // Inserts a user without logging, returns false if the name is taken.
+    bool Insert_(const std::string& name, const std::string& pwd);
+
+    // Doubles the number of slots and rehashes every user.
+    void Grow_();
+
+    // Loads a file of records into the table, returns the offset after the last valid record or -1.
+    off_t Load_(const std::string& path, bool isSnapshot);
+
+    // Syncs the log and takes a snapshot when it is due.
+    void SyncLoop_();
+
+    // Makes the entries of dataDir_ durable, e.g. the rename of a snapshot, returns false on error.
+    bool SyncDir_();
+
+    // Hashes a user name with seed_, never returns 0.
+    uint64_t Hash_(const std::string& name) const;
+
+    // Encodes one record as nameLen, pwdLen, name, pwd and a checksum.
+    static void EncodeRecord_(std::string& out, const std::string& name, const std::string& pwd);
+
+    // Checksum of a record.
+    static uint32_t Checksum_(const char* data, size_t len);
+
+    // Writes all bytes to fd, returns false on error.
+    static bool WriteAll_(int fd, const char* data, size_t len);
+};
+
+#endif //SLIM_WEB_SERVER_EMBEDDED_USER_STORE_H
@@ -0,0 +1,240 @@
+//
+// Created by pyq on 10/19/26.
+//
+#include "mysql_user_store.h"
+
+MysqlUserStore::MysqlUserStore(size_t batchSize, int batchWindowUs) {
+    if (batchSize > 1) {
+        // a batch is one transaction, so it must not span shards
+        for (size_t shard = 0; shard < SqlTopology::Instance()->ShardCount(); ++shard) {
+            batchers_.emplace_back(new RegisterBatcher(
+                std::bind(&MysqlUserStore::FlushRegisters_, shard, std::placeholders::_1), batchSize, batchWindowUs));
+        }
+    }
+}
+
+int MysqlUserStore::Login(const std::string& name, const std::string& pwd, const Deadline& deadline) {
+    // RAII must use named objects. 
+    // anonymous objects will be destructed 
+    // and resources will be released after this line of code is executed.
+    SqlTopology* topology = SqlTopology::Instance();
+    MYSQL* sqlConn;
+    SqlConnPool* connPool = topology->GetReader(topology->GetShard(name), name);
+    SqlConnRAII sqlConnRAII(&sqlConn, connPool, RemainingMs(deadline));
+    if (!sqlConn) {
+        // GetConn timed out, the database is overloaded or unreachable
+        LOG_WARN("No SQL Connection to Verify User %s", name.c_str());
+        return STORE_TIMEOUT;
+    }
+    MYSQL_BIND params[2];
+    unsigned long nameLen, pwdLen;
+    BindParams_(params, name, pwd, &nameLen, &pwdLen);
+
+    std::string password;
+    int ret = Select_(connPool, sqlConn, SqlConnPool::LOGIN_SELECT, params, &password);
+    if (ret != OK) {
+        return ret;
+    }
+    return pwd == password ? OK : WRONG_PASSWORD;
+}
+
+int MysqlUserStore::Register(const std::string& name, const std::string& pwd, const Deadline& deadline) {
+    SqlTopology* topology = SqlTopology::Instance();
+    size_t shard = topology->GetShard(name);
+    int ret;
+    if (!batchers_.empty()) {
+        if (!batchers_[shard]->Submit(name, pwd, deadline, &ret)) {
+            LOG_WARN("Register User %s Timeout in Batch Queue", name.c_str());
+            return STORE_TIMEOUT;
+        }
+    } else {
+        MYSQL* sqlConn;
+        SqlConnPool* connPool = topology->GetPrimary(shard);
+        SqlConnRAII sqlConnRAII(&sqlConn, connPool, RemainingMs(deadline));
+        if (!sqlConn) {
+            LOG_WARN("No SQL Connection to Register User %s", name.c_str());
+            return STORE_TIMEOUT;
+        }
+        ret = RegisterOne_(connPool, sqlConn, name, pwd, deadline);
+    }
+    if (ret == OK) {
+        // the replicas may not have the new row yet
+        topology->OnWrite(name);
+    }
+    return ret;
+}
+
+const char* MysqlUserStore::Name() const {
+    return "mysql";
+}
+
+int MysqlUserStore::RegisterOne_(SqlConnPool* connPool, MYSQL* sqlConn, const std::string& name, const std::string& pwd,
+                                 const Deadline& deadline) {
+    MYSQL_BIND params[2];
+    unsigned long nameLen, pwdLen;
+    BindParams_(params, name, pwd, &nameLen, &pwdLen);
+
+    std::string username;
+    int ret = Select_(connPool, sqlConn, SqlConnPool::REGISTER_SELECT, params, &username);
+    if (ret == OK) {
+        return ALREADY_EXISTS;
+    } else if (ret != NOT_FOUND) {
+        return ret;
+    }
+    // the caller has given up, do not insert a user it will report as failed
+    if (RemainingMs(deadline) == 0) {
+        return STORE_TIMEOUT;
+    }
+    // register user (user name is not been used)
+    // ExecuteStmt logs the error of the statement, the connection has none
+    if (!connPool->ExecuteStmt(sqlConn, SqlConnPool::USER_INSERT, params)) {
+        return STORE_ERROR;
+    }
+    return OK;
+}
+
+void MysqlUserStore::FlushRegisters_(size_t shard, std::vector<RegisterBatcher::Request*>& batch) {
+    MYSQL* sqlConn;
+    SqlConnPool* connPool = SqlTopology::Instance()->GetPrimary(shard);
+    SqlConnRAII sqlConnRAII(&sqlConn, connPool);
+    if (!sqlConn) {
+        LOG_WARN("No SQL Connection to Register %d Users", (int)batch.size());
+        for (auto request : batch) {
+            request->result = STORE_ERROR;
+        }
+        return;
+    }
+    LOG_DEBUG("Register Batch: %d Users, Shard: %d", (int)batch.size(), (int)shard);
+    if (batch.size() > 1 && InsertBatch_(connPool, sqlConn, batch)) {
+        return;
+    }
+    // a single row needs no transaction, 
+    // and a failed batch is retried row by row to find out which rows conflict
+    for (auto request : batch) {
+        request->result = RegisterOne_(connPool, sqlConn, request->name, request->pwd, request->deadline);
+    }
+}
+
+bool MysqlUserStore::InsertBatch_(SqlConnPool* connPool, MYSQL* sqlConn, std::vector<RegisterBatcher::Request*>& batch) {
+    // the statement shape depends on the batch size, so the batch is sent as text 
+    // with every value escaped by mysql_real_escape_string
+    std::string select = "SELECT username FROM user WHERE username IN (";
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (i > 0) {
+            select += ",";
+        }
+        AppendQuoted_(sqlConn, select, batch[i]->name);
+    }
+    // FOR UPDATE locks the selected rows and gaps until commit, 
+    // so no concurrent insert can slip in between the SELECT and the INSERT
+    select += ") FOR UPDATE";
+
+    if (mysql_autocommit(sqlConn, false) || mysql_query(sqlConn, select.c_str())) {
+        LOG_ERROR("SQL Batch Select Error: %s", mysql_error(sqlConn));
+    } else {
+        std::unordered_set<std::string> taken;
+        MYSQL_RES* res = mysql_store_result(sqlConn);
+        if (res) {
+            MYSQL_ROW row;
+            while ((row = mysql_fetch_row(res))) {
+                taken.insert(row[0]);
+            }
+            mysql_free_result(res);
+        }
+        // the first request of a name in the batch wins, the later ones are duplicates
+        std::string insert = "INSERT INTO user(username, password) VALUES ";
+        int rows = 0;
+        for (auto request : batch) {
+            if (!taken.insert(request->name).second) {
+                request->result = ALREADY_EXISTS;
+                continue;
+            }
+            request->result = OK;
+            insert += rows++ > 0 ? ",(" : "(";
+            AppendQuoted_(sqlConn, insert, request->name);
+            insert += ",";
+            AppendQuoted_(sqlConn, insert, request->pwd);
+            insert += ")";
+        }
+        if (rows > 0 && mysql_query(sqlConn, insert.c_str())) {
+            // ER_DUP_ENTRY here means the collation matched a name the exact comparison did not
+            LOG_WARN("SQL Batch Insert Error: %s", mysql_error(sqlConn));
+        } else if (mysql_commit(sqlConn)) {
+            LOG_ERROR("SQL Batch Commit Error: %s", mysql_error(sqlConn));
+        } else {
+            mysql_autocommit(sqlConn, true);
+            return true;
+        }
+    }
+    unsigned int err = mysql_errno(sqlConn);
+    mysql_rollback(sqlConn);
+    mysql_autocommit(sqlConn, true);
+    if (err == CR_SERVER_GONE_ERROR || err == CR_SERVER_LOST) {
+        connPool->Reconnect(sqlConn);
+    }
+    return false;
+}
+
+void MysqlUserStore::AppendQuoted_(MYSQL* sqlConn, std::string& sql, const std::string& str) {
+    // an escaped string is at most twice as long plus the terminating null
+    std::vector<char> escaped(str.size() * 2 + 1);
+    unsigned long len = mysql_real_escape_string(sqlConn, escaped.data(), str.data(), str.size());
+    sql += "'";
+    sql.append(escaped.data(), len);
+    sql += "'";
+}
+
+int MysqlUserStore::Select_(SqlConnPool* connPool, MYSQL* sqlConn, SqlConnPool::STMT_ID id,
+                            MYSQL_BIND* params, std::string* field) {
+    LOG_DEBUG("SQL Stmt: %d", id);
+    MYSQL_STMT* stmt = connPool->ExecuteStmt(sqlConn, id, params);
+    if (!stmt) {
+        return STORE_ERROR;
+    }
+    // the selected column is written into buff of the result bind
+    char buff[256] = {0};
+    unsigned long buffLen = 0;
+    MYSQL_BIND result;
+    memset(&result, 0, sizeof(result));
+    result.buffer_type = MYSQL_TYPE_STRING;
+    result.buffer = buff;
+    result.buffer_length = sizeof(buff);
+    result.length = &buffLen;
+    if (mysql_stmt_bind_result(stmt, &result) || mysql_stmt_store_result(stmt)) {
+        LOG_ERROR("SQL Error: %s", mysql_stmt_error(stmt));
+        mysql_stmt_free_result(stmt);
+        return STORE_ERROR;
+    }
+    // MYSQL_DATA_TRUNCATED still means a row is found, 
+    // but the column is longer than buff and can not match anything we compare it with
+    int fetchRet = mysql_stmt_fetch(stmt);
+    mysql_stmt_free_result(stmt);
+    if (fetchRet == 0) {
+        field->assign(buff, buffLen);
+        return OK;
+    } else if (fetchRet == MYSQL_DATA_TRUNCATED) {
+        field->clear();
+        return OK;
+    } else if (fetchRet == MYSQL_NO_DATA) {
+        return NOT_FOUND;
+    }
+    LOG_ERROR("SQL Fetch Error: %s", mysql_stmt_error(stmt));
+    return STORE_ERROR;
+}
+
+void MysqlUserStore::BindParams_(MYSQL_BIND* params, const std::string& name, const std::string& pwd,
+                                 unsigned long* nameLen, unsigned long* pwdLen) {
+    // bind the user name as the "?" parameter of the cached statement 
+    // instead of splicing it into the SQL text
+    memset(params, 0, sizeof(MYSQL_BIND) * 2);
+    *nameLen = name.size();
+    *pwdLen = pwd.size();
+    params[0].buffer_type = MYSQL_TYPE_STRING;
+    params[0].buffer = const_cast<char*>(name.data());
+    params[0].buffer_length = *nameLen;
+    params[0].length = nameLen;
+    params[1].buffer_type = MYSQL_TYPE_STRING;
+    params[1].buffer = const_cast<char*>(pwd.data());
+    params[1].buffer_length = *pwdLen;
+    params[1].length = pwdLen;
+}
@@ -0,0 +1,65 @@
+//
+// Created by pyq on 10/19/26.
+//
+#pragma once
+#ifndef SLIM_WEB_SERVER_MYSQL_USER_STORE_H
+#define SLIM_WEB_SERVER_MYSQL_USER_STORE_H
+
+#include <cstring>
+#include <memory>
+#include <unordered_set>
+#include <mysql/mysql.h>
+#include "user_store.h"
+#include "register_batcher.h"
+#include "../log/log.h"
+#include "../sql_connect/sql_connect.h"
+#include "../sql_connect/sql_connect_raii.h"
+#include "../sql_connect/sql_topology.h"
+
+// UserStore backed by the MySQL user table, using the prepared statements cached by SqlConnPool.
+// Users are routed by SqlTopology: logins read from a replica of the user's shard, registrations write to its primary.
+class MysqlUserStore : public UserStore {
+public:
+    // Registrations are group committed per shard in batches of up to batchSize rows, 
+    // batchSize 1 keeps one SELECT and INSERT per registration.
+    explicit MysqlUserStore(size_t batchSize = 64, int batchWindowUs = 2000);
+
+    ~MysqlUserStore() override = default;
+
+    // Selects the password of the user and compares it.
+    int Login(const std::string& name, const std::string& pwd, const Deadline& deadline) override;
+
+    // Inserts the user if it is not taken, through the batcher if enabled.
+    int Register(const std::string& name, const std::string& pwd, const Deadline& deadline) override;
+
+    const char* Name() const override;
+
+private:
+    std::vector<std::unique_ptr<RegisterBatcher>> batchers_;  // Group commit queue of each shard, empty if disabled.
+
+    // Selects the user name and inserts the user if it is not taken, one row at a time.
+    // Gives up before the INSERT if the deadline has passed.
+    static int RegisterOne_(SqlConnPool* connPool, MYSQL* sqlConn, const std::string& name, const std::string& pwd,
+                            const Deadline& deadline);
+
+    // Writes a batch of registrations to the primary of a shard and sets the result of every row.
+    static void FlushRegisters_(size_t shard, std::vector<RegisterBatcher::Request*>& batch);
+
+    // Writes a batch as one multi-row INSERT in a single transaction. 
+    // Returns false (and rolls back) on any error, including a duplicate the SELECT did not see.
+    static bool InsertBatch_(SqlConnPool* connPool, MYSQL* sqlConn, std::vector<RegisterBatcher::Request*>& batch);
+
+    // Appends str to sql as an escaped and quoted string literal.
+    static void AppendQuoted_(MYSQL* sqlConn, std::string& sql, const std::string& str);
+
+    // Runs a select statement bound to name and pwd, copies the selected column into field.
+    // Returns OK if a row is found, NOT_FOUND if not and STORE_ERROR on failure.
+    static int Select_(SqlConnPool* connPool, MYSQL* sqlConn, SqlConnPool::STMT_ID id,
+                       MYSQL_BIND* params, std::string* field);
+
+    // Binds name and pwd as the "?" parameters of the cached statements.
+    static void BindParams_(MYSQL_BIND* params, const std::string& name, const std::string& pwd,
+                            unsigned long* nameLen, unsigned long* pwdLen);
+};
+
+#endif //SLIM_WEB_SERVER_MYSQL_USER_STORE_H
@@ -0,0 +1,76 @@
+//
+// Created by pyq on 10/19/26.
+//
+#include "register_batcher.h"
+
+RegisterBatcher::RegisterBatcher(const FlushCallBack& flush, size_t maxBatch, int windowUs) :
+    flush_(flush), maxBatch_(maxBatch), window_(windowUs), isClose_(false) {
+    assert(flush_ && maxBatch_ > 0 && windowUs >= 0);
+    thread_ = std::thread(&RegisterBatcher::Loop_, this);
+}
+
+RegisterBatcher::~RegisterBatcher() {
+    {
+        std::lock_guard<std::mutex> locker(mutex_);
+        isClose_ = true;
+    }
+    cond_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+bool RegisterBatcher::Submit(const std::string& name, const std::string& pwd,
+                             const std::chrono::steady_clock::time_point& deadline, int* result) {
+    assert(result);
+    // the request lives on the stack of the submitter until its batch is done
+    Request request = {name, pwd, deadline, -1, false, false};
+    std::unique_lock<std::mutex> locker(mutex_);
+    assert(!isClose_);
+    pending_.push_back(&request);
+    if (pending_.size() == 1 || pending_.size() >= maxBatch_) {
+        cond_.notify_one();
+    }
+    if (!doneCond_.wait_until(locker, deadline, [&request] { return request.done; }) && !request.taken) {
+        pending_.erase(std::find(pending_.begin(), pending_.end(), &request));
+        return false;
+    }
+    doneCond_.wait(locker, [&request] { return request.done; });
+    *result = request.result;
+    return true;
+}
+
+void RegisterBatcher::Loop_() {
+    std::vector<Request*> batch;
+    std::unique_lock<std::mutex> locker(mutex_);
+    while (true) {
+        cond_.wait(locker, [this] { return isClose_ || !pending_.empty(); });
+        if (pending_.empty()) {
+            // closed and nothing left to flush
+            break;
+        }
+        // give the others a short window to join the batch, 
+        // requests arriving while a batch is flushed are grouped into the next one anyway
+        auto deadline = std::chrono::steady_clock::now() + window_;
+        cond_.wait_until(locker, deadline, [this] { return isClose_ || pending_.size() >= maxBatch_; });
+        if (pending_.empty()) {
+            // every request has been withdrawn at its deadline
+            continue;
+        }
+        size_t n = std::min(pending_.size(), maxBatch_);
+        batch.assign(pending_.begin(), pending_.begin() + n);
+        pending_.erase(pending_.begin(), pending_.begin() + n);
+        for (Request* request : batch) {
+            request->taken = true;
+        }
+        locker.unlock();
+
+        flush_(batch);
+
+        locker.lock();
+        for (Request* request : batch) {
+            request->done = true;
+        }
+        doneCond_.notify_all();
+    }
+}
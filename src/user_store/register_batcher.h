@@ -0,0 +1,61 @@
+//
+// Created by pyq on 10/19/26.
+//
+#pragma once
+#ifndef SLIM_WEB_SERVER_REGISTER_BATCHER_H
+#define SLIM_WEB_SERVER_REGISTER_BATCHER_H
+
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cassert>
+#include <algorithm>
+#include <functional>
+#include <condition_variable>
+
+// Group commit queue for registrations. 
+// Requests submitted by the worker threads are collected for up to windowUs or maxBatch rows
+// and handed to the flush callback as one batch, each submitter then wakes up with its own result.
+class RegisterBatcher {
+public:
+    // A registration waiting in the queue.
+    struct Request {
+        std::string name;   // User name.
+        std::string pwd;    // Password.
+        std::chrono::steady_clock::time_point deadline;    // Deadline of the submitter.
+        int result;         // UserStore::RESULT of this row, set by the flush callback.
+        bool taken;         // True once the request has been taken into a batch.
+        bool done;          // True once the batch containing this request has been flushed.
+    };
+
+    using FlushCallBack = std::function<void(std::vector<Request*>& batch)>;
+
+    RegisterBatcher(const FlushCallBack& flush, size_t maxBatch = 64, int windowUs = 2000);
+
+    // Flushes the pending requests and stops the batch thread.
+    ~RegisterBatcher();
+
+    // Queues a registration and blocks until its batch is flushed, the result is stored in *result.
+    // Returns false if the deadline passed before the request was taken into a batch, it is then withdrawn.
+    // A request already taken is always waited for, its flush is bounded by the query timeouts.
+    bool Submit(const std::string& name, const std::string& pwd,
+                const std::chrono::steady_clock::time_point& deadline, int* result);
+
+private:
+    FlushCallBack flush_;               // Writes a batch and sets the result of every request.
+    size_t maxBatch_;                   // Maximum number of rows of a batch.
+    std::chrono::microseconds window_;  // How long the first request of a batch waits for others.
+    bool isClose_;                      // Flag to stop the batch thread.
+    std::vector<Request*> pending_;     // Requests waiting for the next batch.
+    std::mutex mutex_;                  // Mutex protecting pending_ and the done flags.
+    std::condition_variable cond_;      // Wakes up the batch thread.
+    std::condition_variable doneCond_;  // Wakes up the submitters after a flush.
+    std::thread thread_;                // Thread collecting and flushing batches.
+
+    // Collects batches and flushes them until closed.
+    void Loop_();
+};
+
+#endif //SLIM_WEB_SERVER_REGISTER_BATCHER_H
@@ -0,0 +1,47 @@
+//
+// Created by pyq on 10/19/26.
+//
+#include "user_store.h"
+#include "mysql_user_store.h"
+#include "embedded_user_store.h"
+
+bool UserStore::Init(int backend, const char* dataDir) {
+    std::unique_ptr<UserStore>& holder = Holder_();
+    if (backend == EMBEDDED_BACKEND) {
+        std::unique_ptr<EmbeddedUserStore> store(new EmbeddedUserStore(dataDir));
+        if (!store->Open()) {
+            LOG_ERROR("Open Embedded UserStore at %s Error!", dataDir);
+            return false;
+        }
+        holder = std::move(store);
+    } else {
+        // SqlConnPool is initialized by the caller
+        holder.reset(new MysqlUserStore());
+    }
+    LOG_INFO("UserStore Backend: %s", holder->Name());
+    return true;
+}
+
+UserStore* UserStore::Instance() {
+    return Holder_().get();
+}
+
+void UserStore::Close() {
+    Holder_().reset();
+}
+
+CircuitBreaker* UserStore::Breaker() {
+    // 5 consecutive failures or timeouts open the breaker for 5s, 3 successful probes close it
+    static CircuitBreaker breaker(5, 5000, 3);
+    return &breaker;
+}
+
+int UserStore::RemainingMs(const Deadline& deadline) {
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+    return remaining.count() > 0 ? static_cast<int>(remaining.count()) : 0;
+}
+
+std::unique_ptr<UserStore>& UserStore::Holder_() {
+    static std::unique_ptr<UserStore> holder;
+    return holder;
+}
@@ -0,0 +1,67 @@
+//
+// Created by pyq on 10/19/26.
+//
+#pragma once
+#ifndef SLIM_WEB_SERVER_USER_STORE_H
+#define SLIM_WEB_SERVER_USER_STORE_H
+
+#include <string>
+#include <memory>
+#include <chrono>
+#include "../circuit_breaker/circuit_breaker.h"
+
+// Abstract storage of user accounts used by the login and register requests.
+// The backend is selected once at startup by Init and reached through Instance.
+class UserStore {
+public:
+    using Deadline = std::chrono::steady_clock::time_point;
+
+    // Enumerates the available backends.
+    enum BACKEND {
+        MYSQL_BACKEND = 0,  // Users are stored in the MySQL user table through SqlConnPool.
+        EMBEDDED_BACKEND,   // Users are stored in memory, made durable by an append-only log and snapshots.
+    };
+
+    // Enumerates the results of Login and Register.
+    enum RESULT {
+        OK = 0,
+        NOT_FOUND,
+        WRONG_PASSWORD,
+        ALREADY_EXISTS,
+        STORE_ERROR,        // The backend failed.
+        STORE_TIMEOUT,      // The deadline passed before the backend answered.
+        STORE_UNAVAILABLE,  // The circuit breaker is open, the backend was not called.
+    };
+
+    // Creates and opens the selected backend, dataDir is used by the embedded backend.
+    static bool Init(int backend, const char* dataDir = "./data");
+
+    // Returns the active backend, nullptr before Init.
+    static UserStore* Instance();
+
+    // Closes and destroys the active backend.
+    static void Close();
+
+    // Returns the circuit breaker guarding the backend.
+    static CircuitBreaker* Breaker();
+
+    // Returns the milliseconds left until the deadline, 0 if it has passed.
+    static int RemainingMs(const Deadline& deadline);
+
+    virtual ~UserStore() = default;
+
+    // Checks the password of an existing user, gives up with STORE_TIMEOUT at the deadline.
+    virtual int Login(const std::string& name, const std::string& pwd, const Deadline& deadline) = 0;
+
+    // Adds a new user if the name is not taken, gives up with STORE_TIMEOUT at the deadline.
+    virtual int Register(const std::string& name, const std::string& pwd, const Deadline& deadline) = 0;
+
+    // Returns the name of the backend.
+    virtual const char* Name() const = 0;
+
+private:
+    // Returns the holder of the active backend.
+    static std::unique_ptr<UserStore>& Holder_();
+};
+
+#endif //SLIM_WEB_SERVER_USER_STORE_H